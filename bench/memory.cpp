@@ -0,0 +1,86 @@
+#include "memory.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace shape::bench;
+
+namespace
+{
+
+/**
+ * Size of the header stored in front of each allocated block to remember
+ * its size. It is a multiple of the fundamental alignment so that the
+ * returned pointer keeps the alignment guaranteed by malloc.
+ */
+constexpr std::size_t header_size = 16;
+
+std::atomic<std::size_t> current_memory_(0);
+std::atomic<std::size_t> peak_memory_(0);
+std::atomic<int64_t> number_of_allocations_(0);
+
+void* allocate(std::size_t size) noexcept
+{
+    void* block = std::malloc(size + header_size);
+    if (block == nullptr)
+        return nullptr;
+    *static_cast<std::size_t*>(block) = size;
+    number_of_allocations_.fetch_add(1, std::memory_order_relaxed);
+    std::size_t current = current_memory_.fetch_add(size, std::memory_order_relaxed) + size;
+    std::size_t peak = peak_memory_.load(std::memory_order_relaxed);
+    while (current > peak
+            && !peak_memory_.compare_exchange_weak(peak, current, std::memory_order_relaxed)) { }
+    return static_cast<char*>(block) + header_size;
+}
+
+void deallocate(void* pointer) noexcept
+{
+    if (pointer == nullptr)
+        return;
+    void* block = static_cast<char*>(pointer) - header_size;
+    current_memory_.fetch_sub(*static_cast<std::size_t*>(block), std::memory_order_relaxed);
+    std::free(block);
+}
+
+void* allocate_or_throw(std::size_t size)
+{
+    void* pointer = allocate(size);
+    if (pointer == nullptr)
+        throw std::bad_alloc();
+    return pointer;
+}
+
+}
+
+std::size_t shape::bench::current_memory()
+{
+    return current_memory_.load(std::memory_order_relaxed);
+}
+
+std::size_t shape::bench::peak_memory()
+{
+    return peak_memory_.load(std::memory_order_relaxed);
+}
+
+void shape::bench::reset_peak_memory()
+{
+    peak_memory_.store(current_memory_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+int64_t shape::bench::number_of_allocations()
+{
+    return number_of_allocations_.load(std::memory_order_relaxed);
+}
+
+void* operator new(std::size_t size) { return allocate_or_throw(size); }
+void* operator new[](std::size_t size) { return allocate_or_throw(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+
+void operator delete(void* pointer) noexcept { deallocate(pointer); }
+void operator delete[](void* pointer) noexcept { deallocate(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { deallocate(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { deallocate(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { deallocate(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { deallocate(pointer); }
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace shape
+{
+namespace bench
+{
+
+/**
+ * Heap usage tracking for the benchmark executables.
+ *
+ * The global allocation functions are replaced in memory.cpp so that every
+ * allocation performed by the library is accounted for, independently of
+ * the platform.
+ */
+
+/** Number of bytes currently allocated. */
+std::size_t current_memory();
+
+/** Largest number of bytes allocated since the last reset. */
+std::size_t peak_memory();
+
+/** Reset the peak memory to the current memory. */
+void reset_peak_memory();
+
+/** Number of allocations performed since the start of the program. */
+int64_t number_of_allocations();
+
+}
+}
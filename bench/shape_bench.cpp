@@ -0,0 +1,699 @@
+#include "memory.hpp"
+#include "workloads.hpp"
+
+#include "shape/boolean_operations.hpp"
+#include "shape/offset.hpp"
+#include "shape/no_fit_polygon.hpp"
+#include "shape/rasterization.hpp"
+#include "shape/simplification.hpp"
+#include "shape/trapezoidation.hpp"
+#include "shape/convex_partition.hpp"
+#include "shape/intersection_tree.hpp"
+#include "shape/dynamic_intersection_tree.hpp"
+#include "shape/point_locator.hpp"
+#include "shape/ring.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+
+using namespace shape;
+using namespace shape::bench;
+
+namespace
+{
+
+struct BenchmarkCase
+{
+    /** Number of elements of the input. */
+    ElementPos number_of_elements = 0;
+
+    /** Function to time. */
+    std::function<void()> run;
+};
+
+struct Benchmark
+{
+    /** Name of the benchmark. */
+    std::string name;
+
+    /**
+     * Build the input of the benchmark for a requested number of elements.
+     *
+     * The actual number of elements might slightly differ from the
+     * requested one.
+     */
+    std::function<BenchmarkCase(ElementPos)> build;
+};
+
+/** Sink preventing the compiler from removing the timed calls. */
+volatile std::size_t sink = 0;
+
+/**
+ * Empty inputs for the intersection trees built on elements only.
+ *
+ * IntersectionTree keeps pointers to its inputs, so they must outlive it.
+ */
+const std::vector<ShapeWithHoles> no_shapes;
+const std::vector<Point> no_points;
+
+std::vector<Benchmark> build_benchmarks()
+{
+    std::vector<Benchmark> benchmarks;
+
+    benchmarks.push_back({"compute_union", [](ElementPos number_of_elements) {
+        auto shapes = std::make_shared<std::vector<ShapeWithHoles>>(
+                build_overlapping_rounded_rectangles(number_of_elements));
+        return BenchmarkCase{8 * (ElementPos)shapes->size(), [shapes]() {
+            sink += compute_union(*shapes).shapes_with_holes.size();
+        }};
+    }});
+
+    benchmarks.push_back({"compute_union_dense", [](ElementPos number_of_elements) {
+        std::mt19937_64 generator(0);
+        auto shapes = std::make_shared<std::vector<ShapeWithHoles>>(
+                build_dense_rounded_rectangles(number_of_elements, generator));
+        return BenchmarkCase{8 * (ElementPos)shapes->size(), [shapes]() {
+            sink += compute_union(*shapes).shapes_with_holes.size();
+        }};
+    }});
+
+    benchmarks.push_back({"compute_union_dense_cascaded", [](ElementPos number_of_elements) {
+        std::mt19937_64 generator(0);
+        auto shapes = std::make_shared<std::vector<ShapeWithHoles>>(
+                build_dense_rounded_rectangles(number_of_elements, generator));
+        return BenchmarkCase{8 * (ElementPos)shapes->size(), [shapes]() {
+            BooleanOperationParameters parameters;
+            parameters.cascaded_union_group_size = 64;
+            sink += compute_union(*shapes, parameters).shapes_with_holes.size();
+        }};
+    }});
+
+    benchmarks.push_back({"union_accumulator", [](ElementPos number_of_elements) {
+        std::mt19937_64 generator(0);
+        auto shapes = std::make_shared<std::vector<ShapeWithHoles>>(
+                build_dense_rounded_rectangles(number_of_elements, generator));
+        return BenchmarkCase{8 * (ElementPos)shapes->size(), [shapes]() {
+            UnionAccumulator union_accumulator;
+            for (const ShapeWithHoles& shape: *shapes)
+                union_accumulator.add(shape);
+            sink += union_accumulator.result().shapes_with_holes.size();
+        }};
+    }});
+
+    benchmarks.push_back({"compute_intersection", [](ElementPos number_of_elements) {
+        ElementPos number_of_teeth = (std::max)((ElementPos)2, number_of_elements / 8);
+        auto shapes = std::make_shared<std::vector<ShapeWithHoles>>();
+        shapes->push_back({build_gear(number_of_teeth, 90, 100)});
+        shapes->push_back({build_gear(number_of_teeth, 85, 95, M_PI / (4 * number_of_teeth))});
+        return BenchmarkCase{8 * number_of_teeth, [shapes]() {
+            sink += compute_intersection(*shapes).shapes_with_holes.size();
+        }};
+    }});
+
+    benchmarks.push_back({"compute_intersection_area", [](ElementPos number_of_elements) {
+        ElementPos number_of_teeth = (std::max)((ElementPos)2, number_of_elements / 8);
+        auto shapes = std::make_shared<std::vector<ShapeWithHoles>>();
+        shapes->push_back({build_gear(number_of_teeth, 90, 100)});
+        shapes->push_back({build_gear(number_of_teeth, 85, 95, M_PI / (4 * number_of_teeth))});
+        return BenchmarkCase{8 * number_of_teeth, [shapes]() {
+            sink += (std::size_t)compute_intersection_area((*shapes)[0], (*shapes)[1]);
+        }};
+    }});
+
+    benchmarks.push_back({"compute_difference", [](ElementPos number_of_elements) {
+        ElementPos number_of_teeth = (std::max)((ElementPos)2, number_of_elements / 8);
+        auto shape_1 = std::make_shared<ShapeWithHoles>(
+                ShapeWithHoles{build_gear(number_of_teeth, 90, 100)});
+        auto shape_2 = std::make_shared<ShapeWithHoles>(
+                ShapeWithHoles{build_gear(number_of_teeth, 85, 95, M_PI / (4 * number_of_teeth))});
+        return BenchmarkCase{8 * number_of_teeth, [shape_1, shape_2]() {
+            sink += compute_difference(*shape_1, *shape_2).shapes_with_holes.size();
+        }};
+    }});
+
+    benchmarks.push_back({"compute_difference_bin", [](ElementPos number_of_elements) {
+        auto bin = std::make_shared<ShapeWithHoles>(
+                build_bin_with_holes(number_of_elements));
+        auto item = std::make_shared<ShapeWithHoles>(
+                ShapeWithHoles{build_rounded_rectangle(12, 12, 16, 16, 3)});
+        return BenchmarkCase{4 + 8 * (ElementPos)bin->holes.size(), [bin, item]() {
+            sink += compute_difference(*bin, *item).shapes_with_holes.size();
+        }};
+    }});
+
+    benchmarks.push_back({"compute_difference_prepared_bin", [](ElementPos number_of_elements) {
+        auto bin = std::make_shared<PreparedShape>(
+                build_bin_with_holes(number_of_elements));
+        auto item = std::make_shared<ShapeWithHoles>(
+                ShapeWithHoles{build_rounded_rectangle(12, 12, 16, 16, 3)});
+        return BenchmarkCase{4 + 8 * (ElementPos)bin->shape().holes.size(), [bin, item]() {
+            sink += compute_difference(*bin, *item).shapes_with_holes.size();
+        }};
+    }});
+
+    benchmarks.push_back({"inflate", [](ElementPos number_of_elements) {
+        ElementPos number_of_teeth = (std::max)((ElementPos)2, number_of_elements / 4);
+        auto shape = std::make_shared<ShapeWithHoles>(
+                ShapeWithHoles{build_gear(number_of_teeth, 90, 100)});
+        return BenchmarkCase{4 * number_of_teeth, [shape]() {
+            sink += inflate(*shape, 1.0).shape.elements.size();
+        }};
+    }});
+
+    benchmarks.push_back({"deflate", [](ElementPos number_of_elements) {
+        ElementPos number_of_teeth = (std::max)((ElementPos)2, number_of_elements / 4);
+        auto shape = std::make_shared<Shape>(build_gear(number_of_teeth, 90, 100));
+        return BenchmarkCase{4 * number_of_teeth, [shape]() {
+            sink += deflate(*shape, 0.1).size();
+        }};
+    }});
+
+    benchmarks.push_back({"no_fit_polygon_convex", [](ElementPos number_of_elements) {
+        ElementPos number_of_vertices = (std::max)((ElementPos)3, number_of_elements / 4);
+        auto fixed_shape = std::make_shared<Shape>(
+                build_rounded_regular_polygon(number_of_vertices, 100, 2));
+        auto orbiting_shape = std::make_shared<Shape>(
+                build_rounded_regular_polygon(number_of_vertices + 1, 50, 3, 0.1));
+        return BenchmarkCase{4 * number_of_vertices + 2, [fixed_shape, orbiting_shape]() {
+            sink += no_fit_polygon(*fixed_shape, *orbiting_shape).elements.size();
+        }};
+    }});
+
+    benchmarks.push_back({"no_fit_polygon_general", [](ElementPos number_of_elements) {
+        ElementPos number_of_teeth = (std::max)((ElementPos)3, number_of_elements / 8);
+        auto fixed_shape = std::make_shared<ShapeWithHoles>(
+                ShapeWithHoles{build_gear(number_of_teeth, 90, 100)});
+        auto orbiting_shape = std::make_shared<ShapeWithHoles>(
+                ShapeWithHoles{build_gear(number_of_teeth, 40, 50)});
+        return BenchmarkCase{8 * number_of_teeth, [fixed_shape, orbiting_shape]() {
+            sink += no_fit_polygon(*fixed_shape, *orbiting_shape).shapes_with_holes.size();
+        }};
+    }});
+
+    benchmarks.push_back({"rasterization", [](ElementPos number_of_elements) {
+        ElementPos number_of_teeth = (std::max)((ElementPos)2, number_of_elements / 4);
+        auto shape = std::make_shared<ShapeWithHoles>(
+                ShapeWithHoles{build_gear(number_of_teeth, 90, 100)});
+        LengthDbl cell_size = 200.0 / std::sqrt((double)(4 * number_of_teeth));
+        return BenchmarkCase{4 * number_of_teeth, [shape, cell_size]() {
+            sink += rasterization(*shape, cell_size, cell_size).cells.size();
+        }};
+    }});
+
+    benchmarks.push_back({"simplify", [](ElementPos number_of_elements) {
+        ElementPos number_of_teeth = (std::max)((ElementPos)2, number_of_elements / 16);
+        auto shapes = std::make_shared<std::vector<SimplifyInputShape>>();
+        for (ElementPos shape_pos = 0; shape_pos < 4; ++shape_pos) {
+            SimplifyInputShape simplify_input_shape;
+            simplify_input_shape.shape = {build_gear(number_of_teeth, 90, 100, 0.1 * shape_pos, {0, 0}, false)};
+            simplify_input_shape.copies = shape_pos + 1;
+            shapes->push_back(simplify_input_shape);
+        }
+        return BenchmarkCase{16 * number_of_teeth, [shapes]() {
+            sink += simplify(*shapes, 1000.0).size();
+        }};
+    }});
+
+    benchmarks.push_back({"trapezoidation", [](ElementPos number_of_elements) {
+        ElementPos number_of_teeth = (std::max)((ElementPos)2, number_of_elements / 4);
+        auto shape = std::make_shared<ShapeWithHoles>(
+                ShapeWithHoles{build_gear(number_of_teeth, 90, 100, 0.0, {0, 0}, false)});
+        shape->holes.push_back(build_rectangle(-20, 20, -20, 20));
+        return BenchmarkCase{4 * number_of_teeth + 4, [shape]() {
+            sink += trapezoidation(*shape).size();
+        }};
+    }});
+
+    benchmarks.push_back({"compute_convex_partition", [](ElementPos number_of_elements) {
+        ElementPos number_of_teeth = (std::max)((ElementPos)2, number_of_elements / 4);
+        auto shape = std::make_shared<ShapeWithHoles>(
+                ShapeWithHoles{build_gear(number_of_teeth, 90, 100, 0.0, {0, 0}, false)});
+        shape->holes.push_back(build_rectangle(-20, 20, -20, 20));
+        return BenchmarkCase{4 * number_of_teeth + 4, [shape]() {
+            sink += compute_convex_partition(*shape).size();
+        }};
+    }});
+
+    benchmarks.push_back({"intersect_elements", [](ElementPos number_of_elements) {
+        std::mt19937_64 generator(0);
+        auto elements = std::make_shared<std::vector<ShapeElement>>(
+                build_random_elements(number_of_elements, generator));
+        return BenchmarkCase{number_of_elements, [elements]() {
+            // Each element against its next neighbors, most of which are
+            // disjoint from it.
+            for (ElementPos pos_1 = 0; pos_1 < (ElementPos)elements->size(); ++pos_1) {
+                for (ElementPos pos_2 = pos_1 + 1;
+                        pos_2 < (std::min)((ElementPos)elements->size(), pos_1 + 16);
+                        ++pos_2) {
+                    sink += intersect((*elements)[pos_1], (*elements)[pos_2]);
+                    sink += intersect((*elements)[pos_1], (*elements)[pos_2], true);
+                }
+            }
+        }};
+    }});
+
+    benchmarks.push_back({"intersect_shape_shape", [](ElementPos number_of_elements) {
+        ElementPos number_of_teeth = (std::max)((ElementPos)3, number_of_elements / 8);
+        // A gear inside another one, so that every pair of elements has to
+        // be checked.
+        auto shape_1 = std::make_shared<Shape>(build_gear(number_of_teeth, 90, 100));
+        auto shape_2 = std::make_shared<Shape>(build_gear(number_of_teeth, 70, 80));
+        return BenchmarkCase{8 * number_of_teeth, [shape_1, shape_2]() {
+            sink += intersect(*shape_1, *shape_2, false);
+            sink += intersect(*shape_1, *shape_2, true);
+        }};
+    }});
+
+    benchmarks.push_back({"intersect_shapes_pairs", [](ElementPos number_of_elements) {
+        // Rounded polygons on a row, each one overlapping its neighbours.
+        ShapePos number_of_shapes = (std::max)((ShapePos)2, number_of_elements / 16);
+        auto shapes = std::make_shared<std::vector<Shape>>();
+        for (ShapePos shape_pos = 0; shape_pos < number_of_shapes; ++shape_pos) {
+            Shape shape = build_rounded_regular_polygon(8, 10, 1);
+            shape.shift(15 * shape_pos, 0);
+            shapes->push_back(shape);
+        }
+        return BenchmarkCase{16 * number_of_shapes, [shapes]() {
+            for (ShapePos shape_pos_1 = 0; shape_pos_1 < (ShapePos)shapes->size(); ++shape_pos_1)
+                for (ShapePos shape_pos_2 = shape_pos_1 + 1; shape_pos_2 < (ShapePos)shapes->size(); ++shape_pos_2)
+                    sink += intersect((*shapes)[shape_pos_1], (*shapes)[shape_pos_2], true);
+        }};
+    }});
+
+    benchmarks.push_back({"intersect_cached_shapes_pairs", [](ElementPos number_of_elements) {
+        ShapePos number_of_shapes = (std::max)((ShapePos)2, number_of_elements / 16);
+        auto shapes = std::make_shared<std::vector<CachedShape>>();
+        for (ShapePos shape_pos = 0; shape_pos < number_of_shapes; ++shape_pos) {
+            Shape shape = build_rounded_regular_polygon(8, 10, 1);
+            shape.shift(15 * shape_pos, 0);
+            shapes->push_back(CachedShape(shape));
+        }
+        return BenchmarkCase{16 * number_of_shapes, [shapes]() {
+            for (ShapePos shape_pos_1 = 0; shape_pos_1 < (ShapePos)shapes->size(); ++shape_pos_1)
+                for (ShapePos shape_pos_2 = shape_pos_1 + 1; shape_pos_2 < (ShapePos)shapes->size(); ++shape_pos_2)
+                    sink += intersect((*shapes)[shape_pos_1], (*shapes)[shape_pos_2], true);
+        }};
+    }});
+
+    benchmarks.push_back({"shape_contains", [](ElementPos number_of_elements) {
+        ElementPos number_of_teeth = (std::max)((ElementPos)3, number_of_elements / 4);
+        auto shape = std::make_shared<Shape>(build_gear(number_of_teeth, 90, 100));
+        std::mt19937_64 generator(0);
+        std::uniform_real_distribution<LengthDbl> distribution_position(-100, 100);
+        auto points = std::make_shared<std::vector<Point>>();
+        for (ElementPos point_pos = 0; point_pos < 1000; ++point_pos)
+            points->push_back({distribution_position(generator), distribution_position(generator)});
+        return BenchmarkCase{4 * number_of_teeth, [shape, points]() {
+            for (const Point& point: *points)
+                sink += shape->contains(point);
+        }};
+    }});
+
+    benchmarks.push_back({"ring_contains", [](ElementPos number_of_elements) {
+        ElementPos number_of_teeth = (std::max)((ElementPos)3, number_of_elements / 4);
+        auto ring = std::make_shared<Ring>(build_gear(number_of_teeth, 90, 100));
+        std::mt19937_64 generator(0);
+        std::uniform_real_distribution<LengthDbl> distribution_position(-100, 100);
+        auto points = std::make_shared<std::vector<Point>>();
+        for (ElementPos point_pos = 0; point_pos < 1000; ++point_pos)
+            points->push_back({distribution_position(generator), distribution_position(generator)});
+        return BenchmarkCase{4 * number_of_teeth, [ring, points]() {
+            for (const Point& point: *points)
+                sink += ring->contains(point);
+        }};
+    }});
+
+    benchmarks.push_back({"shape_compute_area", [](ElementPos number_of_elements) {
+        auto shape = std::make_shared<Shape>(build_gear(number_of_elements / 4 + 1, 90, 100, 0.0, {0, 0}, false));
+        return BenchmarkCase{(ElementPos)shape->elements.size(), [shape]() {
+            sink += (std::size_t)shape->compute_area();
+        }};
+    }});
+
+    benchmarks.push_back({"ring_compute_area", [](ElementPos number_of_elements) {
+        auto ring = std::make_shared<Ring>(build_gear(number_of_elements / 4 + 1, 90, 100, 0.0, {0, 0}, false));
+        return BenchmarkCase{ring->number_of_elements(), [ring]() {
+            sink += (std::size_t)ring->compute_area();
+        }};
+    }});
+
+    benchmarks.push_back({"point_locator_contains", [](ElementPos number_of_elements) {
+        ElementPos number_of_teeth = (std::max)((ElementPos)3, number_of_elements / 4);
+        auto point_locator = std::make_shared<PointLocator>(build_gear(number_of_teeth, 90, 100));
+        std::mt19937_64 generator(0);
+        std::uniform_real_distribution<LengthDbl> distribution_position(-100, 100);
+        auto points = std::make_shared<std::vector<Point>>();
+        for (ElementPos point_pos = 0; point_pos < 1000; ++point_pos)
+            points->push_back({distribution_position(generator), distribution_position(generator)});
+        return BenchmarkCase{4 * number_of_teeth, [point_locator, points]() {
+            for (const Point& point: *points)
+                sink += point_locator->contains(point);
+        }};
+    }});
+
+    benchmarks.push_back({"contains_batch", [](ElementPos number_of_elements) {
+        ElementPos number_of_teeth = (std::max)((ElementPos)3, number_of_elements / 4);
+        auto shape = std::make_shared<Shape>(build_gear(number_of_teeth, 90, 100, 0.0, {0, 0}, false));
+        std::mt19937_64 generator(0);
+        std::uniform_real_distribution<LengthDbl> distribution_position(-100, 100);
+        auto points = std::make_shared<std::vector<Point>>();
+        for (ElementPos point_pos = 0; point_pos < 1000; ++point_pos)
+            points->push_back({distribution_position(generator), distribution_position(generator)});
+        auto output = std::make_shared<std::vector<uint8_t>>();
+        return BenchmarkCase{4 * number_of_teeth, [shape, points, output]() {
+            contains_batch(*shape, *points, *output);
+            for (uint8_t inside: *output)
+                sink += inside;
+        }};
+    }});
+
+    benchmarks.push_back({"intersection_tree_build", [](ElementPos number_of_elements) {
+        std::mt19937_64 generator(0);
+        auto elements = std::make_shared<std::vector<ShapeElement>>(
+                build_random_elements(number_of_elements, generator));
+        return BenchmarkCase{number_of_elements, [elements]() {
+            IntersectionTree intersection_tree(no_shapes, *elements, no_points);
+            sink += intersection_tree.intersect(elements->front(), false).element_ids.size();
+        }};
+    }});
+
+    benchmarks.push_back({"intersection_tree_build_parallel", [](ElementPos number_of_elements) {
+        std::mt19937_64 generator(0);
+        auto elements = std::make_shared<std::vector<ShapeElement>>(
+                build_random_elements(number_of_elements, generator));
+        return BenchmarkCase{number_of_elements, [elements]() {
+            IntersectionTreeParameters parameters;
+            parameters.number_of_threads = 4;
+            IntersectionTree intersection_tree(no_shapes, *elements, no_points, parameters);
+            sink += intersection_tree.intersect(elements->front(), false).element_ids.size();
+        }};
+    }});
+
+    benchmarks.push_back({"intersection_tree_query", [](ElementPos number_of_elements) {
+        std::mt19937_64 generator(0);
+        auto elements = std::make_shared<std::vector<ShapeElement>>(
+                build_random_elements(number_of_elements, generator));
+        auto intersection_tree = std::make_shared<IntersectionTree>(
+                no_shapes, *elements, no_points);
+        LengthDbl size = 10.0 * std::sqrt((double)number_of_elements);
+        std::uniform_real_distribution<LengthDbl> distribution_position(0, size);
+        auto shapes = std::make_shared<std::vector<Shape>>();
+        for (ElementPos shape_pos = 0;
+                shape_pos < (std::max)((ElementPos)1, number_of_elements / 8);
+                ++shape_pos) {
+            shapes->push_back(build_rounded_rectangle(
+                        distribution_position(generator),
+                        distribution_position(generator),
+                        10, 10, 2));
+        }
+        return BenchmarkCase{number_of_elements, [elements, intersection_tree, shapes]() {
+            for (const Shape& shape: *shapes)
+                sink += intersection_tree->intersect(shape, false).element_ids.size();
+        }};
+    }});
+
+    benchmarks.push_back({"intersection_tree_query_points", [](ElementPos number_of_elements) {
+        std::mt19937_64 generator(0);
+        auto elements = std::make_shared<std::vector<ShapeElement>>(
+                build_random_elements(number_of_elements, generator));
+        auto intersection_tree = std::make_shared<IntersectionTree>(
+                no_shapes, *elements, no_points);
+        LengthDbl size = 10.0 * std::sqrt((double)number_of_elements);
+        std::uniform_real_distribution<LengthDbl> distribution_position(0, size);
+        auto points = std::make_shared<std::vector<Point>>();
+        for (ElementPos point_pos = 0; point_pos < number_of_elements; ++point_pos)
+            points->push_back({distribution_position(generator), distribution_position(generator)});
+        return BenchmarkCase{number_of_elements, [elements, intersection_tree, points]() {
+            for (const Point& point: *points)
+                sink += intersection_tree->intersect(point, false).element_ids.size();
+        }};
+    }});
+
+    benchmarks.push_back({"intersection_tree_query_points_batch", [](ElementPos number_of_elements) {
+        std::mt19937_64 generator(0);
+        auto elements = std::make_shared<std::vector<ShapeElement>>(
+                build_random_elements(number_of_elements, generator));
+        auto intersection_tree = std::make_shared<IntersectionTree>(
+                no_shapes, *elements, no_points);
+        LengthDbl size = 10.0 * std::sqrt((double)number_of_elements);
+        std::uniform_real_distribution<LengthDbl> distribution_position(0, size);
+        auto points = std::make_shared<std::vector<Point>>();
+        for (ElementPos point_pos = 0; point_pos < number_of_elements; ++point_pos)
+            points->push_back({distribution_position(generator), distribution_position(generator)});
+        return BenchmarkCase{number_of_elements, [elements, intersection_tree, points]() {
+            sink += intersection_tree->intersect_batch(*points, false).element_ids.size();
+        }};
+    }});
+
+    benchmarks.push_back({"intersection_tree_k_nearest", [](ElementPos number_of_elements) {
+        std::mt19937_64 generator(0);
+        auto elements = std::make_shared<std::vector<ShapeElement>>(
+                build_random_elements(number_of_elements, generator));
+        auto intersection_tree = std::make_shared<IntersectionTree>(
+                no_shapes, *elements, no_points);
+        LengthDbl size = 10.0 * std::sqrt((double)number_of_elements);
+        std::uniform_real_distribution<LengthDbl> distribution_position(0, size);
+        auto points = std::make_shared<std::vector<Point>>();
+        for (ElementPos point_pos = 0; point_pos < number_of_elements; ++point_pos)
+            points->push_back({distribution_position(generator), distribution_position(generator)});
+        return BenchmarkCase{number_of_elements, [elements, intersection_tree, points]() {
+            for (const Point& point: *points)
+                sink += intersection_tree->k_nearest(point, 4).size();
+        }};
+    }});
+
+    benchmarks.push_back({"intersection_tree_intersecting_elements", [](ElementPos number_of_elements) {
+        std::mt19937_64 generator(0);
+        auto elements = std::make_shared<std::vector<ShapeElement>>(
+                build_random_elements(number_of_elements, generator));
+        auto intersection_tree = std::make_shared<IntersectionTree>(
+                no_shapes, *elements, no_points);
+        return BenchmarkCase{number_of_elements, [elements, intersection_tree]() {
+            sink += intersection_tree->compute_intersecting_elements(false).size();
+        }};
+    }});
+
+    benchmarks.push_back({"compute_intersecting_elements", [](ElementPos number_of_elements) {
+        std::mt19937_64 generator(0);
+        auto elements = std::make_shared<std::vector<ShapeElement>>(
+                build_random_elements(number_of_elements, generator));
+        return BenchmarkCase{number_of_elements, [elements]() {
+            sink += compute_intersecting_elements(*elements, false).size();
+        }};
+    }});
+
+    benchmarks.push_back({"compute_intersecting_elements_parallel", [](ElementPos number_of_elements) {
+        std::mt19937_64 generator(0);
+        auto elements = std::make_shared<std::vector<ShapeElement>>(
+                build_random_elements(number_of_elements, generator));
+        ComputeIntersectingElementsParameters parameters;
+        parameters.number_of_threads = 4;
+        return BenchmarkCase{number_of_elements, [elements, parameters]() {
+            sink += compute_intersecting_elements(*elements, false, parameters).size();
+        }};
+    }});
+
+    benchmarks.push_back({"compute_intersecting_elements_sweep", [](ElementPos number_of_elements) {
+        std::mt19937_64 generator(0);
+        auto elements = std::make_shared<std::vector<ShapeElement>>(
+                build_random_elements(number_of_elements, generator));
+        ComputeIntersectingElementsParameters parameters;
+        parameters.algorithm = IntersectingElementsAlgorithm::Sweep;
+        return BenchmarkCase{number_of_elements, [elements, parameters]() {
+            sink += compute_intersecting_elements(*elements, false, parameters).size();
+        }};
+    }});
+
+    benchmarks.push_back({"compute_intersecting_elements_sweep_bin", [](ElementPos number_of_elements) {
+        // Random elements inside the outline of a bin, whose long edges
+        // cross the sweep line during the whole sweep.
+        std::mt19937_64 generator(0);
+        auto elements = std::make_shared<std::vector<ShapeElement>>(
+                build_random_elements(number_of_elements, generator));
+        LengthDbl size = 10.0 * std::sqrt((double)number_of_elements);
+        for (const ShapeElement& element: build_rectangle(-20, size + 20, -20, size + 20).elements)
+            elements->push_back(element);
+        ComputeIntersectingElementsParameters parameters;
+        parameters.algorithm = IntersectingElementsAlgorithm::Sweep;
+        return BenchmarkCase{number_of_elements, [elements, parameters]() {
+            sink += compute_intersecting_elements(*elements, false, parameters).size();
+        }};
+    }});
+
+    benchmarks.push_back({"dynamic_intersection_tree_insert_remove", [](ElementPos number_of_elements) {
+        std::mt19937_64 generator(0);
+        auto elements = std::make_shared<std::vector<ShapeElement>>(
+                build_random_elements(number_of_elements, generator));
+        return BenchmarkCase{number_of_elements, [elements]() {
+            // Insert all the elements, then remove every other one.
+            DynamicIntersectionTree intersection_tree;
+            for (const ShapeElement& element: *elements)
+                intersection_tree.insert(element);
+            for (ElementPos element_id = 0;
+                    element_id < (ElementPos)elements->size();
+                    element_id += 2) {
+                intersection_tree.remove_element(element_id);
+            }
+            sink += intersection_tree.intersect(elements->back(), false).element_ids.size();
+        }};
+    }});
+
+    return benchmarks;
+}
+
+struct BenchmarkParameters
+{
+    /** Only run the benchmarks whose name contains this string. */
+    std::string filter;
+
+    /** Smallest requested number of elements. */
+    ElementPos minimum_number_of_elements = 32;
+
+    /** Largest requested number of elements. */
+    ElementPos maximum_number_of_elements = 262144;
+
+    /** Number of timed runs of each case; the best one is reported. */
+    Counter number_of_repetitions = 3;
+
+    /**
+     * Once a case of a benchmark takes longer than this time (in seconds),
+     * its larger cases are skipped.
+     */
+    double time_limit = 30.0;
+
+    /** Path of a CSV file to write the results to. */
+    std::string csv_path;
+};
+
+void print_usage()
+{
+    std::cout
+        << "Usage: Shape_shape_bench [options]\n"
+        << "  --filter STRING         only run benchmarks whose name contains STRING\n"
+        << "  --min-elements N        smallest number of elements (default 32)\n"
+        << "  --max-elements N        largest number of elements (default 262144)\n"
+        << "  --repetitions N         number of timed runs per case (default 3)\n"
+        << "  --time-limit SECONDS    skip larger cases once a case exceeds it (default 30)\n"
+        << "  --csv PATH              also write the results to a CSV file\n";
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    BenchmarkParameters parameters;
+    for (int arg_pos = 1; arg_pos < argc; ++arg_pos) {
+        std::string arg = argv[arg_pos];
+        if (arg == "--help" || arg == "-h") {
+            print_usage();
+            return 0;
+        }
+        if (arg_pos + 1 >= argc) {
+            print_usage();
+            return 1;
+        }
+        std::string value = argv[++arg_pos];
+        if (arg == "--filter") {
+            parameters.filter = value;
+        } else if (arg == "--min-elements") {
+            parameters.minimum_number_of_elements = std::stoll(value);
+        } else if (arg == "--max-elements") {
+            parameters.maximum_number_of_elements = std::stoll(value);
+        } else if (arg == "--repetitions") {
+            parameters.number_of_repetitions = (std::max)((Counter)1, (Counter)std::stoll(value));
+        } else if (arg == "--time-limit") {
+            parameters.time_limit = std::stod(value);
+        } else if (arg == "--csv") {
+            parameters.csv_path = value;
+        } else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    std::ofstream csv_file;
+    if (!parameters.csv_path.empty()) {
+        csv_file.open(parameters.csv_path);
+        if (!csv_file.good()) {
+            std::cerr << "Unable to open file \"" << parameters.csv_path << "\"." << std::endl;
+            return 1;
+        }
+        csv_file << "benchmark,number_of_elements,time,elements_per_second,peak_memory" << std::endl;
+    }
+
+    std::cout
+        << std::left << std::setw(40) << "Benchmark"
+        << std::right
+        << std::setw(12) << "Elements"
+        << std::setw(14) << "Time (ms)"
+        << std::setw(16) << "Elements/s"
+        << std::setw(16) << "Peak mem (KiB)"
+        << std::endl;
+
+    for (const Benchmark& benchmark: build_benchmarks()) {
+        if (benchmark.name.find(parameters.filter) == std::string::npos)
+            continue;
+
+        for (ElementPos number_of_elements = parameters.minimum_number_of_elements;
+                number_of_elements <= parameters.maximum_number_of_elements;
+                number_of_elements *= 8) {
+            std::cout
+                << std::left << std::setw(40) << benchmark.name
+                << std::right << std::flush;
+
+            double time_best = std::numeric_limits<double>::infinity();
+            std::size_t peak_memory_best = 0;
+            ElementPos case_number_of_elements = 0;
+            try {
+                BenchmarkCase benchmark_case = benchmark.build(number_of_elements);
+                case_number_of_elements = benchmark_case.number_of_elements;
+                for (Counter repetition = 0;
+                        repetition < parameters.number_of_repetitions;
+                        ++repetition) {
+                    std::size_t memory_start = current_memory();
+                    reset_peak_memory();
+                    auto start = std::chrono::steady_clock::now();
+                    benchmark_case.run();
+                    auto end = std::chrono::steady_clock::now();
+                    double time = std::chrono::duration<double>(end - start).count();
+                    if (time_best > time) {
+                        time_best = time;
+                        peak_memory_best = peak_memory() - memory_start;
+                    }
+                    if (time > parameters.time_limit)
+                        break;
+                }
+            } catch (const std::exception& e) {
+                std::cout << "  error: " << e.what() << std::endl;
+                break;
+            }
+
+            double throughput = case_number_of_elements / time_best;
+            std::cout
+                << std::setw(12) << case_number_of_elements
+                << std::setw(14) << std::fixed << std::setprecision(3) << time_best * 1e3
+                << std::setw(16) << std::setprecision(0) << throughput
+                << std::setw(16) << peak_memory_best / 1024
+                << std::endl;
+            if (csv_file.is_open()) {
+                csv_file
+                    << benchmark.name << ","
+                    << case_number_of_elements << ","
+                    << std::setprecision(9) << time_best << ","
+                    << std::setprecision(0) << throughput << ","
+                    << peak_memory_best
+                    << std::endl;
+            }
+
+            if (time_best > parameters.time_limit)
+                break;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,72 @@
+#include "memory.hpp"
+
+#include "shape/replay.hpp"
+
+#include <iomanip>
+#include <iostream>
+
+using namespace shape;
+
+namespace
+{
+
+void print_usage()
+{
+    std::cout
+        << "Usage: Shape_shape_replay [options] FILE...\n"
+        << "  FILE                    inputs written by one of the *_export_inputs functions\n"
+        << "  --runs N                number of timed runs (default 10)\n"
+        << "  --warmup-runs N         number of untimed runs before the timed ones (default 1)\n";
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    ReplayParameters parameters;
+    parameters.number_of_allocations = []() { return (Counter)bench::number_of_allocations(); };
+    std::vector<std::string> file_paths;
+    for (int arg_pos = 1; arg_pos < argc; ++arg_pos) {
+        std::string arg = argv[arg_pos];
+        if (arg == "--help" || arg == "-h") {
+            print_usage();
+            return 0;
+        } else if (arg == "--runs" && arg_pos + 1 < argc) {
+            parameters.number_of_runs = std::stoll(argv[++arg_pos]);
+        } else if (arg == "--warmup-runs" && arg_pos + 1 < argc) {
+            parameters.number_of_warmup_runs = std::stoll(argv[++arg_pos]);
+        } else if (!arg.empty() && arg[0] == '-') {
+            print_usage();
+            return 1;
+        } else {
+            file_paths.push_back(arg);
+        }
+    }
+    if (file_paths.empty()) {
+        print_usage();
+        return 1;
+    }
+
+    int status = 0;
+    for (const std::string& file_path: file_paths) {
+        std::cout << file_path << std::endl;
+        try {
+            ReplayOutput output = replay(file_path, parameters);
+            std::cout
+                << "    operation      " << replay_operation2str(output.operation) << "\n"
+                << "    runs           " << output.times.size() << "\n"
+                << std::fixed << std::setprecision(3)
+                << "    min (ms)       " << output.minimum_time * 1e3 << "\n"
+                << "    median (ms)    " << output.median_time * 1e3 << "\n"
+                << "    p99 (ms)       " << output.p99_time * 1e3 << "\n"
+                << "    allocations    " << output.minimum_number_of_allocations;
+            if (output.maximum_number_of_allocations != output.minimum_number_of_allocations)
+                std::cout << " - " << output.maximum_number_of_allocations;
+            std::cout << std::endl;
+        } catch (const std::exception& e) {
+            std::cout << "    error: " << e.what() << std::endl;
+            status = 1;
+        }
+    }
+    return status;
+}
@@ -0,0 +1,228 @@
+#include "workloads.hpp"
+
+using namespace shape;
+using namespace shape::bench;
+
+Shape shape::bench::build_rounded_rectangle(
+        LengthDbl x_min,
+        LengthDbl y_min,
+        LengthDbl width,
+        LengthDbl height,
+        LengthDbl radius)
+{
+    LengthDbl x_max = x_min + width;
+    LengthDbl y_max = y_min + height;
+    Shape shape;
+    shape.elements.push_back(build_line_segment(
+                {x_min + radius, y_min},
+                {x_max - radius, y_min}));
+    shape.elements.push_back(build_circular_arc(
+                {x_max - radius, y_min},
+                {x_max, y_min + radius},
+                {x_max - radius, y_min + radius},
+                ShapeElementOrientation::Anticlockwise));
+    shape.elements.push_back(build_line_segment(
+                {x_max, y_min + radius},
+                {x_max, y_max - radius}));
+    shape.elements.push_back(build_circular_arc(
+                {x_max, y_max - radius},
+                {x_max - radius, y_max},
+                {x_max - radius, y_max - radius},
+                ShapeElementOrientation::Anticlockwise));
+    shape.elements.push_back(build_line_segment(
+                {x_max - radius, y_max},
+                {x_min + radius, y_max}));
+    shape.elements.push_back(build_circular_arc(
+                {x_min + radius, y_max},
+                {x_min, y_max - radius},
+                {x_min + radius, y_max - radius},
+                ShapeElementOrientation::Anticlockwise));
+    shape.elements.push_back(build_line_segment(
+                {x_min, y_max - radius},
+                {x_min, y_min + radius}));
+    shape.elements.push_back(build_circular_arc(
+                {x_min, y_min + radius},
+                {x_min + radius, y_min},
+                {x_min + radius, y_min + radius},
+                ShapeElementOrientation::Anticlockwise));
+    return shape;
+}
+
+Shape shape::bench::build_gear(
+        ElementPos number_of_teeth,
+        LengthDbl inner_radius,
+        LengthDbl outer_radius,
+        Angle angle_offset,
+        const Point& center,
+        bool with_arcs)
+{
+    // Compute each point once so that consecutive elements share exactly the
+    // same end and start points.
+    ElementPos number_of_points = 4 * number_of_teeth;
+    std::vector<Point> points(number_of_points);
+    for (ElementPos point_pos = 0;
+            point_pos < number_of_points;
+            ++point_pos) {
+        Angle angle = angle_offset + 2 * M_PI * point_pos / number_of_points;
+        LengthDbl radius = (point_pos % 4 <= 1)? outer_radius: inner_radius;
+        points[point_pos] = {
+            center.x + radius * std::cos(angle),
+            center.y + radius * std::sin(angle)};
+    }
+
+    Shape shape;
+    for (ElementPos point_pos = 0;
+            point_pos < number_of_points;
+            ++point_pos) {
+        const Point& start = points[point_pos];
+        const Point& end = points[(point_pos + 1) % number_of_points];
+        if (with_arcs && point_pos % 2 == 0) {
+            shape.elements.push_back(build_circular_arc(
+                        start,
+                        end,
+                        center,
+                        ShapeElementOrientation::Anticlockwise));
+        } else {
+            shape.elements.push_back(build_line_segment(start, end));
+        }
+    }
+    return shape;
+}
+
+Shape shape::bench::build_rounded_regular_polygon(
+        ElementPos number_of_vertices,
+        LengthDbl radius,
+        LengthDbl corner_radius,
+        Angle angle_offset)
+{
+    std::vector<Point> vertices(number_of_vertices);
+    for (ElementPos vertex_pos = 0;
+            vertex_pos < number_of_vertices;
+            ++vertex_pos) {
+        Angle angle = angle_offset + 2 * M_PI * vertex_pos / number_of_vertices;
+        vertices[vertex_pos] = {radius * std::cos(angle), radius * std::sin(angle)};
+    }
+
+    // Offset points: for each edge, its start and end shifted along the
+    // outward normal.
+    std::vector<Point> edges_starts(number_of_vertices);
+    std::vector<Point> edges_ends(number_of_vertices);
+    for (ElementPos vertex_pos = 0;
+            vertex_pos < number_of_vertices;
+            ++vertex_pos) {
+        const Point& vertex = vertices[vertex_pos];
+        const Point& vertex_next = vertices[(vertex_pos + 1) % number_of_vertices];
+        Point direction = normalize(vertex_next - vertex);
+        Point normal = {direction.y, -direction.x};
+        edges_starts[vertex_pos] = vertex + corner_radius * normal;
+        edges_ends[vertex_pos] = vertex_next + corner_radius * normal;
+    }
+
+    Shape shape;
+    for (ElementPos vertex_pos = 0;
+            vertex_pos < number_of_vertices;
+            ++vertex_pos) {
+        ElementPos vertex_next_pos = (vertex_pos + 1) % number_of_vertices;
+        shape.elements.push_back(build_line_segment(
+                    edges_starts[vertex_pos],
+                    edges_ends[vertex_pos]));
+        shape.elements.push_back(build_circular_arc(
+                    edges_ends[vertex_pos],
+                    edges_starts[vertex_next_pos],
+                    vertices[vertex_next_pos],
+                    ShapeElementOrientation::Anticlockwise));
+    }
+    return shape;
+}
+
+std::vector<ShapeWithHoles> shape::bench::build_overlapping_rounded_rectangles(
+        ElementPos number_of_elements)
+{
+    // With a spacing of 10, a size of 11 and a corner radius of 3, each
+    // rectangle overlaps its neighbors and a small hole remains at each
+    // junction between four rectangles.
+    ElementPos number_of_shapes = (std::max)((ElementPos)1, number_of_elements / 8);
+    ElementPos number_of_columns = (ElementPos)std::ceil(std::sqrt((double)number_of_shapes));
+    std::vector<ShapeWithHoles> shapes;
+    for (ElementPos shape_pos = 0;
+            shape_pos < number_of_shapes;
+            ++shape_pos) {
+        LengthDbl x = 10.0 * (shape_pos % number_of_columns);
+        LengthDbl y = 10.0 * (shape_pos / number_of_columns);
+        shapes.push_back({build_rounded_rectangle(x, y, 11, 11, 3)});
+    }
+    return shapes;
+}
+
+std::vector<ShapeWithHoles> shape::bench::build_dense_rounded_rectangles(
+        ElementPos number_of_elements,
+        std::mt19937_64& generator)
+{
+    ElementPos number_of_shapes = (std::max)((ElementPos)1, number_of_elements / 8);
+    LengthDbl size = 2.5 * std::sqrt((double)number_of_shapes);
+    std::uniform_real_distribution<LengthDbl> distribution_position(0, size);
+    std::vector<ShapeWithHoles> shapes;
+    for (ElementPos shape_pos = 0;
+            shape_pos < number_of_shapes;
+            ++shape_pos) {
+        shapes.push_back({build_rounded_rectangle(
+                    distribution_position(generator),
+                    distribution_position(generator),
+                    11, 11, 3)});
+    }
+    return shapes;
+}
+
+ShapeWithHoles shape::bench::build_bin_with_holes(
+        ElementPos number_of_elements)
+{
+    ElementPos number_of_holes_by_side = (std::max)(
+            (ElementPos)1,
+            (ElementPos)std::sqrt((double)number_of_elements / 8));
+    LengthDbl size = 20 * number_of_holes_by_side;
+    ShapeWithHoles bin = {build_rectangle(0, size, 0, size)};
+    for (ElementPos x_pos = 0; x_pos < number_of_holes_by_side; ++x_pos) {
+        for (ElementPos y_pos = 0; y_pos < number_of_holes_by_side; ++y_pos) {
+            bin.holes.push_back(build_rounded_rectangle(
+                        20 * x_pos + 5,
+                        20 * y_pos + 5,
+                        10, 10, 2));
+        }
+    }
+    return bin;
+}
+
+std::vector<ShapeElement> shape::bench::build_random_elements(
+        ElementPos number_of_elements,
+        std::mt19937_64& generator)
+{
+    LengthDbl size = 10.0 * std::sqrt((double)number_of_elements);
+    std::uniform_real_distribution<LengthDbl> distribution_position(0, size);
+    std::uniform_real_distribution<Angle> distribution_angle(0, 2 * M_PI);
+    std::uniform_real_distribution<Angle> distribution_span(0.2, 2.5);
+
+    std::vector<ShapeElement> elements;
+    for (ElementPos element_pos = 0;
+            element_pos < number_of_elements;
+            ++element_pos) {
+        Point point = {
+            distribution_position(generator),
+            distribution_position(generator)};
+        Angle angle = distribution_angle(generator);
+        if (element_pos % 2 == 0) {
+            LengthDbl length = 15;
+            elements.push_back(build_line_segment(
+                        point,
+                        {point.x + length * std::cos(angle), point.y + length * std::sin(angle)}));
+        } else {
+            LengthDbl radius = 5;
+            Angle angle_end = angle + distribution_span(generator);
+            elements.push_back(build_circular_arc(
+                        {point.x + radius * std::cos(angle), point.y + radius * std::sin(angle)},
+                        {point.x + radius * std::cos(angle_end), point.y + radius * std::sin(angle_end)},
+                        point,
+                        ShapeElementOrientation::Anticlockwise));
+        }
+    }
+    return elements;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "shape/shape.hpp"
+
+#include <random>
+
+namespace shape
+{
+namespace bench
+{
+
+/**
+ * Build a rectangle whose corners are rounded by quarter circles.
+ *
+ * The shape has 8 elements: 4 line segments and 4 circular arcs.
+ */
+Shape build_rounded_rectangle(
+        LengthDbl x_min,
+        LengthDbl y_min,
+        LengthDbl width,
+        LengthDbl height,
+        LengthDbl radius);
+
+/**
+ * Build a gear centered on 'center'.
+ *
+ * Each tooth is made of an arc of the outer circle, a line segment going
+ * down to the inner circle, an arc of the inner circle and a line segment
+ * going back up. If 'with_arcs' is false, the arcs are replaced by line
+ * segments and the gear is a polygon.
+ *
+ * The shape has 4 * number_of_teeth elements.
+ */
+Shape build_gear(
+        ElementPos number_of_teeth,
+        LengthDbl inner_radius,
+        LengthDbl outer_radius,
+        Angle angle_offset = 0.0,
+        const Point& center = {0, 0},
+        bool with_arcs = true);
+
+/**
+ * Build a convex regular polygon inflated by 'corner_radius'.
+ *
+ * The shape has 2 * number_of_vertices elements, every second one being a
+ * circular arc.
+ */
+Shape build_rounded_regular_polygon(
+        ElementPos number_of_vertices,
+        LengthDbl radius,
+        LengthDbl corner_radius,
+        Angle angle_offset = 0.0);
+
+/**
+ * Build a grid of overlapping rounded rectangles containing approximately
+ * 'number_of_elements' elements.
+ */
+std::vector<ShapeWithHoles> build_overlapping_rounded_rectangles(
+        ElementPos number_of_elements);
+
+/**
+ * Build rounded rectangles randomly placed in a square, so that each of them
+ * overlaps many others.
+ *
+ * The union of the shapes is much simpler than its input.
+ */
+std::vector<ShapeWithHoles> build_dense_rounded_rectangles(
+        ElementPos number_of_elements,
+        std::mt19937_64& generator);
+
+/**
+ * Build a square bin with a grid of rounded rectangle holes containing
+ * approximately 'number_of_elements' elements.
+ *
+ * The holes are 10 x 10 and spaced by 20.
+ */
+ShapeWithHoles build_bin_with_holes(
+        ElementPos number_of_elements);
+
+/**
+ * Build random short line segments and circular arcs spread over a square
+ * whose size grows with the number of elements.
+ */
+std::vector<ShapeElement> build_random_elements(
+        ElementPos number_of_elements,
+        std::mt19937_64& generator);
+
+}
+}
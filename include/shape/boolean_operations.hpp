@@ -1,25 +1,173 @@
 #pragma once
 
-#include "shape/shape.hpp"
+#include "shape/shapes_intersections.hpp"
+#include "shape/point_locator.hpp"
+#include "shape/dynamic_intersection_tree.hpp"
+
+#include <functional>
+#include <limits>
 
 namespace shape
 {
 
+struct BooleanOperationParameters
+{
+    /**
+     * Number of threads used to build the intersection tree of the input
+     * elements, to compute the intersections between them and to process
+     * the connected components of the arrangement.
+     *
+     * The components are independent once the input elements have been
+     * split, so they can be processed concurrently. The output doesn't
+     * depend on the number of threads.
+     */
+    Counter number_of_threads = 1;
+
+    /**
+     * Executor used to process the connected components.
+     *
+     * If set, it is used instead of number_of_threads. It receives one task
+     * per connected component and must have run all of them, in any order
+     * and possibly concurrently, when it returns.
+     *
+     * It is also used instead of new threads to build the IntersectionTree
+     * of the input elements and to evaluate its candidate pairs, in
+     * number_of_threads tasks.
+     */
+    Executor executor;
+
+    /**
+     * Maximum number of shapes of the groups of a cascaded union.
+     *
+     * If strictly positive and compute_union receives more shapes than this
+     * value, the shapes are sorted along a Morton curve of the centers of
+     * their bounding boxes and split into groups of at most this size. Each
+     * group is unioned, then the partial results are merged pairwise, in the
+     * same order, until a single one remains. This way, the elements inside
+     * each partial result don't take part in the following merges.
+     *
+     * The groups and the merges of a same level are independent; they are
+     * processed with number_of_threads or executor.
+     *
+     * The output covers the same region as the direct union. Since the
+     * partial results are split again at each merge, intersection vertices
+     * might be slightly moved; very small groups multiply such re-splits, a
+     * few dozen shapes per group is a reasonable choice.
+     */
+    ShapePos cascaded_union_group_size = 0;
+
+    /** Algorithm used to find the intersections between the input elements. */
+    IntersectingElementsAlgorithm intersecting_elements_algorithm = IntersectingElementsAlgorithm::IntersectionTree;
+};
+
 /**
  * Compute the union of a given set of shapes.
  */
 MultiShapeWithHoles compute_union(
-        const std::vector<ShapeWithHoles>& shapes);
+        const std::vector<ShapeWithHoles>& shapes,
+        const BooleanOperationParameters& parameters = {});
 
 void compute_union_export_inputs(
         const std::string& file_path,
         const std::vector<ShapeWithHoles>& shapes);
 
+/**
+ * Union of shapes added one at a time.
+ *
+ * The boundary of the current union is stored element by element in a
+ * dynamic intersection tree, each element being directed so that the union
+ * is on its left, and linked to the next and previous elements of its loop.
+ *
+ * When a shape is added, only the boundary elements touching it are
+ * retrieved. They are split with the elements of the new shape; the parts of
+ * each side which are outside the other one are kept and linked back to the
+ * rest of their loops. The cost of an addition thus depends on the size of
+ * the new shape and of the part of the boundary it touches, not on the size
+ * of the whole union. If the pieces can't be linked, because nearly tangent
+ * elements were not split consistently, the union is computed from scratch
+ * with compute_union instead.
+ *
+ * The union is built from the loops of the boundary when it is requested.
+ */
+class UnionAccumulator
+{
+
+public:
+
+    /** Constructor. */
+    UnionAccumulator(
+            const BooleanOperationParameters& parameters = {}):
+        parameters_(parameters) { }
+
+    /** Add a shape to the union. */
+    void add(const ShapeWithHoles& shape);
+
+    /** Get the union of the shapes added so far. */
+    const MultiShapeWithHoles& result() const;
+
+    /**
+     * Get the number of elements of the boundary of the union which have
+     * been split by the last call to 'add'.
+     */
+    ElementPos number_of_splitted_elements() const { return number_of_splitted_elements_; }
+
+private:
+
+    /** Insert an element in the boundary and return its id. */
+    ElementPos insert_element(const ShapeElement& element);
+
+    /** Insert loops in the boundary. */
+    void insert_loops(const std::vector<std::vector<ShapeElement>>& loops);
+
+    /** Check if a point which is not on the boundary is inside the union. */
+    bool union_contains(const Point& point) const;
+
+    /**
+     * Replace the boundary by the boundary of the union of the current union
+     * and a new shape computed from scratch.
+     */
+    void rebuild(const ShapeWithHoles& shape);
+
+    /** Parameters of the boolean operations. */
+    BooleanOperationParameters parameters_;
+
+    /**
+     * Elements of the boundary of the current union.
+     *
+     * The outlines are anticlockwise and the holes are clockwise.
+     */
+    DynamicIntersectionTree boundary_;
+
+    /** For each element of the boundary, next element of its loop. */
+    std::vector<ElementPos> boundary_next_;
+
+    /** For each element of the boundary, previous element of its loop. */
+    std::vector<ElementPos> boundary_prev_;
+
+    /**
+     * Greatest x of the shapes added so far.
+     *
+     * The rays used to locate a point stop beyond it.
+     */
+    LengthDbl x_max_ = -std::numeric_limits<LengthDbl>::infinity();
+
+    /** Number of elements split by the last call to 'add'. */
+    ElementPos number_of_splitted_elements_ = 0;
+
+    /** Current union, built from the boundary by 'result'. */
+    mutable MultiShapeWithHoles result_;
+
+    /** True if 'result_' corresponds to the current boundary. */
+    mutable bool result_is_up_to_date_ = true;
+
+};
+
 /**
  * Compute the intersection of a given set of shapes.
  */
 MultiShapeWithHoles compute_intersection(
-        const std::vector<ShapeWithHoles>& shapes);
+        const std::vector<ShapeWithHoles>& shapes,
+        const BooleanOperationParameters& parameters = {});
 
 void compute_intersection_export_inputs(
         const std::string& file_path,
@@ -53,12 +201,32 @@ MultiShapeWithHoles compute_intersection(
         const ShapeWithHoles& shape_1,
         const ShapeWithHoles& shape_2);
 
+/**
+ * Compute the area of the intersection of two shapes.
+ *
+ * The boundaries of the shapes are split at their intersections and the
+ * area is integrated along the parts of the boundary of the intersection;
+ * the faces of the intersection are not built.
+ */
+AreaDbl compute_intersection_area(
+        const ShapeWithHoles& shape_1,
+        const ShapeWithHoles& shape_2);
+
+/**
+ * Compute the area of the intersection of given pairs of shapes.
+ */
+std::vector<AreaDbl> compute_intersection_area(
+        const std::vector<ShapeWithHoles>& shapes,
+        const std::vector<std::pair<ShapePos, ShapePos>>& pairs,
+        const BooleanOperationParameters& parameters = {});
+
 /**
  * Compute the difference between two multi-shapes.
  */
 MultiShapeWithHoles compute_difference(
         const MultiShapeWithHoles& shapes_1,
-        const MultiShapeWithHoles& shapes_2);
+        const MultiShapeWithHoles& shapes_2,
+        const BooleanOperationParameters& parameters = {});
 
 /**
  * Convenience overload of compute_difference for two single shapes.
@@ -72,7 +240,8 @@ MultiShapeWithHoles compute_difference(
  */
 MultiShapeWithHoles compute_symmetric_difference(
         const MultiShapeWithHoles& shapes_1,
-        const MultiShapeWithHoles& shapes_2);
+        const MultiShapeWithHoles& shapes_2,
+        const BooleanOperationParameters& parameters = {});
 
 /**
  * Convenience overload of compute_symmetric_difference for two single
@@ -82,6 +251,154 @@ MultiShapeWithHoles compute_symmetric_difference(
         const ShapeWithHoles& shape_1,
         const ShapeWithHoles& shape_2);
 
+/**
+ * Shape prepared to be used as the first operand of many differences or
+ * intersections.
+ *
+ * The bounding boxes of the outline elements and of the holes are computed
+ * once and stored in a tree. Then, an operation with a small shape only
+ * involves the holes whose bounding box intersects the one of the small
+ * shape, and the outline only if one of its elements does.
+ *
+ * A point locator is also built for the outline and for each hole, to
+ * check if the shape contains a point in logarithmic time.
+ *
+ * The loops of the outline and of the holes are stored directed, element by
+ * element, with the bounding box tree of their elements. An operation with a
+ * small shape only splits the elements touching it, and closes the result
+ * with the stored loops, like UnionAccumulator does.
+ */
+class PreparedShape
+{
+
+public:
+
+    /** Constructor. */
+    PreparedShape(const ShapeWithHoles& shape);
+
+    /** Get the shape. */
+    const ShapeWithHoles& shape() const { return shape_; }
+
+    /** Get the bounding box of the shape. */
+    const AxisAlignedBoundingBox& min_max() const { return aabb_; }
+
+    /**
+     * Get the outline elements whose bounding box intersects or touches a
+     * given bounding box.
+     */
+    std::vector<ElementPos> find_outline_elements(
+            const AxisAlignedBoundingBox& aabb) const;
+
+    /**
+     * Get the holes whose bounding box intersects or touches a given
+     * bounding box.
+     */
+    std::vector<ShapePos> find_holes(
+            const AxisAlignedBoundingBox& aabb) const;
+
+    /**
+     * Check if the shape contains a given point.
+     *
+     * Return the same value as ShapeWithHoles::contains.
+     */
+    bool contains(
+            const Point& point,
+            bool strict = false) const;
+
+private:
+
+    /**
+     * Get the elements of the boundary which intersect or touch a given
+     * shape, sorted.
+     */
+    std::vector<ElementPos> find_boundary_elements(
+            const ShapeWithHoles& shape,
+            const AxisAlignedBoundingBox& aabb) const;
+
+    /** Get a loop of the boundary. */
+    Shape boundary_loop(ShapePos loop_pos) const;
+
+    friend MultiShapeWithHoles compute_intersection(
+            const PreparedShape& shape_1,
+            const ShapeWithHoles& shape_2,
+            const BooleanOperationParameters& parameters);
+
+    friend MultiShapeWithHoles compute_difference(
+            const PreparedShape& shape_1,
+            const ShapeWithHoles& shape_2,
+            const BooleanOperationParameters& parameters);
+
+    /** Shape. */
+    ShapeWithHoles shape_;
+
+    /** Bounding box of the shape. */
+    AxisAlignedBoundingBox aabb_;
+
+    /**
+     * Tree of the bounding boxes of the outline elements.
+     *
+     * Node 1 is the root, the children of node i are nodes 2i and 2i + 1,
+     * and the bounding box of element e is stored in node n + e.
+     */
+    std::vector<AxisAlignedBoundingBox> outline_elements_tree_;
+
+    /** Tree of the bounding boxes of the holes, with the same layout. */
+    std::vector<AxisAlignedBoundingBox> holes_tree_;
+
+    /** Point locator of the outline. */
+    PointLocator outline_locator_;
+
+    /** Point locators of the holes. */
+    std::vector<PointLocator> holes_locators_;
+
+    /**
+     * Elements of the loops of the outline and of the holes, directed so
+     * that the shape is on their left.
+     *
+     * The outline is anticlockwise and the holes are clockwise. Full circles
+     * are split into two half circles.
+     */
+    std::vector<ShapeElement> boundary_elements_;
+
+    /** For each element of the boundary, next element of its loop. */
+    std::vector<ElementPos> boundary_next_;
+
+    /** For each element of the boundary, previous element of its loop. */
+    std::vector<ElementPos> boundary_prev_;
+
+    /**
+     * For each element of the boundary, its loop: 0 for the outline, and
+     * 'hole_pos + 1' for a hole.
+     */
+    std::vector<ShapePos> boundary_loops_;
+
+    /** Position of the first element of each loop in 'boundary_elements_'. */
+    std::vector<ElementPos> boundary_loops_offsets_;
+
+    /**
+     * Tree of the bounding boxes of the elements of the boundary, with the
+     * same layout as 'outline_elements_tree_'.
+     */
+    std::vector<AxisAlignedBoundingBox> boundary_elements_tree_;
+
+};
+
+/**
+ * Compute the intersection between a prepared shape and a shape.
+ */
+MultiShapeWithHoles compute_intersection(
+        const PreparedShape& shape_1,
+        const ShapeWithHoles& shape_2,
+        const BooleanOperationParameters& parameters = {});
+
+/**
+ * Compute the difference between a prepared shape and a shape.
+ */
+MultiShapeWithHoles compute_difference(
+        const PreparedShape& shape_1,
+        const ShapeWithHoles& shape_2,
+        const BooleanOperationParameters& parameters = {});
+
 Shape extract_outline(
         const Shape& shape);
 
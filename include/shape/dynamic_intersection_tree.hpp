@@ -0,0 +1,247 @@
+#pragma once
+
+#include "shape/shape.hpp"
+
+namespace shape
+{
+
+struct DynamicIntersectionTreeParameters
+{
+    /**
+     * If false, the tree is rebalanced by rotations after each insertion and
+     * each removal.
+     *
+     * If true, no rotation is performed; instead, the tree is rebuilt from
+     * scratch once the number of insertions and removals since the last
+     * rebuild exceeds the number of items, or a fraction of it if the tree
+     * has become much higher than a balanced one. This makes modifications
+     * cheaper, at the price of a less balanced tree in between.
+     */
+    bool lazy_rebalancing = false;
+};
+
+/**
+ * Intersection tree supporting the insertion and the removal of shapes and
+ * elements.
+ *
+ * It is a bounding volume hierarchy: each leaf stores an item and its
+ * bounding box, and each internal node the bounding box of its two children.
+ * Insertions and removals only modify the path from the leaf to the root, so
+ * they take O(log n) amortized time.
+ *
+ * The tree owns a copy of its items. The id of a removed item might be given
+ * to an item inserted afterwards.
+ */
+class DynamicIntersectionTree
+{
+
+public:
+
+    /** Constructor. */
+    DynamicIntersectionTree(
+            const DynamicIntersectionTreeParameters& parameters = {}):
+        parameters_(parameters) { }
+
+    struct IntersectOutput
+    {
+        std::vector<ShapePos> shape_ids;
+
+        std::vector<ElementPos> element_ids;
+    };
+
+    /** Insert a shape and return its id. */
+    ShapePos insert(const ShapeWithHoles& shape);
+
+    /** Insert an element and return its id. */
+    ElementPos insert(const ShapeElement& element);
+
+    /** Remove a shape. */
+    void remove_shape(ShapePos shape_id);
+
+    /** Remove an element. */
+    void remove_element(ElementPos element_id);
+
+    /** Rebuild the tree from scratch to balance it. */
+    void rebalance();
+
+    /** Get the number of shapes of the tree. */
+    ShapePos number_of_shapes() const { return shapes_.size() - free_shape_ids_.size(); }
+
+    /** Get the number of elements of the tree. */
+    ElementPos number_of_elements() const { return elements_.size() - free_element_ids_.size(); }
+
+    /** Check if a shape id is the id of a shape of the tree. */
+    bool contains_shape(ShapePos shape_id) const;
+
+    /** Check if an element id is the id of an element of the tree. */
+    bool contains_element(ElementPos element_id) const;
+
+    /** Get a shape of the tree. */
+    const ShapeWithHoles& shape(ShapePos shape_id) const { return shapes_[shape_id].shape; }
+
+    /** Get an element of the tree. */
+    const ShapeElement& element(ElementPos element_id) const { return elements_[element_id].element; }
+
+    /** Get the height of the tree. */
+    Counter height() const;
+
+    /** Check if a given shape intersects one of the tree shapes. */
+    IntersectOutput intersect(
+            const ShapeWithHoles& shape,
+            bool strict) const;
+
+    /** Check if a given shape intersects one of the tree shapes. */
+    IntersectOutput intersect(
+            const Shape& shape,
+            bool strict) const;
+
+    /**
+     * Check if a given element intersects one of the tree shapes.
+     *
+     * As for IntersectionTree, if 'strict' is true, the elements of the tree
+     * returned are the ones having an improper intersection with the given
+     * element (see compute_intersections).
+     */
+    IntersectOutput intersect(
+            const ShapeElement& element,
+            bool strict) const;
+
+    /** Check if a given point intersects one of the tree shapes. */
+    IntersectOutput intersect(
+            const Point& point,
+            bool strict) const;
+
+    /** Get all the pairs of intersecting shapes in the tree. */
+    std::vector<std::pair<ShapePos, ShapePos>> compute_intersecting_shapes(bool strict) const;
+
+private:
+
+    using NodeId = int32_t;
+
+    using Height = int32_t;
+
+    struct Node
+    {
+        /** Bounding box of the items of the subtree. */
+        AxisAlignedBoundingBox aabb;
+
+        /** Parent; -1 for the root and for the nodes of the free list. */
+        NodeId parent_id = -1;
+
+        /** First child; -1 for a leaf; next free node for a free node. */
+        NodeId child_1_id = -1;
+
+        /** Second child; -1 for a leaf. */
+        NodeId child_2_id = -1;
+
+        /** Height of the subtree; 0 for a leaf, -1 for a free node. */
+        Height height = 0;
+
+        /** Id of the item of a leaf. */
+        ShapePos item_id = -1;
+
+        /** True if the item of a leaf is a shape, false if it is an element. */
+        bool is_shape = false;
+
+        /** Check if the node is a leaf. */
+        bool is_leaf() const { return child_1_id == -1; }
+    };
+
+    struct ShapeItem
+    {
+        ShapeWithHoles shape;
+
+        /** Leaf of the shape; -1 if the shape has been removed. */
+        NodeId node_id = -1;
+    };
+
+    struct ElementItem
+    {
+        ShapeElement element;
+
+        /** Leaf of the element; -1 if the element has been removed. */
+        NodeId node_id = -1;
+    };
+
+    /** Get a node from the free list, or a new one. */
+    NodeId allocate_node();
+
+    /** Put a node back in the free list. */
+    void free_node(NodeId node_id);
+
+    /** Create a leaf for an item and insert it. */
+    NodeId insert_item(
+            const AxisAlignedBoundingBox& aabb,
+            ShapePos item_id,
+            bool is_shape);
+
+    /** Remove the leaf of an item and free it. */
+    void remove_item(NodeId node_id);
+
+    /** Insert a leaf in the tree. */
+    void insert_leaf(NodeId leaf_id);
+
+    /** Remove a leaf from the tree without freeing it. */
+    void remove_leaf(NodeId leaf_id);
+
+    /**
+     * Update the bounding boxes and heights of the ancestors of a node,
+     * rotating them if they are unbalanced and rotations are enabled.
+     */
+    void update_ancestors(NodeId node_id);
+
+    /**
+     * Perform a rotation at a node if it is unbalanced.
+     *
+     * Return the node which replaces it.
+     */
+    NodeId balance(NodeId node_id);
+
+    /** Count a modification and rebuild the tree if needed. */
+    void add_modification();
+
+    /** Build a subtree on the given leaves and return its root. */
+    NodeId build(
+            std::vector<NodeId>::iterator leaves_begin,
+            std::vector<NodeId>::iterator leaves_end);
+
+    /**
+     * Add the items whose bounding box intersects or touches a given
+     * bounding box, sorted by id.
+     */
+    void find_potentially_intersecting(
+            const AxisAlignedBoundingBox& aabb,
+            std::vector<ShapePos>& shape_ids,
+            std::vector<ElementPos>& element_ids) const;
+
+
+    /** Parameters. */
+    DynamicIntersectionTreeParameters parameters_;
+
+    /** Nodes. */
+    std::vector<Node> nodes_;
+
+    /** Root of the tree; -1 if the tree is empty. */
+    NodeId root_id_ = -1;
+
+    /** First node of the free list; -1 if the list is empty. */
+    NodeId free_node_id_ = -1;
+
+    /** Shapes. */
+    std::vector<ShapeItem> shapes_;
+
+    /** Ids of the removed shapes. */
+    std::vector<ShapePos> free_shape_ids_;
+
+    /** Elements. */
+    std::vector<ElementItem> elements_;
+
+    /** Ids of the removed elements. */
+    std::vector<ElementPos> free_element_ids_;
+
+    /** Number of insertions and removals since the last rebuild. */
+    Counter number_of_modifications_ = 0;
+
+};
+
+}
@@ -2,6 +2,9 @@
 
 #include "shape/shape.hpp"
 
+#include <array>
+#include <stdexcept>
+
 namespace shape
 {
 
@@ -52,4 +55,109 @@ ShapeElementIntersectionsOutput compute_intersections(
         const ShapeElement& element_1,
         const ShapeElement& element_2);
 
+/**
+ * Intersections between two elements stored inline, without any heap
+ * allocation.
+ *
+ * Two elements have at most two overlapping parts and two proper
+ * intersections. The endpoints of both elements are tested separately, so up
+ * to four improper intersections might be reported.
+ */
+struct FixedShapeElementIntersectionsOutput
+{
+    std::array<ShapeElement, 2> overlapping_parts;
+
+    ElementPos number_of_overlapping_parts = 0;
+
+    std::array<Point, 4> improper_intersections;
+
+    ElementPos number_of_improper_intersections = 0;
+
+    std::array<Point, 2> proper_intersections;
+
+    ElementPos number_of_proper_intersections = 0;
+
+
+    /** Check if there is no intersection. */
+    bool empty() const
+    {
+        return number_of_overlapping_parts == 0
+            && number_of_improper_intersections == 0
+            && number_of_proper_intersections == 0;
+    }
+
+    /*
+     * The capacities are the largest numbers of intersections of two
+     * elements; exceeding them is a bug of the intersection kernels.
+     */
+
+    void add_overlapping_part(const ShapeElement& element)
+    {
+        if (number_of_overlapping_parts == (ElementPos)overlapping_parts.size()) {
+            throw std::logic_error(
+                    FUNC_SIGNATURE + ": "
+                    "too many overlapping parts.");
+        }
+        overlapping_parts[number_of_overlapping_parts++] = element;
+    }
+
+    void add_improper_intersection(const Point& point)
+    {
+        if (number_of_improper_intersections == (ElementPos)improper_intersections.size()) {
+            throw std::logic_error(
+                    FUNC_SIGNATURE + ": "
+                    "too many improper intersections.");
+        }
+        improper_intersections[number_of_improper_intersections++] = point;
+    }
+
+    void add_proper_intersection(const Point& point)
+    {
+        if (number_of_proper_intersections == (ElementPos)proper_intersections.size()) {
+            throw std::logic_error(
+                    FUNC_SIGNATURE + ": "
+                    "too many proper intersections.");
+        }
+        proper_intersections[number_of_proper_intersections++] = point;
+    }
+
+    /** Convert to the vector form. */
+    ShapeElementIntersectionsOutput to_output() const;
+};
+
+/**
+ * Same as compute_intersections, but write the intersections in a
+ * fixed-capacity output.
+ *
+ * This is the version to use in loops over many pairs of elements, where
+ * most pairs don't intersect.
+ */
+void compute_intersections(
+        const ShapeElement& element_1,
+        const ShapeElement& element_2,
+        FixedShapeElementIntersectionsOutput& output);
+
+/**
+ * Check if two elements intersect.
+ *
+ * If strict is false, return true if compute_intersections finds any
+ * overlapping part or intersection point; if strict is true, return true if
+ * it finds a proper intersection. The intersections are not computed, so it
+ * is cheaper than compute_intersections.
+ */
+bool intersect(
+        const ShapeElement& element_1,
+        const ShapeElement& element_2,
+        bool strict = false);
+
+/** Compute the distance between a point and an element. */
+LengthDbl distance(
+        const Point& point,
+        const ShapeElement& element);
+
+/** Compute the distance between two elements. */
+LengthDbl distance(
+        const ShapeElement& element_1,
+        const ShapeElement& element_2);
+
 }
@@ -1,22 +1,88 @@
 #pragma once
 
 #include "shape/shapes_intersections.hpp"
+#include "shape/ring.hpp"
 
 #include "optimizationtools/containers/indexed_set.hpp"
 
+#include <memory>
+
 namespace shape
 {
 
+struct IntersectionTreeParameters
+{
+    /**
+     * Number of threads used to build the tree.
+     *
+     * The two subtrees of a node are built concurrently if the node has at
+     * least 'parallel_threshold' items, as long as there are threads left.
+     * The tree doesn't depend on the number of threads.
+     */
+    Counter number_of_threads = 1;
+
+    /** Minimum number of items of a node to build its subtrees concurrently. */
+    ElementPos parallel_threshold = 16384;
+
+    /**
+     * Executor used to build the subtrees concurrently.
+     *
+     * If set, it is used instead of new threads; number_of_threads still
+     * gives the number of subtrees built concurrently.
+     */
+    Executor executor;
+};
+
 class IntersectionTree
 {
 
 public:
 
-    /** Constructor. */
+    /**
+     * Constructor.
+     *
+     * The tree keeps references to the non-empty given vectors; they must
+     * outlive it.
+     */
     IntersectionTree(
             const std::vector<ShapeWithHoles>& shapes,
             const std::vector<ShapeElement>& elements,
-            const std::vector<Point>& points);
+            const std::vector<Point>& points,
+            const IntersectionTreeParameters& parameters = {});
+
+    /**
+     * Constructor taking the ownership of the geometry.
+     *
+     * The geometry is moved into a store shared by the copies of the tree.
+     * Thus, the tree can be built from temporaries, and copied or kept in a
+     * cache to be queried later without being rebuilt. To build it from
+     * vectors which must be kept, pass copies of them.
+     */
+    IntersectionTree(
+            std::vector<ShapeWithHoles>&& shapes,
+            std::vector<ShapeElement>&& elements,
+            std::vector<Point>&& points,
+            const IntersectionTreeParameters& parameters = {});
+
+    /**
+     * Constructor on the elements of rings.
+     *
+     * The elements of the tree are the elements of the rings, ring after
+     * ring; 'ring_element' gives the ring of an element id. They are rebuilt
+     * with Ring::element when they are checked, so the rings are not copied
+     * into shape elements.
+     *
+     * The tree keeps a reference to the rings; they must outlive it.
+     */
+    IntersectionTree(
+            const std::vector<Ring>& rings,
+            const IntersectionTreeParameters& parameters = {});
+
+    /**
+     * Get the ring of an element of a tree built on rings, and the position
+     * of the element in this ring.
+     */
+    std::pair<ShapePos, ElementPos> ring_element(ElementPos element_id) const;
 
 
     struct IntersectOutput
@@ -28,6 +94,64 @@ public:
         std::vector<ShapePos> point_ids;
     };
 
+    /**
+     * Scratch state of the queries.
+     *
+     * The queries taking a scratch don't modify the tree, so a tree can be
+     * queried concurrently by several threads, each one with its own scratch.
+     * The memory of the scratch is reused from one query to the next.
+     */
+    struct QueryScratch
+    {
+        /** Constructor. */
+        QueryScratch(const IntersectionTree& intersection_tree);
+
+        optimizationtools::IndexedSet potentially_intersecting_shapes;
+
+        optimizationtools::IndexedSet potentially_intersecting_elements;
+
+        optimizationtools::IndexedSet potentially_intersecting_points;
+
+        std::vector<uint32_t> stack;
+
+        /** Output of the last query. */
+        IntersectOutput output;
+    };
+
+    /**
+     * Check if a given shape intersects one of the tree shapes.
+     *
+     * The returned reference points to the output of the scratch; it is
+     * valid until the next query using the same scratch.
+     */
+    const IntersectOutput& intersect(
+            const ShapeWithHoles& shape,
+            bool strict,
+            QueryScratch& scratch) const;
+
+    /** Check if a given shape intersects one of the tree shapes. */
+    const IntersectOutput& intersect(
+            const Shape& shape,
+            bool strict,
+            QueryScratch& scratch) const;
+
+    /** Check if a given element intersects one of the tree shapes. */
+    const IntersectOutput& intersect(
+            const ShapeElement& element,
+            bool strict,
+            QueryScratch& scratch) const;
+
+    /** Check if a given point intersects one of the tree shapes. */
+    const IntersectOutput& intersect(
+            const Point& point,
+            bool strict,
+            QueryScratch& scratch) const;
+
+    /*
+     * The following queries use a scratch owned by the tree. Thus, they must
+     * not be called concurrently.
+     */
+
     /** Check if a given shape intersects one of the tree shapes. */
     IntersectOutput intersect(
             const ShapeWithHoles& shape,
@@ -38,7 +162,14 @@ public:
             const Shape& shape,
             bool strict) const;
 
-    /** Check if a given element intersects one of the tree shapes. */
+    /**
+     * Check if a given element intersects one of the tree shapes.
+     *
+     * If 'strict' is true, the elements of the tree returned are the ones
+     * having an improper intersection with the given element (see
+     * compute_intersections), rather than a proper one as for
+     * intersect(const ShapeElement&, const ShapeElement&, bool).
+     */
     IntersectOutput intersect(
             const ShapeElement& element,
             bool strict) const;
@@ -48,62 +179,282 @@ public:
             const Point& point,
             bool strict) const;
 
+    /**
+     * Output of a batch of queries.
+     *
+     * The ids of the shapes intersecting the i-th query are the ones from
+     * shape_ids[shape_offsets[i]] to shape_ids[shape_offsets[i + 1] - 1],
+     * sorted; and similarly for the elements and the points.
+     */
+    struct IntersectBatchOutput
+    {
+        std::vector<ElementPos> shape_offsets;
+
+        std::vector<ShapePos> shape_ids;
+
+        std::vector<ElementPos> element_offsets;
+
+        std::vector<ElementPos> element_ids;
+
+        std::vector<ElementPos> point_offsets;
+
+        std::vector<ElementPos> point_ids;
+    };
 
-    /** Get all the pairs of intersecting shapes in the tree. */
-    std::vector<std::pair<ShapePos, ShapePos>> compute_intersecting_shapes(bool strict) const;
+    /**
+     * Check which tree items each of the given points intersects.
+     *
+     * The tree is walked once for the whole batch: each node is visited with
+     * the list of the queries which reach it. These queries don't use the
+     * scratch of the tree and can be called concurrently.
+     */
+    IntersectBatchOutput intersect_batch(
+            const std::vector<Point>& points,
+            bool strict) const;
 
-    /** Get all the pairs of intersecting shape elements in the tree. */
-    std::vector<ElementElementIntersection> compute_intersecting_elements(bool strict) const;
+    /** Check which tree items each of the given elements intersects. */
+    IntersectBatchOutput intersect_batch(
+            const std::vector<ShapeElement>& elements,
+            bool strict) const;
+
+    /*
+     * The following queries only consider the elements of the tree. They
+     * don't use the scratch of the tree and can be called concurrently.
+     */
+
+    struct ElementDistance
+    {
+        /** Id of the element. */
+        ElementPos element_id = -1;
+
+        /** Distance to the element. */
+        LengthDbl distance = std::numeric_limits<LengthDbl>::infinity();
+    };
+
+    /**
+     * Get the element of the tree which is the closest to a given point.
+     *
+     * The nodes are explored by increasing distance between the point and
+     * their region, until this distance exceeds the one of the closest
+     * element found.
+     */
+    ElementDistance nearest_element(const Point& point) const;
+
+    /**
+     * Get the k elements of the tree which are the closest to a given point,
+     * sorted by distance.
+     */
+    std::vector<ElementDistance> k_nearest(
+            const Point& point,
+            ElementPos k) const;
+
+    /**
+     * Get the elements of the tree at distance at most 'distance' of a given
+     * shape, sorted by id.
+     *
+     * The distance of an element which intersects the shape, its interior
+     * included, is 0.
+     */
+    std::vector<ElementDistance> elements_within_distance(
+            const ShapeWithHoles& shape,
+            LengthDbl distance) const;
+
+
+    /**
+     * Get all the pairs of intersecting shapes in the tree.
+     *
+     * The candidate pairs are evaluated in 'number_of_threads' tasks, run
+     * with 'executor' if it is set and with new threads otherwise; the
+     * output doesn't depend on it.
+     */
+    std::vector<std::pair<ShapePos, ShapePos>> compute_intersecting_shapes(
+            bool strict,
+            Counter number_of_threads = 1,
+            const Executor& executor = Executor()) const;
+
+    /**
+     * Get all the pairs of intersecting shape elements in the tree.
+     *
+     * The candidate pairs are evaluated in 'number_of_threads' tasks, run
+     * with 'executor' if it is set and with new threads otherwise; the
+     * output doesn't depend on it.
+     */
+    std::vector<ElementElementIntersection> compute_intersecting_elements(
+            bool strict,
+            Counter number_of_threads = 1,
+            const Executor& executor = Executor()) const;
 
     /** Get all the pairs of equal points in the tree. */
     std::vector<std::pair<ElementPos, ElementPos>> compute_equal_points() const;
 
 private:
 
-    using NodeId = int64_t;
+    /** Geometry owned by the tree. */
+    struct Geometry
+    {
+        std::vector<ShapeWithHoles> shapes;
+
+        std::vector<ShapeElement> elements;
 
+        std::vector<Point> points;
+    };
+
+    /** Constructor on an owned geometry. */
+    IntersectionTree(
+            std::shared_ptr<const Geometry> geometry,
+            const IntersectionTreeParameters& parameters);
+
+    using NodeId = uint32_t;
+
+    /** Position of an item in the item ids of the leaves. */
+    using ItemPos = uint32_t;
+
+    /**
+     * Node of the tree.
+     *
+     * The two children of a node are stored next to each other. The items of
+     * a leaf are stored contiguously in 'item_ids_': its shapes, then its
+     * elements, then its points.
+     */
     struct Node
     {
-        LengthDbl l = std::numeric_limits<LengthDbl>::infinity();
+        /** Position of the cut. */
+        LengthDbl position = 0.0;
 
-        LengthDbl r = -std::numeric_limits<LengthDbl>::infinity();
+        /** Id of the lesser child; the greater child follows it. */
+        NodeId lesser_child_id = 0;
 
-        LengthDbl b = std::numeric_limits<LengthDbl>::infinity();
+        /** Position of the first item of the leaf in 'item_ids_'. */
+        ItemPos items_start = 0;
 
-        LengthDbl t = -std::numeric_limits<LengthDbl>::infinity();
+        /** Number of shapes of the leaf. */
+        ItemPos number_of_shapes = 0;
 
-        char direction = 'x';
+        /** Number of elements of the leaf. */
+        ItemPos number_of_elements = 0;
 
-        LengthDbl position = 0.0;
+        /** Number of points of the leaf. */
+        ItemPos number_of_points = 0;
 
-        NodeId lesser_child_id = -1;
+        /** Direction of the cut, 'v' or 'h', or 'x' for a leaf. */
+        char direction = 'x';
 
-        NodeId greater_child_id = -1;
+        /** Get the position of the first shape of the leaf. */
+        ItemPos shapes_begin() const { return items_start; }
 
-        std::vector<ShapePos> shape_ids;
+        /** Get the position of the first element of the leaf. */
+        ItemPos elements_begin() const { return items_start + number_of_shapes; }
 
-        std::vector<ElementPos> element_ids;
+        /** Get the position of the first point of the leaf. */
+        ItemPos points_begin() const { return elements_begin() + number_of_elements; }
 
-        std::vector<ElementPos> point_ids;
+        /** Get the position after the last point of the leaf. */
+        ItemPos points_end() const { return points_begin() + number_of_points; }
     };
 
     struct StackElement
     {
         NodeId node_id;
-        std::vector<ShapePos> shape_ids;
-        std::vector<ElementPos> element_ids;
-        std::vector<ElementPos> point_ids;
+        AxisAlignedBoundingBox aabb;
+        std::vector<ItemPos> shape_ids;
+        std::vector<ItemPos> element_ids;
+        std::vector<ItemPos> point_ids;
     };
 
-    void build_node_rec(
-            NodeId node_id,
-            const std::vector<ShapePos>& shape_ids);
+    /** Data shared by the builds of the subtrees. */
+    struct BuildData;
+
+    /** Buffers reused by the splits of the nodes of a subtree. */
+    struct BuildScratch;
+
+    /**
+     * Subtree.
+     *
+     * Its nodes are its root, then the descendants of the root, in the order
+     * of the whole tree: the children of the root, then the descendants of
+     * the lesser child, then the descendants of the greater child.
+     */
+    struct Subtree
+    {
+        std::vector<Node> nodes;
+
+        std::vector<ItemPos> item_ids;
+    };
+
+    /**
+     * Compute the cut of a node.
+     *
+     * Return the direction of the cut, or 'x' if the node is a leaf.
+     */
+    static char split_node(
+            const BuildData& data,
+            BuildScratch& scratch,
+            const StackElement& stack_element,
+            LengthDbl& split,
+            StackElement& stack_element_lesser,
+            StackElement& stack_element_greater);
+
+    /** Build the tree on the geometry of the tree. */
+    void build(const IntersectionTreeParameters& parameters);
+
+    /** Build the subtree of a node. */
+    static Subtree build_subtree(
+            const BuildData& data,
+            StackElement stack_element);
+
+    /**
+     * Build the subtree of a node, the subtrees of its descendants with at
+     * least 'parallel_threshold' items being built concurrently, as long as
+     * there are threads left.
+     *
+     * The top of the subtree is split first, then the subtrees below are
+     * built as independent tasks, and finally they are merged.
+     */
+    static Subtree build_subtree(
+            const BuildData& data,
+            StackElement stack_element,
+            Counter number_of_threads,
+            const Executor& executor);
+
+    /**
+     * Merge the subtrees of the children of a node.
+     *
+     * The nodes of the output are in the same order as if it had been built
+     * at once.
+     */
+    static Subtree merge_subtrees(
+            const Node& node,
+            Subtree&& subtree_lesser,
+            Subtree&& subtree_greater);
+
+    /**
+     * Add to the scratch the items of the leaves which might intersect a
+     * given bounding box.
+     */
+    void find_potentially_intersecting(
+            const AxisAlignedBoundingBox& aabb,
+            QueryScratch& scratch) const;
+
+    /**
+     * Compute, for each given bounding box, the items of the leaves which
+     * might intersect it.
+     */
+    void find_potentially_intersecting_batch(
+            const std::vector<AxisAlignedBoundingBox>& aabbs,
+            IntersectBatchOutput& candidates) const;
 
     /** Get the number of shapes. */
     ShapePos number_of_shapes() const { if (shapes_ == nullptr) return 0; return shapes_->size(); }
 
     /** Get the number of elements. */
-    ShapePos number_of_elements() const { if (elements_ == nullptr) return 0; return elements_->size(); }
+    ShapePos number_of_elements() const
+    {
+        if (rings_ != nullptr)
+            return rings_elements_offsets_.back();
+        if (elements_ == nullptr)
+            return 0;
+        return elements_->size();
+    }
 
     /** Get the number of points. */
     ShapePos number_of_points() const { if (points_ == nullptr) return 0; return points_->size(); }
@@ -112,12 +463,21 @@ private:
     const ShapeWithHoles& shape(ShapePos shape_pos) const { return (*shapes_)[shape_pos]; }
 
     /** Get a shape element of the intersection tree. */
-    const ShapeElement& element(ElementPos element_pos) const { return (*elements_)[element_pos]; }
+    ShapeElement element(ElementPos element_pos) const
+    {
+        if (rings_ == nullptr)
+            return (*elements_)[element_pos];
+        std::pair<ShapePos, ElementPos> ring_element = this->ring_element(element_pos);
+        return (*rings_)[ring_element.first].element(ring_element.second);
+    }
 
     /** Get a point of the intersection tree. */
     const Point& point(ElementPos point_pos) const { return (*points_)[point_pos]; }
 
 
+    /** Geometry owned by the tree, if any. */
+    std::shared_ptr<const Geometry> geometry_;
+
     /** Shapes. */
     const std::vector<ShapeWithHoles>* shapes_ = nullptr;
 
@@ -127,18 +487,26 @@ private:
     /** Points. */
     const std::vector<Point>* points_ = nullptr;
 
-    bool small_ = false;
-
-    mutable optimizationtools::IndexedSet potentially_intersecting_shapes_;
+    /** Rings whose elements are the elements of the tree, if any. */
+    const std::vector<Ring>* rings_ = nullptr;
 
-    mutable optimizationtools::IndexedSet potentially_intersecting_elements_;
+    /**
+     * Id of the first element of each ring, followed by the number of
+     * elements.
+     */
+    std::vector<ElementPos> rings_elements_offsets_;
 
-    mutable optimizationtools::IndexedSet potentially_intersecting_points_;
+    bool small_ = false;
 
-    mutable std::vector<NodeId> intersect_stack_;
+    /** Scratch of the queries which don't take one. */
+    mutable QueryScratch scratch_;
 
+    /** Nodes; the root is the first one. */
     std::vector<Node> tree_;
 
+    /** Items of the leaves. */
+    std::vector<ItemPos> item_ids_;
+
 };
 
 }
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "shape/shape.hpp"
+
+namespace shape
+{
+
+/**
+ * Structure answering many point-in-shape queries on a same shape.
+ *
+ * The plane is split into horizontal slabs at the extreme y of the elements
+ * and of their y-monotone pieces; circular arcs are split at the top and at
+ * the bottom of their circle. In each slab, the pieces crossing the whole
+ * slab, far from their ends, are sorted from left to right. A query locates
+ * the slab of the point by binary search, then the point among the sorted
+ * pieces by binary search. Each piece to the right of the point counts as
+ * one intersection of the ray casting of Shape::contains.
+ *
+ * The elements close to the point, and the elements having an end in the
+ * slab, are checked exactly as in Shape::contains, so the output is always
+ * the same as the one of Shape::contains, including on the boundary.
+ *
+ * If the pieces of a slab intersect each other, which only happens if the
+ * shape intersects itself, all the elements of the slab are checked
+ * exactly.
+ *
+ * A query takes O(log n) time, plus the number of elements which have to be
+ * checked exactly. The structure uses one entry per slab and per piece
+ * crossing it.
+ */
+class PointLocator
+{
+
+public:
+
+    /** Constructor. */
+    PointLocator(const Shape& shape);
+
+    /** Get the shape. */
+    const Shape& shape() const { return shape_; }
+
+    /**
+     * Check if the shape contains a given point.
+     *
+     * Return the same value as Shape::contains.
+     */
+    bool contains(
+            const Point& point,
+            bool strict = false) const;
+
+private:
+
+    /** Piece of an element crossing a slab. */
+    struct SlabPiece
+    {
+        /** Element of the piece. */
+        ElementPos element_pos;
+
+        /**
+         * For a piece of a circular arc, 1 if it is on the right half of
+         * the circle, -1 if it is on the left half; 0 for a line segment.
+         */
+        int side;
+
+        /**
+         * Horizontal distance from the piece beyond which a point of the
+         * slab is far enough from it not to be on the element.
+         */
+        LengthDbl window;
+
+        /**
+         * Position in slab_pieces_ of the other piece of the same element
+         * crossing the slab; -1 if there is none.
+         */
+        ElementPos sibling_pos;
+    };
+
+    /** Compute the x of a piece at a given y of its slab. */
+    LengthDbl x(
+            const SlabPiece& piece,
+            LengthDbl y) const;
+
+    /** Shape. */
+    Shape shape_;
+
+    /** Bounds of the slabs; slab s is [slab_bounds_[s], slab_bounds_[s + 1]). */
+    std::vector<LengthDbl> slab_bounds_;
+
+    /**
+     * Elements of slab s to check exactly:
+     * exact_elements_[exact_elements_offsets_[s]] to
+     * exact_elements_[exact_elements_offsets_[s + 1] - 1].
+     */
+    std::vector<ElementPos> exact_elements_offsets_;
+
+    /** Elements to check exactly, slab by slab. */
+    std::vector<ElementPos> exact_elements_;
+
+    /**
+     * Pieces of slab s, sorted from left to right:
+     * slab_pieces_[slab_pieces_offsets_[s]] to
+     * slab_pieces_[slab_pieces_offsets_[s + 1] - 1].
+     */
+    std::vector<ElementPos> slab_pieces_offsets_;
+
+    /** Pieces, slab by slab. */
+    std::vector<SlabPiece> slab_pieces_;
+
+    /** Largest window of the pieces of each slab. */
+    std::vector<LengthDbl> slab_windows_;
+
+};
+
+/**
+ * Check if a shape contains each of the given points.
+ *
+ * output[i] is set to the value of shape.contains(points[i], strict).
+ *
+ * If the shape is a polygon, its edges are first stored in separate arrays
+ * of coordinates, then the points are processed four at a time with AVX2
+ * instructions if the processor supports them, one at a time otherwise.
+ * The points close to an edge, or at the height of a vertex, are checked
+ * with Shape::contains.
+ *
+ * If 'use_avx2' is false, the points are always processed one at a time;
+ * both paths return the same output.
+ */
+void contains_batch(
+        const Shape& shape,
+        const std::vector<Point>& points,
+        std::vector<uint8_t>& output,
+        bool strict = false,
+        bool use_avx2 = true);
+
+}
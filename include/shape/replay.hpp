@@ -0,0 +1,109 @@
+#pragma once
+
+#include "shape/shape.hpp"
+
+#include <functional>
+
+namespace shape
+{
+
+/**
+ * Operation whose inputs have been dumped by one of the *_export_inputs
+ * functions.
+ */
+enum class ReplayOperation
+{
+    ComputeUnion,
+    ComputeIntersection,
+    InflateShapeWithHoles,
+    InflateShape,
+    Rasterization,
+    Simplify,
+    IntersectShapeShape,
+    IntersectShapeWithHolesElement,
+    IntersectShapeWithHolesShape,
+    IntersectShapeWithHolesShapeWithHoles,
+    ComputeIntersections,
+    ComputeStrictIntersections,
+    ShapeContains,
+    ApproximateShapeByLineSegments,
+    ApproximateByLineSegments,
+};
+
+/**
+ * Convert an operation to the name written in the "operation" field of the
+ * exported inputs.
+ */
+std::string replay_operation2str(ReplayOperation operation);
+
+ReplayOperation str2replay_operation(const std::string& str);
+
+/**
+ * Detect the operation of exported inputs.
+ *
+ * The "operation" field is used if present. Otherwise, for inputs exported
+ * before it was added, the operation is deduced from the other fields. In
+ * this case, compute_union and compute_intersection inputs can't be
+ * distinguished and are replayed as compute_union; and inflate inputs
+ * without holes are replayed with the Shape overload.
+ */
+ReplayOperation detect_replay_operation(const nlohmann::json& json);
+
+struct ReplayParameters
+{
+    /** Number of timed runs. */
+    Counter number_of_runs = 10;
+
+    /** Number of untimed runs performed before the timed ones. */
+    Counter number_of_warmup_runs = 1;
+
+    /**
+     * Function returning the number of allocations performed so far.
+     *
+     * The library doesn't track allocations itself; the caller can provide
+     * a counter, for example from replaced global allocation functions. If
+     * empty, the allocation counts of the output are not computed.
+     */
+    std::function<Counter()> number_of_allocations;
+};
+
+struct ReplayOutput
+{
+    /** Replayed operation. */
+    ReplayOperation operation;
+
+    /** Time of each timed run, in seconds. */
+    std::vector<double> times;
+
+    /** Minimum time of a run. */
+    double minimum_time = 0.0;
+
+    /** Median time of a run. */
+    double median_time = 0.0;
+
+    /** 99th percentile of the time of a run. */
+    double p99_time = 0.0;
+
+    /** Minimum number of allocations of a run; -1 if not computed. */
+    Counter minimum_number_of_allocations = -1;
+
+    /** Maximum number of allocations of a run; -1 if not computed. */
+    Counter maximum_number_of_allocations = -1;
+};
+
+/**
+ * Run the operation of exported inputs several times and measure it.
+ */
+ReplayOutput replay(
+        const nlohmann::json& json,
+        const ReplayParameters& parameters = {});
+
+/**
+ * Read a file written by one of the *_export_inputs functions and replay
+ * it.
+ */
+ReplayOutput replay(
+        const std::string& file_path,
+        const ReplayParameters& parameters = {});
+
+}
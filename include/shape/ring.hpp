@@ -0,0 +1,144 @@
+#pragma once
+
+#include "shape/shape.hpp"
+
+namespace shape
+{
+
+/**
+ * Compact representation of a shape.
+ *
+ * A shape stores each of its elements as a full ShapeElement, and the end of
+ * each element duplicates the start of the next one. A ring only stores the
+ * start of each element, and the center and orientation of its circular
+ * arcs in a separate sorted table. For a polygon, it is a plain list of
+ * points.
+ *
+ * The elements are rebuilt on the fly by element(), so that the algorithms
+ * working element by element can run on a ring without converting it back
+ * to a Shape. For instance, an IntersectionTree can be built directly on
+ * the elements of rings.
+ */
+class Ring
+{
+
+public:
+
+    /** Circular arc of a ring. */
+    struct Arc
+    {
+        /** Position of the arc in the elements of the ring. */
+        ElementPos element_pos;
+
+        /** Center of the circle. */
+        Point center;
+
+        /** Direction of the rotation. */
+        ShapeElementOrientation orientation;
+    };
+
+    /** Constructor. */
+    Ring() { }
+
+    /**
+     * Build a ring from a shape.
+     *
+     * The end of each element must be equal to the start of the next one, up
+     * to the tolerance of 'equal'. It is not stored: the elements of the ring
+     * end exactly at the start of the next one. Thus, the conversion is
+     * lossless only if the ends and the starts are exactly the same points.
+     */
+    Ring(const Shape& shape);
+
+    /** Build the shape of the ring. */
+    Shape to_shape() const;
+
+    /** Return true iff the ring is actually a path. */
+    bool is_path() const { return is_path_; }
+
+    /** Get the vertices of the ring, i.e. the starts of its elements. */
+    const std::vector<Point>& vertices() const { return vertices_; }
+
+    /** Get the circular arcs of the ring, sorted by element position. */
+    const std::vector<Arc>& arcs() const { return arcs_; }
+
+    /** Get the number of elements of the ring. */
+    ElementPos number_of_elements() const
+    {
+        return (is_path_ && !vertices_.empty())?
+            (ElementPos)vertices_.size() - 1:
+            (ElementPos)vertices_.size();
+    }
+
+    /** Get an element of the ring. */
+    ShapeElement element(ElementPos element_pos) const;
+
+    /** Return true iff the ring is a polygon. */
+    bool is_polygon() const { return !is_path_ && arcs_.empty(); }
+
+    /** Compute the area of the ring. */
+    AreaDbl compute_area() const;
+
+    /** Compute the smallest and greatest x and y of the ring. */
+    AxisAlignedBoundingBox compute_min_max() const;
+
+    /**
+     * Check if the ring contains a given point.
+     *
+     * Return the same value as Shape::contains.
+     */
+    bool contains(
+            const Point& point,
+            bool strict = false) const;
+
+private:
+
+    /** Build an element from its vertex and its arc if it has one. */
+    ShapeElement element(
+            ElementPos element_pos,
+            const Arc* arc) const;
+
+    /** Starts of the elements, followed by the end of the last one for a path. */
+    std::vector<Point> vertices_;
+
+    /** Circular arcs. */
+    std::vector<Arc> arcs_;
+
+    /** Boolean indicating if the ring is actually a path. */
+    bool is_path_ = false;
+
+};
+
+/**
+ * Compact representation of a shape with holes.
+ */
+struct RingWithHoles
+{
+    Ring ring;
+
+    std::vector<Ring> holes;
+
+
+    /** Constructor. */
+    RingWithHoles() { }
+
+    /** Build a ring with holes from a shape with holes. */
+    RingWithHoles(const ShapeWithHoles& shape);
+
+    /** Build the shape with holes. */
+    ShapeWithHoles to_shape_with_holes() const;
+
+    /** Compute the area of the shape. */
+    AreaDbl compute_area() const;
+
+    /**
+     * Check if the shape contains a given point.
+     *
+     * Return the same value as ShapeWithHoles::contains.
+     */
+    bool contains(
+            const Point& point,
+            bool strict = false) const;
+};
+
+}
@@ -47,6 +47,16 @@ inline bool equal(double v1, double v2)
     return std::abs(v1 - v2) <= 1e-6;
 }
 
+/**
+ * Margin added to bounding boxes before checking if they overlap.
+ *
+ * Because of the tolerance of the comparisons above, two elements may
+ * intersect slightly outside of their bounding boxes. Geometry whose
+ * bounding boxes are further from each other than this margin can't
+ * intersect.
+ */
+constexpr double bounding_box_margin = 1e-5;
+
 LengthDbl largest_power_of_two_lesser_or_equal(LengthDbl value);
 
 LengthDbl smallest_power_of_two_greater_or_equal(LengthDbl value);
@@ -401,6 +411,16 @@ struct ShapeElement
     /** Check if a point is on the element. */
     bool contains(const Point& point) const;
 
+    /**
+     * Count the intersections of the element with the horizontal ray going
+     * right from a given point, as counted by the ray casting of
+     * Shape::contains.
+     */
+    ElementPos count_ray_intersections(const Point& point) const;
+
+    /** Get the point of the element which is the closest to a given point. */
+    Point closest_point(const Point& point) const;
+
     /** Radius of the element. The element must be a CircularArc. */
     LengthDbl radius() const
     {
@@ -804,6 +824,139 @@ ShapeWithHoles operator*(
         LengthDbl scalar,
         const ShapeWithHoles& shape);
 
+/**
+ * Shape with its derived attributes.
+ *
+ * The bounding box, the area, the polygon and convexity flags and a point
+ * strictly inside are computed once at construction, so that they can be
+ * queried in constant time. The shape can't be modified directly; shift
+ * updates the attributes in constant time, rotate only recomputes the ones
+ * depending on the orientation. To apply other modifications, build a new
+ * CachedShape from the modified shape.
+ *
+ * The area, the convexity flag and the point strictly inside are not
+ * computed for paths, and the point strictly inside isn't computed for empty
+ * shapes.
+ */
+class CachedShape
+{
+
+public:
+
+    /** Constructor. */
+    CachedShape(const Shape& shape = {});
+
+    /** Get the shape. */
+    const Shape& shape() const { return shape_; }
+
+    /** Get the smallest and greatest x and y of the shape. */
+    const AxisAlignedBoundingBox& min_max() const { return aabb_; }
+
+    /** Get the area of the shape. */
+    AreaDbl area() const { return area_; }
+
+    /** Return true iff the shape is a polygon. */
+    bool is_polygon() const { return is_polygon_; }
+
+    /** Return true iff the shape is convex. */
+    bool is_convex() const { return is_convex_; }
+
+    /** Get a point strictly inside the shape. */
+    const Point& point_strictly_inside() const { return point_strictly_inside_; }
+
+    CachedShape& shift(
+            LengthDbl x,
+            LengthDbl y);
+
+    CachedShape& shift(
+            const Point& vector)
+    {
+        return this->shift(vector.x, vector.y);
+    }
+
+    CachedShape rotate(Angle angle) const;
+
+private:
+
+    /** Shape. */
+    Shape shape_;
+
+    /** Bounding box of the shape. */
+    AxisAlignedBoundingBox aabb_;
+
+    /** Area of the shape. */
+    AreaDbl area_ = 0.0;
+
+    /** Whether the shape is a polygon. */
+    bool is_polygon_ = true;
+
+    /** Whether the shape is convex. */
+    bool is_convex_ = true;
+
+    /** Point strictly inside the shape. */
+    Point point_strictly_inside_ = {0, 0};
+
+};
+
+/**
+ * Shape with holes with its derived attributes.
+ *
+ * See CachedShape.
+ */
+class CachedShapeWithHoles
+{
+
+public:
+
+    /** Constructor. */
+    CachedShapeWithHoles(const ShapeWithHoles& shape = {});
+
+    /** Get the shape. */
+    const ShapeWithHoles& shape() const { return shape_; }
+
+    /** Get the smallest and greatest x and y of the shape. */
+    const AxisAlignedBoundingBox& min_max() const { return aabb_; }
+
+    /** Get the area of the shape. */
+    AreaDbl area() const { return area_; }
+
+    /** Return true iff the shape is a polygon. */
+    bool is_polygon() const { return is_polygon_; }
+
+    /** Get a point strictly inside the shape. */
+    const Point& point_strictly_inside() const { return point_strictly_inside_; }
+
+    CachedShapeWithHoles& shift(
+            LengthDbl x,
+            LengthDbl y);
+
+    CachedShapeWithHoles& shift(
+            const Point& vector)
+    {
+        return this->shift(vector.x, vector.y);
+    }
+
+    CachedShapeWithHoles rotate(Angle angle) const;
+
+private:
+
+    /** Shape. */
+    ShapeWithHoles shape_;
+
+    /** Bounding box of the shape. */
+    AxisAlignedBoundingBox aabb_;
+
+    /** Area of the shape. */
+    AreaDbl area_ = 0.0;
+
+    /** Whether the shape is a polygon. */
+    bool is_polygon_ = true;
+
+    /** Point strictly inside the shape. */
+    Point point_strictly_inside_ = {0, 0};
+
+};
+
 /**
  * Structure for a set of possibly disjoint shapes with holes, i.e. a
  * multi-shape, the union of several `ShapeWithHoles`.
@@ -3,17 +3,66 @@
 #include "shape/shape.hpp"
 #include "shape/elements_intersections.hpp"
 
+#include <functional>
+
 namespace shape
 {
 
+/**
+ * Function running a list of tasks.
+ *
+ * It must have run all of them, in any order and possibly concurrently,
+ * when it returns.
+ */
+using Executor = std::function<void(const std::vector<std::function<void()>>&)>;
 
-bool intersect(
-        const ShapeElement& element_1,
-        const ShapeElement& element_2);
+enum class IntersectingElementsAlgorithm
+{
+    /** Evaluate the pairs of elements sharing a leaf of an IntersectionTree. */
+    IntersectionTree,
+
+    /**
+     * Sweep a vertical line over the bounding boxes of the elements, sorted
+     * by smallest x, and evaluate the pairs of elements whose bounding boxes
+     * overlap.
+     *
+     * The elements crossing the line are kept ordered by y, so the sweep
+     * runs in O((n + k) log n), k being the number of pairs of elements
+     * whose bounding boxes overlap. Long elements crossing the line during
+     * the whole sweep don't make it quadratic.
+     *
+     * The candidate pairs are evaluated as soon as they are found instead
+     * of being stored, so the memory stays linear even when long elements
+     * would span many leaves of an IntersectionTree.
+     */
+    Sweep,
+};
 
+struct ComputeIntersectingElementsParameters
+{
+    /** Algorithm used to find the candidate pairs of elements. */
+    IntersectingElementsAlgorithm algorithm = IntersectingElementsAlgorithm::IntersectionTree;
+
+    /**
+     * Number of threads used to build the IntersectionTree and to evaluate
+     * the candidate pairs it finds.
+     *
+     * The Sweep algorithm is sequential.
+     */
+    Counter number_of_threads = 1;
+
+    /**
+     * Executor used to run the concurrent tasks of the IntersectionTree.
+     *
+     * If set, it is used instead of new threads; number_of_threads still
+     * gives the number of tasks.
+     */
+    Executor executor;
+};
 
 bool intersect(
-        const Shape& shape);
+        const Shape& shape,
+        const ComputeIntersectingElementsParameters& parameters = {});
 
 struct ElementElementIntersection
 {
@@ -22,8 +71,20 @@ struct ElementElementIntersection
     ShapeElementIntersectionsOutput intersections;
 };
 
+/**
+ * Compute the pairs of intersecting elements of a given set of elements.
+ *
+ * The pairs are sorted, and the first id of each pair is smaller than the
+ * second one.
+ */
 std::vector<ElementElementIntersection> compute_intersecting_elements(
-        const Shape& shape);
+        const std::vector<ShapeElement>& elements,
+        bool strict,
+        const ComputeIntersectingElementsParameters& parameters = {});
+
+std::vector<ElementElementIntersection> compute_intersecting_elements(
+        const Shape& shape,
+        const ComputeIntersectingElementsParameters& parameters = {});
 
 
 bool intersect(
@@ -62,6 +123,17 @@ bool intersect(
         const Shape& shape_2,
         bool strict = false);
 
+/**
+ * Same as intersect(shape_1.shape(), shape_2.shape(), strict).
+ *
+ * The shapes are first compared with their bounding boxes, and their cached
+ * points strictly inside are used instead of being recomputed.
+ */
+bool intersect(
+        const CachedShape& shape_1,
+        const CachedShape& shape_2,
+        bool strict = false);
+
 void intersect_export_inputs(
         const std::string& file_path,
         const Shape& shape_1,
@@ -128,6 +200,20 @@ inline bool intersect(
     return intersect(shape_with_holes_2, shape_1, strict);
 }
 
+/** See intersect(const CachedShape&, const CachedShape&, bool). */
+bool intersect(
+        const CachedShapeWithHoles& shape_with_holes_1,
+        const CachedShape& shape_2,
+        bool strict = false);
+
+inline bool intersect(
+        const CachedShape& shape_1,
+        const CachedShapeWithHoles& shape_with_holes_2,
+        bool strict = false)
+{
+    return intersect(shape_with_holes_2, shape_1, strict);
+}
+
 void intersect_export_inputs(
         const std::string& file_path,
         const ShapeWithHoles& shape_with_holes_1,
@@ -140,6 +226,12 @@ bool intersect(
         const ShapeWithHoles& shape_with_holes_2,
         bool strict = false);
 
+/** See intersect(const CachedShape&, const CachedShape&, bool). */
+bool intersect(
+        const CachedShapeWithHoles& shape_with_holes_1,
+        const CachedShapeWithHoles& shape_with_holes_2,
+        bool strict = false);
+
 void intersect_export_inputs(
         const std::string& file_path,
         const ShapeWithHoles& shape_with_holes_1,
@@ -579,6 +579,7 @@ void shape::approximate_shape_by_line_segments_export_inputs(
 {
     std::ofstream file{file_path};
     nlohmann::json json;
+    json["operation"] = "approximate_shape_by_line_segments";
     json["shape"] = shape.to_json();
     json["segment_length"] = segment_length;
     json["outer"] = outer;
@@ -592,6 +593,7 @@ void shape::approximate_by_line_segments_export_inputs(
 {
     std::ofstream file{file_path};
     nlohmann::json json;
+    json["operation"] = "approximate_by_line_segments";
     json["shape_with_holes"] = shape_with_holes.to_json();
     json["segment_length"] = segment_length;
     file << std::setw(4) << json << std::endl;
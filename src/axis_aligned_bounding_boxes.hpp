@@ -0,0 +1,92 @@
+#pragma once
+
+#include "shape/shape.hpp"
+
+#include <algorithm>
+
+namespace shape
+{
+
+/**
+ * Bounding boxes stored in separate arrays of coordinates.
+ *
+ * The loops filtering many bounding boxes against a same position then read
+ * contiguous values.
+ */
+struct AxisAlignedBoundingBoxes
+{
+    std::vector<LengthDbl> x_min;
+
+    std::vector<LengthDbl> x_max;
+
+    std::vector<LengthDbl> y_min;
+
+    std::vector<LengthDbl> y_max;
+
+
+    /** Constructor. */
+    AxisAlignedBoundingBoxes() { }
+
+    /** Build the bounding boxes of given elements. */
+    AxisAlignedBoundingBoxes(const std::vector<ShapeElement>& elements)
+    {
+        reserve(elements.size());
+        for (const ShapeElement& element: elements)
+            push_back(element.min_max());
+    }
+
+    /** Build the bounding boxes of given shapes. */
+    AxisAlignedBoundingBoxes(const std::vector<ShapeWithHoles>& shapes)
+    {
+        reserve(shapes.size());
+        for (const ShapeWithHoles& shape: shapes)
+            push_back(shape.compute_min_max());
+    }
+
+    /** Get the number of bounding boxes. */
+    ElementPos size() const { return x_min.size(); }
+
+    void reserve(ElementPos size)
+    {
+        x_min.reserve(size);
+        x_max.reserve(size);
+        y_min.reserve(size);
+        y_max.reserve(size);
+    }
+
+    void push_back(const AxisAlignedBoundingBox& aabb)
+    {
+        x_min.push_back(aabb.x_min);
+        x_max.push_back(aabb.x_max);
+        y_min.push_back(aabb.y_min);
+        y_max.push_back(aabb.y_max);
+    }
+
+    /** Get a bounding box. */
+    AxisAlignedBoundingBox get(ElementPos pos) const
+    {
+        AxisAlignedBoundingBox aabb;
+        aabb.x_min = x_min[pos];
+        aabb.x_max = x_max[pos];
+        aabb.y_min = y_min[pos];
+        aabb.y_max = y_max[pos];
+        return aabb;
+    }
+
+    /** Get the bounding box of all the bounding boxes. */
+    AxisAlignedBoundingBox merge() const
+    {
+        AxisAlignedBoundingBox aabb;
+        for (LengthDbl value: x_min)
+            aabb.x_min = (std::min)(aabb.x_min, value);
+        for (LengthDbl value: x_max)
+            aabb.x_max = (std::max)(aabb.x_max, value);
+        for (LengthDbl value: y_min)
+            aabb.y_min = (std::min)(aabb.y_min, value);
+        for (LengthDbl value: y_max)
+            aabb.y_max = (std::max)(aabb.y_max, value);
+        return aabb;
+    }
+};
+
+}
@@ -11,10 +11,16 @@
 
 #include "optimizationtools/containers/doubly_indexed_map.hpp"
 
+#include "tasks.hpp"
+#include "bounding_boxes_sweep.hpp"
+
 #ifdef BOOLEAN_OPERATIONS_ENABLE_DEBUG
 #include <iostream>
 #endif
+#include <algorithm>
 #include <fstream>
+#include <memory>
+#include <numeric>
 
 using namespace shape;
 
@@ -32,6 +38,7 @@ enum class BooleanOperation
 };
 
 using ComponentId = int64_t;
+using ComponentPos = int64_t;
 
 struct SplittedElement
 {
@@ -90,6 +97,79 @@ struct ComputeSplittedElementsOutput
     optimizationtools::DoublyIndexedMap shape_component_ids;
 };
 
+/**
+ * Disjoint-set forest, with path compression and union by rank, used to merge
+ * the connected components of the input shapes.
+ *
+ * Each set also stores the identifier of its component. When two sets are
+ * merged, the component identifier of the first one is kept.
+ */
+class ComponentsUnionFind
+{
+
+public:
+
+    ComponentsUnionFind(ShapePos number_of_shapes):
+        parents_(number_of_shapes),
+        ranks_(number_of_shapes, 0),
+        component_ids_(number_of_shapes)
+    {
+        for (ShapePos shape_pos = 0;
+                shape_pos < number_of_shapes;
+                ++shape_pos) {
+            parents_[shape_pos] = shape_pos;
+            component_ids_[shape_pos] = shape_pos;
+        }
+    }
+
+    /** Get the root of the set containing a shape. */
+    ShapePos find(ShapePos shape_pos)
+    {
+        ShapePos root = shape_pos;
+        while (parents_[root] != root)
+            root = parents_[root];
+        while (parents_[shape_pos] != root) {
+            ShapePos shape_next_pos = parents_[shape_pos];
+            parents_[shape_pos] = root;
+            shape_pos = shape_next_pos;
+        }
+        return root;
+    }
+
+    /** Get the component of a shape. */
+    ComponentId component_id(ShapePos shape_pos) { return component_ids_[find(shape_pos)]; }
+
+    /** Merge the sets containing two shapes. */
+    void merge(
+            ShapePos shape_pos_1,
+            ShapePos shape_pos_2)
+    {
+        ShapePos root_1 = find(shape_pos_1);
+        ShapePos root_2 = find(shape_pos_2);
+        if (root_1 == root_2)
+            return;
+        ComponentId component_id = component_ids_[root_1];
+        if (ranks_[root_1] < ranks_[root_2])
+            std::swap(root_1, root_2);
+        parents_[root_2] = root_1;
+        if (ranks_[root_1] == ranks_[root_2])
+            ranks_[root_1]++;
+        component_ids_[root_1] = component_id;
+    }
+
+private:
+
+    /** Parent of each shape in the forest. */
+    std::vector<ShapePos> parents_;
+
+    /** Rank of each root. */
+    std::vector<ShapePos> ranks_;
+
+    /** Component identifier of each root. */
+    std::vector<ComponentId> component_ids_;
+
+};
+
 struct ElementToSplit
 {
     ShapePos orig_shape_id = -1;
@@ -265,7 +345,8 @@ void bridge_components(
 
 ComputeSplittedElementsOutput compute_splitted_elements(
         const std::vector<ShapeWithHoles>& shapes,
-        BooleanOperation boolean_operation)
+        BooleanOperation boolean_operation,
+        const BooleanOperationParameters& parameters)
 {
 #ifdef BOOLEAN_OPERATIONS_ENABLE_DEBUG
     std::cout << "compute_splitted_elements"
@@ -332,29 +413,19 @@ ComputeSplittedElementsOutput compute_splitted_elements(
     std::cout << "elements end" << std::endl;
 #endif
 
-    IntersectionTree intersection_tree({}, elements, {});
+    ComputeIntersectingElementsParameters cie_parameters;
+    cie_parameters.algorithm = parameters.intersecting_elements_algorithm;
+    cie_parameters.number_of_threads = parameters.number_of_threads;
+    cie_parameters.executor = parameters.executor;
     std::vector<ElementElementIntersection> intersections
-        = intersection_tree.compute_intersecting_elements(false);
+        = compute_intersecting_elements(elements, false, cie_parameters);
     std::vector<std::vector<Point>> elements_intersections(elements.size());
-    for (ShapePos shape_pos = 0;
-            shape_pos < (ShapePos)shapes.size();
-            ++shape_pos) {
-        output.shape_component_ids.set(shape_pos, shape_pos);
-    }
+    ComponentsUnionFind components(shapes.size());
     for (const ElementElementIntersection& intersection: intersections) {
-        // Update output.shape_component_ids.
-        ShapePos shape_pos_1 = elements_info[intersection.element_id_1].orig_shape_id;
-        ShapePos shape_pos_2 = elements_info[intersection.element_id_2].orig_shape_id;
-        ComponentId component_id_1 = output.shape_component_ids[shape_pos_1];
-        ComponentId component_id_2 = output.shape_component_ids[shape_pos_2];
-        if (component_id_1 != component_id_2) {
-            for (ShapePos shape_pos = 0;
-                    shape_pos < (ShapePos)shapes.size();
-                    ++shape_pos) {
-                if (output.shape_component_ids[shape_pos] == component_id_2)
-                    output.shape_component_ids.set(shape_pos, component_id_1);
-            }
-        }
+        // Merge the components of the two shapes.
+        components.merge(
+                elements_info[intersection.element_id_1].orig_shape_id,
+                elements_info[intersection.element_id_2].orig_shape_id);
 
         //if (!intersections.empty()) {
         //    std::cout << "element_1 " << intersection.element_id_1 << " " << elements[intersection.element_id_1].to_string() << std::endl;
@@ -376,6 +447,12 @@ ComputeSplittedElementsOutput compute_splitted_elements(
         }
     }
 
+    for (ShapePos shape_pos = 0;
+            shape_pos < (ShapePos)shapes.size();
+            ++shape_pos) {
+        output.shape_component_ids.set(shape_pos, components.component_id(shape_pos));
+    }
+
     // For each pair of connected component, check if one is strictly inside the
     // other.
     IntersectionTree intersection_tree_2(shapes, {}, {});
@@ -1019,6 +1096,7 @@ std::vector<ShapeWithHoles> compute_boolean_operation_component(
     }
     ShapePos component_num_groups = group_ids.empty()? (ShapePos)shapes.size(): num_groups;
     IntersectionTree intersection_tree(component_shapes, {}, {});
+    IntersectionTree::QueryScratch intersection_tree_scratch(intersection_tree);
 
     // Find an element from the outline.
     // To do so, we look at the rightmost node of the graph.
@@ -1189,9 +1267,10 @@ std::vector<ShapeWithHoles> compute_boolean_operation_component(
             face = remove_backtracks(face);
 
             // Real check.
-            IntersectionTree::IntersectOutput intersection_output = intersection_tree.intersect(
+            const IntersectionTree::IntersectOutput& intersection_output = intersection_tree.intersect(
                     face.find_point_strictly_inside(),
-                    false);
+                    false,
+                    intersection_tree_scratch);
             //std::cout << "intersection_output.shape_ids.size() " << intersection_output.shape_ids.size() << std::endl;
             if (intersection_output.shape_ids.empty()) {
                 //std::cout << "add hole" << std::endl;
@@ -1229,9 +1308,10 @@ std::vector<ShapeWithHoles> compute_boolean_operation_component(
             }
 
             // Real check.
-            IntersectionTree::IntersectOutput intersection_output = intersection_tree.intersect(
+            const IntersectionTree::IntersectOutput& intersection_output = intersection_tree.intersect(
                     face.find_point_strictly_inside(),
-                    false);
+                    false,
+                    intersection_tree_scratch);
             std::vector<uint8_t> real_inside_group(component_num_groups, 0);
             for (ShapePos shape_pos: intersection_output.shape_ids)
                 real_inside_group[component_group_ids[shape_pos]] = 1;
@@ -1282,9 +1362,10 @@ std::vector<ShapeWithHoles> compute_boolean_operation_component(
 
             // Real check: keep if inside at least one shape from shapes_1
             // and not inside any shape from shapes_2.
-            IntersectionTree::IntersectOutput intersection_output = intersection_tree.intersect(
+            const IntersectionTree::IntersectOutput& intersection_output = intersection_tree.intersect(
                     face.find_point_strictly_inside(),
-                    false);
+                    false,
+                    intersection_tree_scratch);
             //std::cout << "intersection_output.shape_ids.size() " << intersection_output.shape_ids.size() << std::endl;
             bool inside_shapes_1 = false;
             bool inside_shapes_2 = false;
@@ -1330,9 +1411,10 @@ std::vector<ShapeWithHoles> compute_boolean_operation_component(
                 break;
 
             // Real check: keep if inside exactly one side (XOR).
-            IntersectionTree::IntersectOutput intersection_output = intersection_tree.intersect(
+            const IntersectionTree::IntersectOutput& intersection_output = intersection_tree.intersect(
                     face.find_point_strictly_inside(),
-                    false);
+                    false,
+                    intersection_tree_scratch);
             bool inside_shapes_1 = false;
             bool inside_shapes_2 = false;
             for (ShapePos shape_pos: intersection_output.shape_ids) {
@@ -1376,7 +1458,8 @@ std::vector<ShapeWithHoles> compute_boolean_operation(
         const std::vector<ShapeWithHoles>& shapes,
         BooleanOperation boolean_operation,
         ShapePos num_shapes_1 = 1,
-        const std::vector<ShapePos>& group_ids = {})
+        const std::vector<ShapePos>& group_ids = {},
+        const BooleanOperationParameters& parameters = {})
 {
     //std::cout << "compute_boolean_operation " << (int)boolean_operation << " shapes.size() " << shapes.size() << std::endl;
     //if (boolean_operation == BooleanOperation::Difference)
@@ -1413,7 +1496,7 @@ std::vector<ShapeWithHoles> compute_boolean_operation(
 
     // Compute intersections and update the connected component of each input
     // shape.
-    ComputeSplittedElementsOutput cse_output = compute_splitted_elements(shapes, boolean_operation);
+    ComputeSplittedElementsOutput cse_output = compute_splitted_elements(shapes, boolean_operation, parameters);
 
     // Number of groups for the Intersection operation: with no explicit
     // grouping, each shape is its own group (identical to the previous,
@@ -1432,7 +1515,8 @@ std::vector<ShapeWithHoles> compute_boolean_operation(
             return output;
     }
 
-    // For each connected component.
+    // Select the connected components to process.
+    std::vector<ComponentId> component_ids;
     for (ComponentId component_id = 0;
             component_id < (ShapePos)shapes.size();
             ++component_id) {
@@ -1472,19 +1556,43 @@ std::vector<ShapeWithHoles> compute_boolean_operation(
             if (!contains_all_groups)
                 continue;
         }
-        // Compute the union of the shapes from this component.
-        //std::cout << "component_id " << component_id
-        //    << " " << cse_output.shape_component_ids.number_of_elements(component_id)
-        //    << std::endl;
-        std::vector<ShapeWithHoles> new_shapes = compute_boolean_operation_component(
-                shapes,
-                cse_output,
-                component_id,
-                boolean_operation,
-                num_shapes_1,
-                group_ids,
-                num_groups);
-        for (const ShapeWithHoles& new_shape: new_shapes)
+        component_ids.push_back(component_id);
+    }
+
+    // Process each connected component.
+    // Each task only writes the splitted elements of its own component and
+    // its own output and exception slots, so the tasks can run concurrently.
+    std::vector<std::vector<ShapeWithHoles>> components_new_shapes(component_ids.size());
+    std::vector<std::exception_ptr> components_exceptions(component_ids.size());
+    auto process_component = [&](ComponentPos component_pos)
+    {
+        try {
+            components_new_shapes[component_pos] = compute_boolean_operation_component(
+                    shapes,
+                    cse_output,
+                    component_ids[component_pos],
+                    boolean_operation,
+                    num_shapes_1,
+                    group_ids,
+                    num_groups);
+        } catch (...) {
+            components_exceptions[component_pos] = std::current_exception();
+        }
+    };
+    run_tasks(
+            component_ids.size(),
+            process_component,
+            parameters.number_of_threads,
+            parameters.executor);
+
+    // Merge the outputs in the order of the components, so that the output
+    // doesn't depend on the scheduling.
+    for (ComponentPos component_pos = 0;
+            component_pos < (ComponentPos)component_ids.size();
+            ++component_pos) {
+        if (components_exceptions[component_pos])
+            std::rethrow_exception(components_exceptions[component_pos]);
+        for (const ShapeWithHoles& new_shape: components_new_shapes[component_pos])
             output.push_back(new_shape);
     }
 
@@ -1494,17 +1602,912 @@ std::vector<ShapeWithHoles> compute_boolean_operation(
 
 }
 
+namespace
+{
+
+/**
+ * Interleave the bits of two 16-bit coordinates.
+ */
+uint32_t morton_code(
+        uint32_t x,
+        uint32_t y)
+{
+    auto spread = [](uint32_t v)
+    {
+        v = (v | (v << 8)) & 0x00FF00FF;
+        v = (v | (v << 4)) & 0x0F0F0F0F;
+        v = (v | (v << 2)) & 0x33333333;
+        v = (v | (v << 1)) & 0x55555555;
+        return v;
+    };
+    return spread(x) | (spread(y) << 1);
+}
+
+std::vector<ShapeWithHoles> compute_cascaded_union(
+        const std::vector<ShapeWithHoles>& shapes,
+        const BooleanOperationParameters& parameters)
+{
+    // Sort the shapes along a Morton curve of the centers of their bounding
+    // boxes, so that consecutive shapes are close to each other.
+    std::vector<AxisAlignedBoundingBox> aabbs;
+    AxisAlignedBoundingBox aabb;
+    for (const ShapeWithHoles& shape: shapes) {
+        aabbs.push_back(shape.compute_min_max());
+        aabb = merge(aabb, aabbs.back());
+    }
+    LengthDbl width = (std::max)(aabb.x_max - aabb.x_min, 0.0);
+    LengthDbl height = (std::max)(aabb.y_max - aabb.y_min, 0.0);
+    std::vector<std::pair<uint32_t, ShapePos>> sorted_shapes;
+    for (ShapePos shape_pos = 0;
+            shape_pos < (ShapePos)shapes.size();
+            ++shape_pos) {
+        const AxisAlignedBoundingBox& shape_aabb = aabbs[shape_pos];
+        LengthDbl x = (shape_aabb.x_min + shape_aabb.x_max) / 2 - aabb.x_min;
+        LengthDbl y = (shape_aabb.y_min + shape_aabb.y_max) / 2 - aabb.y_min;
+        uint32_t x_quantized = (width > 0)? (uint32_t)(x / width * 0xFFFF): 0;
+        uint32_t y_quantized = (height > 0)? (uint32_t)(y / height * 0xFFFF): 0;
+        sorted_shapes.push_back({morton_code(x_quantized, y_quantized), shape_pos});
+    }
+    std::sort(sorted_shapes.begin(), sorted_shapes.end());
+
+    // The nested boolean operations are run sequentially, the parallelism
+    // being on the groups and merges.
+    BooleanOperationParameters sequential_parameters;
+
+    // Union each group.
+    ShapePos group_size = parameters.cascaded_union_group_size;
+    ShapePos number_of_groups = (shapes.size() + group_size - 1) / group_size;
+    std::vector<std::vector<ShapeWithHoles>> partial_unions(number_of_groups);
+    std::vector<std::exception_ptr> exceptions(number_of_groups);
+    run_tasks(
+            number_of_groups,
+            [&](ShapePos group_pos)
+            {
+                try {
+                    std::vector<ShapeWithHoles> group_shapes;
+                    for (ShapePos pos = group_pos * group_size;
+                            pos < (std::min)((group_pos + 1) * group_size, (ShapePos)shapes.size());
+                            ++pos) {
+                        group_shapes.push_back(shapes[sorted_shapes[pos].second]);
+                    }
+                    partial_unions[group_pos] = compute_boolean_operation(
+                            group_shapes,
+                            BooleanOperation::Union,
+                            1,
+                            {},
+                            sequential_parameters);
+                } catch (...) {
+                    exceptions[group_pos] = std::current_exception();
+                }
+            },
+            parameters.number_of_threads,
+            parameters.executor);
+    for (const std::exception_ptr& exception: exceptions)
+        if (exception)
+            std::rethrow_exception(exception);
+
+    // Merge the partial results pairwise.
+    while (partial_unions.size() > 1) {
+        ShapePos number_of_merges = partial_unions.size() / 2;
+        std::vector<std::vector<ShapeWithHoles>> next_partial_unions((partial_unions.size() + 1) / 2);
+        exceptions = std::vector<std::exception_ptr>(number_of_merges);
+        run_tasks(
+                number_of_merges,
+                [&](ShapePos merge_pos)
+                {
+                    try {
+                        std::vector<ShapeWithHoles> merge_shapes = partial_unions[2 * merge_pos];
+                        merge_shapes.insert(
+                                merge_shapes.end(),
+                                partial_unions[2 * merge_pos + 1].begin(),
+                                partial_unions[2 * merge_pos + 1].end());
+                        next_partial_unions[merge_pos] = compute_boolean_operation(
+                                merge_shapes,
+                                BooleanOperation::Union,
+                                1,
+                                {},
+                                sequential_parameters);
+                    } catch (...) {
+                        exceptions[merge_pos] = std::current_exception();
+                    }
+                },
+                parameters.number_of_threads,
+                parameters.executor);
+        for (const std::exception_ptr& exception: exceptions)
+            if (exception)
+                std::rethrow_exception(exception);
+        if (partial_unions.size() % 2 == 1)
+            next_partial_unions.back() = std::move(partial_unions.back());
+        partial_unions.swap(next_partial_unions);
+    }
+    return partial_unions.front();
+}
+
+}
+
 MultiShapeWithHoles shape::compute_union(
-        const std::vector<ShapeWithHoles>& shapes)
+        const std::vector<ShapeWithHoles>& shapes,
+        const BooleanOperationParameters& parameters)
 {
     //std::cout << "compute_union " << shapes.size() << std::endl;
     //compute_union_export_inputs(
     //        "compute_union_inputs.json",
     //        shapes);
 
+    if (parameters.cascaded_union_group_size > 0
+            && (ShapePos)shapes.size() > parameters.cascaded_union_group_size) {
+        return {compute_cascaded_union(shapes, parameters)};
+    }
+
     return {compute_boolean_operation(
             shapes,
-            BooleanOperation::Union)};
+            BooleanOperation::Union,
+            1,
+            {},
+            parameters)};
+}
+
+namespace
+{
+
+/**
+ * Get the loops of the boundary of a shape, directed so that the shape is on
+ * their left: the outline anticlockwise and the holes clockwise.
+ *
+ * Full circles are split into two half circles, so that the ends of each
+ * element are distinct. The loop of a hole 'hole_pos' is at position
+ * 'hole_pos + 1', even if it is empty.
+ */
+std::vector<std::vector<ShapeElement>> compute_directed_loops(
+        const ShapeWithHoles& shape)
+{
+    std::vector<std::vector<ShapeElement>> loops;
+    for (ShapePos hole_pos = -1;
+            hole_pos < (ShapePos)shape.holes.size();
+            ++hole_pos) {
+        const Shape& loop_shape = (hole_pos == -1)?
+            shape.shape:
+            shape.holes[hole_pos];
+        std::vector<ShapeElement> loop;
+        for (const ShapeElement& element: loop_shape.elements) {
+            if (element.type == ShapeElementType::CircularArc
+                    && element.orientation == ShapeElementOrientation::Full) {
+                Point antipode = {
+                    2 * element.center.x - element.start.x,
+                    2 * element.center.y - element.start.y};
+                ShapeElement element_1 = element;
+                element_1.end = antipode;
+                element_1.orientation = ShapeElementOrientation::Anticlockwise;
+                ShapeElement element_2 = element;
+                element_2.start = antipode;
+                element_2.orientation = ShapeElementOrientation::Anticlockwise;
+                loop.push_back(element_1);
+                loop.push_back(element_2);
+            } else {
+                loop.push_back(element);
+                if (element.type == ShapeElementType::CircularArc)
+                    loop.back().center = loop.back().recompute_center();
+            }
+        }
+        AreaDbl area = loop_shape.compute_area();
+        if ((hole_pos == -1 && area < 0) || (hole_pos != -1 && area > 0)) {
+            std::reverse(loop.begin(), loop.end());
+            for (ShapeElement& element: loop)
+                element = element.reverse();
+        }
+        loops.push_back(loop);
+    }
+    return loops;
+}
+
+/** End of an element to link by split_boundary. */
+struct BoundaryEnd
+{
+    /** Position of the piece; -1 if it is an element of the boundary. */
+    ElementPos piece_pos = -1;
+
+    /** Id of the element of the boundary if 'piece_pos' is '-1'. */
+    ElementPos element_id = -1;
+
+    /** True for the end of the element, false for its start. */
+    bool end = false;
+};
+
+struct SplitBoundaryOutput
+{
+    /**
+     * Pieces of the boundary of the result, directed so that the result is
+     * on their left.
+     */
+    std::vector<ShapeElement> pieces;
+
+    /** Pairs (end of an element, start of the next element). */
+    std::vector<std::pair<BoundaryEnd, BoundaryEnd>> links;
+
+    /** False if the pieces could not be linked. */
+    bool consistent = true;
+};
+
+/**
+ * Compute the part of the boundary of a boolean operation between a region
+ * and a shape which differs from the boundary of the region.
+ *
+ * The region is given by its boundary: loops of elements directed so that
+ * the region is on their left, 'boundary_next' and 'boundary_prev' giving
+ * the next and previous element of each element. Only the elements touching
+ * the shape, 'element_ids', sorted, are split with the elements of the
+ * shape, whose loops are given directed the same way.
+ *
+ * The operation is the union, the intersection, or the difference of the
+ * region and the shape. For the union and the difference, the pieces are
+ * also linked to the elements of the boundary before and after the split
+ * ones.
+ */
+SplitBoundaryOutput split_boundary(
+        const std::function<const ShapeElement&(ElementPos)>& boundary_element,
+        const std::vector<ElementPos>& boundary_next,
+        const std::vector<ElementPos>& boundary_prev,
+        const std::vector<ElementPos>& element_ids,
+        const std::vector<std::vector<ShapeElement>>& loops,
+        const std::function<bool(const Point&)>& region_contains,
+        BooleanOperation boolean_operation)
+{
+    auto is_removed = [&element_ids](ElementPos element_id)
+    {
+        return std::binary_search(element_ids.begin(), element_ids.end(), element_id);
+    };
+
+    // Gather the elements to split: first the ones of the boundary, then the
+    // ones of the shape.
+    std::vector<ShapeElement> elements;
+    for (ElementPos element_id: element_ids)
+        elements.push_back(boundary_element(element_id));
+    ElementPos number_of_boundary_elements = elements.size();
+    for (const std::vector<ShapeElement>& loop: loops)
+        for (const ShapeElement& element: loop)
+            elements.push_back(element);
+
+    // Compute the intersections between the two sides.
+    std::vector<std::vector<Point>> elements_intersections(elements.size());
+    AxisAlignedBoundingBoxes aabbs(elements);
+    std::vector<int> sides(elements.size(), 1);
+    std::fill(sides.begin(), sides.begin() + number_of_boundary_elements, 0);
+    FixedShapeElementIntersectionsOutput intersections;
+    find_overlapping_bounding_boxes(
+            aabbs,
+            sides,
+            [&elements, &elements_intersections, &intersections](
+                ElementPos element_pos_1,
+                ElementPos element_pos_2)
+            {
+                compute_intersections(
+                        elements[element_pos_1],
+                        elements[element_pos_2],
+                        intersections);
+                std::vector<Point>& intersections_1 = elements_intersections[element_pos_1];
+                std::vector<Point>& intersections_2 = elements_intersections[element_pos_2];
+                for (ElementPos pos = 0; pos < intersections.number_of_overlapping_parts; ++pos) {
+                    const ShapeElement& overlapping_part = intersections.overlapping_parts[pos];
+                    for (const Point& point: {overlapping_part.start, overlapping_part.end}) {
+                        intersections_1.push_back(point);
+                        intersections_2.push_back(point);
+                    }
+                }
+                for (ElementPos pos = 0; pos < intersections.number_of_improper_intersections; ++pos) {
+                    intersections_1.push_back(intersections.improper_intersections[pos]);
+                    intersections_2.push_back(intersections.improper_intersections[pos]);
+                }
+                for (ElementPos pos = 0; pos < intersections.number_of_proper_intersections; ++pos) {
+                    intersections_1.push_back(intersections.proper_intersections[pos]);
+                    intersections_2.push_back(intersections.proper_intersections[pos]);
+                }
+                return false;
+            });
+
+    // Equalize points. The ends of the elements of the boundary which are
+    // kept are not moved, so the points equal to one of them are set to it.
+    std::vector<Point*> equalize_to_orig;
+    std::vector<Point> equalize_input;
+    std::vector<uint8_t> equalize_is_fixed;
+    for (ElementPos element_pos = 0;
+            element_pos < (ElementPos)elements.size();
+            ++element_pos) {
+        ShapeElement& element = elements[element_pos];
+        for (Point* point: {&element.start, &element.end}) {
+            equalize_input.push_back(*point);
+            equalize_to_orig.push_back(point);
+            equalize_is_fixed.push_back(0);
+        }
+        for (Point& intersection: elements_intersections[element_pos]) {
+            equalize_input.push_back(intersection);
+            equalize_to_orig.push_back(&intersection);
+            equalize_is_fixed.push_back(0);
+        }
+    }
+    for (ElementPos element_id: element_ids) {
+        ElementPos element_prev_id = boundary_prev[element_id];
+        if (!is_removed(element_prev_id)) {
+            equalize_input.push_back(boundary_element(element_prev_id).end);
+            equalize_to_orig.push_back(nullptr);
+            equalize_is_fixed.push_back(1);
+        }
+        ElementPos element_next_id = boundary_next[element_id];
+        if (!is_removed(element_next_id)) {
+            equalize_input.push_back(boundary_element(element_next_id).start);
+            equalize_to_orig.push_back(nullptr);
+            equalize_is_fixed.push_back(1);
+        }
+    }
+    std::vector<Point> equalize_output = equalize_points(equalize_input);
+    std::vector<ElementPos> sorted_positions(equalize_output.size());
+    std::iota(sorted_positions.begin(), sorted_positions.end(), 0);
+    std::sort(
+            sorted_positions.begin(),
+            sorted_positions.end(),
+            [&equalize_output](ElementPos pos_1, ElementPos pos_2)
+            {
+                const Point& point_1 = equalize_output[pos_1];
+                const Point& point_2 = equalize_output[pos_2];
+                if (point_1.x != point_2.x)
+                    return point_1.x < point_2.x;
+                return point_1.y < point_2.y;
+            });
+    for (ElementPos pos_first = 0;
+            pos_first < (ElementPos)sorted_positions.size();) {
+        ElementPos pos_last = pos_first;
+        ElementPos fixed_pos = -1;
+        while (pos_last < (ElementPos)sorted_positions.size()
+                && equalize_output[sorted_positions[pos_last]] == equalize_output[sorted_positions[pos_first]]) {
+            if (equalize_is_fixed[sorted_positions[pos_last]])
+                fixed_pos = sorted_positions[pos_last];
+            pos_last++;
+        }
+        for (ElementPos pos = pos_first; pos < pos_last; ++pos) {
+            ElementPos orig_pos = sorted_positions[pos];
+            if (equalize_to_orig[orig_pos] == nullptr)
+                continue;
+            *equalize_to_orig[orig_pos] = (fixed_pos != -1)?
+                equalize_input[fixed_pos]:
+                equalize_output[orig_pos];
+        }
+        pos_first = pos_last;
+    }
+
+    // Split the elements.
+    std::vector<ShapeElement> pieces;
+    ElementPos number_of_boundary_pieces = 0;
+    for (ElementPos element_pos = 0;
+            element_pos < (ElementPos)elements.size();
+            ++element_pos) {
+        if (element_pos == number_of_boundary_elements)
+            number_of_boundary_pieces = pieces.size();
+        ShapeElement element = elements[element_pos];
+        std::vector<Point>& points = elements_intersections[element_pos];
+        std::sort(
+                points.begin(),
+                points.end(),
+                [&element](
+                    const Point& point_1,
+                    const Point& point_2)
+                {
+                    return element.length(point_1) < element.length(point_2);
+                });
+        auto add_piece = [&pieces](ShapeElement piece)
+        {
+            if (equal(piece.start, piece.end))
+                return;
+            if (piece.type == ShapeElementType::CircularArc) {
+                if (piece.contains((piece.start + piece.end) / 2)) {
+                    piece.type = ShapeElementType::LineSegment;
+                } else {
+                    piece.center = piece.recompute_center();
+                }
+            }
+            pieces.push_back(piece);
+        };
+        for (const Point& point: points) {
+            if (equal(point, element.start) || equal(point, element.end))
+                continue;
+            add_piece(element.extract(element.start, point));
+            element = element.extract(point, element.end);
+        }
+        add_piece(element);
+    }
+
+    // Find the pieces of both sides which overlap: the overlapping parts have
+    // been used to split both sides, so such pieces have the same ends. If
+    // the region and the shape are on the same side of such a piece, it is
+    // on the boundary of their union and of their intersection, otherwise,
+    // it is on the boundary of their difference. It is kept once.
+    auto point_lesser = [](const Point& point_1, const Point& point_2)
+    {
+        if (point_1.x != point_2.x)
+            return point_1.x < point_2.x;
+        return point_1.y < point_2.y;
+    };
+    auto piece_ends = [&pieces, &point_lesser](ElementPos piece_pos)
+    {
+        const ShapeElement& piece = pieces[piece_pos];
+        return (point_lesser(piece.end, piece.start))?
+            std::make_pair(piece.end, piece.start):
+            std::make_pair(piece.start, piece.end);
+    };
+    auto piece_ends_lesser = [&piece_ends, &point_lesser](
+            ElementPos piece_pos_1,
+            ElementPos piece_pos_2)
+    {
+        auto ends_1 = piece_ends(piece_pos_1);
+        auto ends_2 = piece_ends(piece_pos_2);
+        if (!(ends_1.first == ends_2.first))
+            return point_lesser(ends_1.first, ends_2.first);
+        return point_lesser(ends_1.second, ends_2.second);
+    };
+    std::vector<ElementPos> sorted_new_pieces(pieces.size() - number_of_boundary_pieces);
+    std::iota(sorted_new_pieces.begin(), sorted_new_pieces.end(), number_of_boundary_pieces);
+    std::sort(sorted_new_pieces.begin(), sorted_new_pieces.end(), piece_ends_lesser);
+    // 0: to classify; 1: kept; 2: removed.
+    std::vector<uint8_t> pieces_status(pieces.size(), 0);
+    for (ElementPos piece_pos = 0;
+            piece_pos < number_of_boundary_pieces;
+            ++piece_pos) {
+        const ShapeElement& piece = pieces[piece_pos];
+        auto range = std::equal_range(
+                sorted_new_pieces.begin(),
+                sorted_new_pieces.end(),
+                piece_pos,
+                piece_ends_lesser);
+        for (auto it = range.first; it != range.second; ++it) {
+            const ShapeElement& new_piece = pieces[*it];
+            if (pieces_status[*it] != 0
+                    || !equal(piece.middle(), new_piece.middle())) {
+                continue;
+            }
+            bool same_side = (piece.start == new_piece.start);
+            bool kept = (boolean_operation == BooleanOperation::Difference)?
+                !same_side:
+                same_side;
+            pieces_status[piece_pos] = (kept)? 1: 2;
+            pieces_status[*it] = 2;
+            break;
+        }
+    }
+
+    // Classify the other pieces of each side by their position with respect
+    // to the other side. The points are located by the parity of the number
+    // of intersections with a ray, without tolerance, so that where the two
+    // sides cross, the piece leaving the crossing on one side is kept if and
+    // only if the piece of the other side is removed.
+    bool keep_boundary_inside = (boolean_operation == BooleanOperation::Intersection);
+    bool keep_shape_inside = (boolean_operation != BooleanOperation::Union);
+    for (ElementPos piece_pos = 0;
+            piece_pos < (ElementPos)pieces.size();
+            ++piece_pos) {
+        if (pieces_status[piece_pos] != 0)
+            continue;
+        Point middle = pieces[piece_pos].middle();
+        bool kept = false;
+        if (piece_pos < number_of_boundary_pieces) {
+            ElementPos number_of_intersections = 0;
+            for (ElementPos element_pos = number_of_boundary_elements;
+                    element_pos < (ElementPos)elements.size();
+                    ++element_pos) {
+                number_of_intersections += elements[element_pos].count_ray_intersections(middle);
+            }
+            kept = ((number_of_intersections % 2 == 1) == keep_boundary_inside);
+        } else {
+            kept = (region_contains(middle) == keep_shape_inside);
+        }
+        pieces_status[piece_pos] = (kept)? 1: 2;
+    }
+    SplitBoundaryOutput output;
+    for (ElementPos piece_pos = 0;
+            piece_pos < (ElementPos)pieces.size();
+            ++piece_pos) {
+        if (pieces_status[piece_pos] != 1)
+            continue;
+        if (boolean_operation == BooleanOperation::Difference
+                && piece_pos >= number_of_boundary_pieces) {
+            // The region is on the right of the elements of the shape.
+            output.pieces.push_back(pieces[piece_pos].reverse());
+        } else {
+            output.pieces.push_back(pieces[piece_pos]);
+        }
+    }
+
+    // Link the kept pieces to each other and to the elements of the boundary
+    // next to the removed ones.
+    std::vector<BoundaryEnd> ends;
+    for (ElementPos piece_pos = 0;
+            piece_pos < (ElementPos)output.pieces.size();
+            ++piece_pos) {
+        BoundaryEnd end;
+        end.piece_pos = piece_pos;
+        end.end = false;
+        ends.push_back(end);
+        end.end = true;
+        ends.push_back(end);
+    }
+    for (ElementPos element_id: element_ids) {
+        // The kept pieces of an intersection are inside the shape, so they
+        // are never linked to elements which don't touch it.
+        if (boolean_operation == BooleanOperation::Intersection)
+            break;
+        ElementPos element_prev_id = boundary_prev[element_id];
+        if (!is_removed(element_prev_id)) {
+            BoundaryEnd end;
+            end.element_id = element_prev_id;
+            end.end = true;
+            ends.push_back(end);
+        }
+        ElementPos element_next_id = boundary_next[element_id];
+        if (!is_removed(element_next_id)) {
+            BoundaryEnd end;
+            end.element_id = element_next_id;
+            end.end = false;
+            ends.push_back(end);
+        }
+    }
+    auto end_element = [&boundary_element, &output](const BoundaryEnd& end) -> const ShapeElement&
+    {
+        return (end.piece_pos != -1)?
+            output.pieces[end.piece_pos]:
+            boundary_element(end.element_id);
+    };
+    auto end_point = [&end_element](const BoundaryEnd& end) -> const Point&
+    {
+        const ShapeElement& element = end_element(end);
+        return (end.end)? element.end: element.start;
+    };
+    std::sort(
+            ends.begin(),
+            ends.end(),
+            [&end_point](
+                const BoundaryEnd& end_1,
+                const BoundaryEnd& end_2)
+            {
+                const Point& point_1 = end_point(end_1);
+                const Point& point_2 = end_point(end_2);
+                if (point_1.x != point_2.x)
+                    return point_1.x < point_2.x;
+                return point_1.y < point_2.y;
+            });
+    for (ElementPos pos_first = 0;
+            output.consistent && pos_first < (ElementPos)ends.size();) {
+        const Point& point = end_point(ends[pos_first]);
+        std::vector<ElementPos> incoming;
+        std::vector<ElementPos> outgoing;
+        ElementPos pos_last = pos_first;
+        LengthDbl l = std::numeric_limits<LengthDbl>::infinity();
+        for (; pos_last < (ElementPos)ends.size()
+                && end_point(ends[pos_last]) == point;
+                ++pos_last) {
+            if (ends[pos_last].end) {
+                incoming.push_back(pos_last);
+            } else {
+                outgoing.push_back(pos_last);
+            }
+            l = (std::min)(l, end_element(ends[pos_last]).length());
+        }
+        pos_first = pos_last;
+        if (incoming.size() != outgoing.size()) {
+            output.consistent = false;
+            break;
+        }
+        if (incoming.size() == 1) {
+            output.links.push_back({ends[incoming.front()], ends[outgoing.front()]});
+            continue;
+        }
+
+        // Several loops go through this point. Each incoming element is
+        // followed by the outgoing element with the smallest clockwise angle
+        // from its reverse direction, so that the loops don't cross.
+        l /= 2;
+        std::vector<uint8_t> outgoing_used(outgoing.size(), 0);
+        for (ElementPos pos_in: incoming) {
+            const ShapeElement& element_in = end_element(ends[pos_in]);
+            Point direction_in = element_in.point(element_in.length() - l) - point;
+            ElementPos best_pos = -1;
+            Angle best_angle = -1;
+            for (ElementPos pos = 0; pos < (ElementPos)outgoing.size(); ++pos) {
+                const ShapeElement& element_out = end_element(ends[outgoing[pos]]);
+                Point direction_out = element_out.point(l) - point;
+                Angle angle = angle_radian(direction_in, direction_out);
+                if (angle > best_angle) {
+                    best_pos = pos;
+                    best_angle = angle;
+                }
+            }
+            if (outgoing_used[best_pos]) {
+                output.consistent = false;
+                break;
+            }
+            outgoing_used[best_pos] = 1;
+            output.links.push_back({ends[pos_in], ends[outgoing[best_pos]]});
+        }
+    }
+    return output;
+}
+
+/**
+ * Build shapes from loops directed so that the shapes are on their left.
+ *
+ * The loops with a positive area are the outlines. The other ones are holes;
+ * each hole is added to the smallest outline containing it.
+ */
+MultiShapeWithHoles build_shapes_from_loops(
+        const std::vector<Shape>& loops)
+{
+    std::vector<ShapeWithHoles> outlines;
+    std::vector<AreaDbl> outlines_areas;
+    std::vector<Shape> holes;
+    for (const Shape& loop_orig: loops) {
+        Shape loop = remove_redundant_vertices(loop_orig).second;
+        loop = remove_aligned_vertices(loop).second;
+        AreaDbl area = loop.compute_area();
+        if (equal(area, 0.0))
+            continue;
+        if (area > 0) {
+            outlines.push_back({loop});
+            outlines_areas.push_back(area);
+        } else {
+            holes.push_back(loop.reverse());
+        }
+    }
+
+    MultiShapeWithHoles output;
+    output.shapes_with_holes = outlines;
+    if (holes.empty())
+        return output;
+    if (outlines.empty()) {
+        throw std::logic_error(
+                FUNC_SIGNATURE + ": "
+                "no outline contains a hole.");
+    }
+    if (outlines.size() == 1) {
+        output.shapes_with_holes.front().holes = holes;
+        return output;
+    }
+    IntersectionTree intersection_tree(outlines, {}, {});
+    for (const Shape& hole: holes) {
+        IntersectionTree::IntersectOutput it_output = intersection_tree.intersect(
+                hole.elements.front().middle(),
+                false);
+        ShapePos outline_pos = -1;
+        for (ShapePos shape_id: it_output.shape_ids) {
+            if (outline_pos == -1
+                    || outlines_areas[shape_id] < outlines_areas[outline_pos]) {
+                outline_pos = shape_id;
+            }
+        }
+        if (outline_pos == -1) {
+            throw std::logic_error(
+                    FUNC_SIGNATURE + ": "
+                    "no outline contains a hole.");
+        }
+        output.shapes_with_holes[outline_pos].holes.push_back(hole);
+    }
+    return output;
+}
+
+/**
+ * Follow the loops going through the pieces returned by split_boundary.
+ *
+ * Between two pieces, a loop might follow elements of the boundary which
+ * have not been split.
+ */
+std::vector<Shape> follow_split_boundary_loops(
+        const SplitBoundaryOutput& split_output,
+        const std::function<const ShapeElement&(ElementPos)>& boundary_element,
+        const std::vector<ElementPos>& boundary_next)
+{
+    std::vector<BoundaryEnd> pieces_next(split_output.pieces.size());
+    std::vector<std::pair<ElementPos, BoundaryEnd>> elements_next;
+    for (const auto& link: split_output.links) {
+        if (link.first.piece_pos != -1) {
+            pieces_next[link.first.piece_pos] = link.second;
+        } else {
+            elements_next.push_back({link.first.element_id, link.second});
+        }
+    }
+    std::sort(
+            elements_next.begin(),
+            elements_next.end(),
+            [](const std::pair<ElementPos, BoundaryEnd>& link_1,
+                const std::pair<ElementPos, BoundaryEnd>& link_2)
+            {
+                return link_1.first < link_2.first;
+            });
+
+    std::vector<Shape> loops;
+    ElementPos loop_size_max = split_output.pieces.size() + boundary_next.size();
+    std::vector<uint8_t> piece_is_processed(split_output.pieces.size(), 0);
+    for (ElementPos piece_pos = 0;
+            piece_pos < (ElementPos)split_output.pieces.size();
+            ++piece_pos) {
+        if (piece_is_processed[piece_pos])
+            continue;
+        Shape loop;
+        BoundaryEnd current;
+        current.piece_pos = piece_pos;
+        for (;;) {
+            if (current.piece_pos != -1) {
+                if (piece_is_processed[current.piece_pos])
+                    break;
+                piece_is_processed[current.piece_pos] = 1;
+                loop.elements.push_back(split_output.pieces[current.piece_pos]);
+                current = pieces_next[current.piece_pos];
+            } else {
+                loop.elements.push_back(boundary_element(current.element_id));
+                auto it = std::lower_bound(
+                        elements_next.begin(),
+                        elements_next.end(),
+                        current.element_id,
+                        [](const std::pair<ElementPos, BoundaryEnd>& link,
+                            ElementPos element_id)
+                        {
+                            return link.first < element_id;
+                        });
+                if (it != elements_next.end()
+                        && it->first == current.element_id) {
+                    current = it->second;
+                } else {
+                    current.element_id = boundary_next[current.element_id];
+                }
+            }
+            if ((ElementPos)loop.elements.size() > loop_size_max) {
+                throw std::logic_error(
+                        FUNC_SIGNATURE + ": "
+                        "a loop doesn't close.");
+            }
+        }
+        loops.push_back(loop);
+    }
+    return loops;
+}
+
+}
+
+ElementPos UnionAccumulator::insert_element(const ShapeElement& element)
+{
+    ElementPos element_id = boundary_.insert(element);
+    if (element_id >= (ElementPos)boundary_next_.size()) {
+        boundary_next_.resize(element_id + 1, -1);
+        boundary_prev_.resize(element_id + 1, -1);
+    }
+    return element_id;
+}
+
+void UnionAccumulator::insert_loops(
+        const std::vector<std::vector<ShapeElement>>& loops)
+{
+    for (const std::vector<ShapeElement>& loop: loops) {
+        std::vector<ElementPos> element_ids;
+        for (const ShapeElement& element: loop)
+            element_ids.push_back(insert_element(element));
+        for (ElementPos pos = 0; pos < (ElementPos)element_ids.size(); ++pos) {
+            ElementPos element_id = element_ids[pos];
+            ElementPos element_next_id = element_ids[(pos + 1) % element_ids.size()];
+            boundary_next_[element_id] = element_next_id;
+            boundary_prev_[element_next_id] = element_id;
+        }
+    }
+    result_is_up_to_date_ = false;
+}
+
+bool UnionAccumulator::union_contains(const Point& point) const
+{
+    // Count the intersections of the boundary with a ray going rightward.
+    ShapeElement ray;
+    ray.type = ShapeElementType::LineSegment;
+    ray.start = point;
+    ray.end = {x_max_ + 1, point.y};
+    ElementPos number_of_intersections = 0;
+    for (ElementPos element_id: boundary_.intersect(ray, false).element_ids)
+        number_of_intersections += boundary_.element(element_id).count_ray_intersections(point);
+    return (number_of_intersections % 2 == 1);
+}
+
+void UnionAccumulator::rebuild(const ShapeWithHoles& shape)
+{
+    std::vector<ShapeWithHoles> union_input = result().shapes_with_holes;
+    union_input.push_back(shape);
+    MultiShapeWithHoles union_output = compute_union(union_input, parameters_);
+
+    boundary_ = DynamicIntersectionTree();
+    boundary_next_.clear();
+    boundary_prev_.clear();
+    for (const ShapeWithHoles& new_shape: union_output.shapes_with_holes)
+        insert_loops(compute_directed_loops(new_shape));
+    result_ = union_output;
+    result_is_up_to_date_ = true;
+}
+
+void UnionAccumulator::add(const ShapeWithHoles& shape)
+{
+    if (shape.shape.elements.empty()) {
+        throw std::invalid_argument(
+                FUNC_SIGNATURE + ": "
+                "the outline of the shape must not be empty.");
+    }
+    number_of_splitted_elements_ = 0;
+    x_max_ = (std::max)(x_max_, shape.compute_min_max().x_max);
+    std::vector<std::vector<ShapeElement>> loops = compute_directed_loops(shape);
+
+    // Find the elements of the boundary which touch the new shape.
+    std::vector<ElementPos> element_ids = boundary_.intersect(shape, false).element_ids;
+    if (element_ids.empty()) {
+        // The new shape is either inside the current union or disjoint from
+        // it.
+        if (!union_contains(loops.front().front().start))
+            insert_loops(loops);
+        return;
+    }
+    number_of_splitted_elements_ = element_ids.size();
+    std::sort(element_ids.begin(), element_ids.end());
+    SplitBoundaryOutput split_output = split_boundary(
+            [this](ElementPos element_id) -> const ShapeElement& { return boundary_.element(element_id); },
+            boundary_next_,
+            boundary_prev_,
+            element_ids,
+            loops,
+            [this](const Point& point) { return union_contains(point); },
+            BooleanOperation::Union);
+    if (!split_output.consistent) {
+        // The pieces can't be linked, which happens when nearly tangent
+        // elements are not split consistently; fall back to computing the
+        // union from scratch.
+        rebuild(shape);
+        return;
+    }
+
+    // Update the boundary.
+    for (ElementPos element_id: element_ids)
+        boundary_.remove_element(element_id);
+    std::vector<ElementPos> pieces_ids;
+    for (const ShapeElement& piece: split_output.pieces)
+        pieces_ids.push_back(insert_element(piece));
+    auto end_element_id = [&pieces_ids](const BoundaryEnd& end)
+    {
+        return (end.piece_pos != -1)?
+            pieces_ids[end.piece_pos]:
+            end.element_id;
+    };
+    for (const auto& link: split_output.links) {
+        ElementPos element_id = end_element_id(link.first);
+        ElementPos element_next_id = end_element_id(link.second);
+        boundary_next_[element_id] = element_next_id;
+        boundary_prev_[element_next_id] = element_id;
+    }
+    result_is_up_to_date_ = false;
+}
+
+const MultiShapeWithHoles& UnionAccumulator::result() const
+{
+    if (result_is_up_to_date_)
+        return result_;
+
+    // Follow the loops of the boundary.
+    std::vector<Shape> loops;
+    std::vector<uint8_t> element_is_processed(boundary_next_.size(), 0);
+    for (ElementPos element_id = 0;
+            element_id < (ElementPos)boundary_next_.size();
+            ++element_id) {
+        if (!boundary_.contains_element(element_id)
+                || element_is_processed[element_id]) {
+            continue;
+        }
+        Shape loop;
+        for (ElementPos element_cur_id = element_id;
+                !element_is_processed[element_cur_id];
+                element_cur_id = boundary_next_[element_cur_id]) {
+            element_is_processed[element_cur_id] = 1;
+            loop.elements.push_back(boundary_.element(element_cur_id));
+        }
+        loops.push_back(loop);
+    }
+    result_ = build_shapes_from_loops(loops);
+    result_is_up_to_date_ = true;
+    return result_;
 }
 
 void shape::compute_union_export_inputs(
@@ -1513,6 +2516,7 @@ void shape::compute_union_export_inputs(
 {
     std::ofstream file{file_path};
     nlohmann::json json;
+    json["operation"] = "compute_union";
     for (ShapePos shape_pos = 0;
             shape_pos < (ShapePos)shapes.size();
             ++shape_pos) {
@@ -1522,12 +2526,16 @@ void shape::compute_union_export_inputs(
 }
 
 MultiShapeWithHoles shape::compute_intersection(
-        const std::vector<ShapeWithHoles>& shapes)
+        const std::vector<ShapeWithHoles>& shapes,
+        const BooleanOperationParameters& parameters)
 {
     std::vector<ShapeWithHoles> faces = compute_boolean_operation(
             shapes,
-            BooleanOperation::Intersection);
-    return compute_union(faces);
+            BooleanOperation::Intersection,
+            1,
+            {},
+            parameters);
+    return compute_union(faces, parameters);
 }
 
 void shape::compute_intersection_export_inputs(
@@ -1536,6 +2544,7 @@ void shape::compute_intersection_export_inputs(
 {
     std::ofstream file{file_path};
     nlohmann::json json;
+    json["operation"] = "compute_intersection";
     for (ShapePos shape_pos = 0;
             shape_pos < (ShapePos)shapes.size();
             ++shape_pos) {
@@ -1584,17 +2593,390 @@ MultiShapeWithHoles shape::compute_intersection(
     return compute_intersection(std::vector<ShapeWithHoles>{shape_1, shape_2});
 }
 
+namespace
+{
+
+/**
+ * Element of the boundary of a shape used to compute intersection areas.
+ */
+struct AreaElement
+{
+    /** Element, in the direction of the loop. */
+    ShapeElement element;
+
+    /** Position of the shape, 0 or 1. */
+    ShapePos shape_pos;
+
+    /** True if the element belongs to a hole. */
+    bool hole;
+
+    /** True if the next element starts the loop again. */
+    bool last;
+};
+
+/**
+ * Intersection point on an element used to compute intersection areas.
+ */
+struct AreaIntersection
+{
+    /** Intersection point. */
+    Point point;
+
+    /** True if the boundaries cross at this point. */
+    bool proper;
+};
+
+/**
+ * Compute twice the area swept by an element around the origin.
+ */
+AreaDbl compute_area_contribution(const ShapeElement& element)
+{
+    if (element.type == ShapeElementType::CircularArc
+            && element.orientation == ShapeElementOrientation::Full) {
+        LengthDbl radius = element.radius();
+        return 2 * M_PI * radius * radius;
+    }
+    AreaDbl area = cross_product(element.start, element.end);
+    if (element.type == ShapeElementType::CircularArc) {
+        LengthDbl radius = element.radius();
+        if (element.orientation == ShapeElementOrientation::Anticlockwise) {
+            Angle theta = angle_radian(element.center - element.start, element.center - element.end);
+            area += radius * radius * (theta - std::sin(theta));
+        } else {
+            Angle theta = angle_radian(element.center - element.end, element.center - element.start);
+            area -= radius * radius * (theta - std::sin(theta));
+        }
+    }
+    return area;
+}
+
+/**
+ * Position of a part of the boundary of a shape with respect to the other
+ * shape.
+ */
+enum class AreaElementPosition
+{
+    Outside,
+    Inside,
+    SameSideBoundary,
+    OppositeSideBoundary,
+};
+
+/**
+ * Shape against which the parts of the boundary of the other shape are
+ * classified.
+ *
+ * The first points are checked with ShapeWithHoles::contains, which is
+ * linear in the number of elements of the shape. Since most pairs of shapes
+ * only need a few checks, a PreparedShape is only built once
+ * 'prepare_threshold' points have been checked; the following checks then
+ * don't depend on the number of elements of the shape.
+ */
+struct AreaShape
+{
+    /** Number of checks after which the shape is prepared. */
+    static constexpr Counter prepare_threshold = 16;
+
+    /** Shape. */
+    const ShapeWithHoles& shape;
+
+    /** Prepared shape, once built. */
+    std::unique_ptr<PreparedShape> prepared_shape;
+
+    /** Number of points checked with ShapeWithHoles::contains. */
+    Counter number_of_checks = 0;
+
+
+    /** Constructor. */
+    AreaShape(const ShapeWithHoles& shape): shape(shape) { }
+
+    /** Check if the shape contains a given point. */
+    bool contains(const Point& point)
+    {
+        if (prepared_shape == nullptr) {
+            if (number_of_checks < prepare_threshold) {
+                number_of_checks++;
+                return shape.contains(point);
+            }
+            prepared_shape.reset(new PreparedShape(shape));
+        }
+        return prepared_shape->contains(point);
+    }
+};
+
+/**
+ * Compute the position of a part of the boundary of a shape with respect to
+ * the other shape.
+ *
+ * 'intersection_tree' is the tree of the elements of the other shape,
+ * 'elements' its elements.
+ */
+AreaElementPosition compute_area_element_position(
+        const IntersectionTree& intersection_tree,
+        IntersectionTree::QueryScratch& scratch,
+        const std::vector<AreaElement>& elements,
+        AreaShape& shape,
+        const ShapeElement& part,
+        bool hole)
+{
+    Point point = (part.type == ShapeElementType::CircularArc
+            && part.orientation == ShapeElementOrientation::Full)?
+        part.start:
+        part.middle();
+    const std::vector<ShapePos>& element_ids = intersection_tree.intersect(
+            point,
+            false,
+            scratch).element_ids;
+    if (!element_ids.empty()) {
+        // The part lies on the boundary of the shape. The interior of a shape
+        // is on the left of its outline and on the right of its holes.
+        const AreaElement& area_element = elements[*std::min_element(
+                element_ids.begin(),
+                element_ids.end())];
+        bool same_direction = dot_product(
+                area_element.element.tangent(point),
+                part.tangent(point)) > 0;
+        return (same_direction == (area_element.hole == hole))?
+            AreaElementPosition::SameSideBoundary:
+            AreaElementPosition::OppositeSideBoundary;
+    }
+    return (shape.contains(point))?
+        AreaElementPosition::Inside:
+        AreaElementPosition::Outside;
+}
+
+}
+
+AreaDbl shape::compute_intersection_area(
+        const ShapeWithHoles& shape_1,
+        const ShapeWithHoles& shape_2)
+{
+    AxisAlignedBoundingBox aabb_1 = shape_1.compute_min_max();
+    AxisAlignedBoundingBox aabb_2 = shape_2.compute_min_max();
+    if (strictly_lesser(aabb_1.x_max, aabb_2.x_min)
+            || strictly_greater(aabb_1.x_min, aabb_2.x_max)
+            || strictly_lesser(aabb_1.y_max, aabb_2.y_min)
+            || strictly_greater(aabb_1.y_min, aabb_2.y_max)) {
+        return 0.0;
+    }
+
+    // Gather the elements of each shape.
+    std::vector<AreaElement> area_elements[2];
+    std::vector<ShapeElement> elements[2];
+    for (ShapePos shape_pos = 0; shape_pos < 2; ++shape_pos) {
+        const ShapeWithHoles& shape = (shape_pos == 0)? shape_1: shape_2;
+        for (ShapePos hole_pos = -1;
+                hole_pos < (ShapePos)shape.holes.size();
+                ++hole_pos) {
+            const Shape& loop = (hole_pos == -1)?
+                shape.shape:
+                shape.holes[hole_pos];
+            for (ElementPos element_pos = 0;
+                    element_pos < (ElementPos)loop.elements.size();
+                    ++element_pos) {
+                AreaElement area_element;
+                area_element.element = loop.elements[element_pos];
+                area_element.shape_pos = shape_pos;
+                area_element.hole = (hole_pos != -1);
+                area_element.last = (element_pos == (ElementPos)loop.elements.size() - 1);
+                area_elements[shape_pos].push_back(area_element);
+                elements[shape_pos].push_back(area_element.element);
+            }
+        }
+    }
+
+    // Compute the intersections between the elements of the two shapes. The
+    // elements of the first shape are queried in the tree of the elements of
+    // the second one.
+    IntersectionTree intersection_trees[2] = {
+        IntersectionTree({}, elements[0], {}),
+        IntersectionTree({}, elements[1], {})};
+    std::vector<std::vector<AreaIntersection>> elements_intersections[2] = {
+        std::vector<std::vector<AreaIntersection>>(elements[0].size()),
+        std::vector<std::vector<AreaIntersection>>(elements[1].size())};
+    IntersectionTree::IntersectBatchOutput candidates
+        = intersection_trees[1].intersect_batch(elements[0], false);
+    for (ElementPos element_id_1 = 0;
+            element_id_1 < (ElementPos)elements[0].size();
+            ++element_id_1) {
+        for (ElementPos pos = candidates.element_offsets[element_id_1];
+                pos < candidates.element_offsets[element_id_1 + 1];
+                ++pos) {
+            ElementPos element_id_2 = candidates.element_ids[pos];
+            ShapeElementIntersectionsOutput intersections = compute_intersections(
+                    elements[0][element_id_1],
+                    elements[1][element_id_2]);
+            for (std::vector<AreaIntersection>* element_intersections: {
+                    &elements_intersections[0][element_id_1],
+                    &elements_intersections[1][element_id_2]}) {
+                for (const ShapeElement& overlapping_part: intersections.overlapping_parts) {
+                    element_intersections->push_back({overlapping_part.start, false});
+                    element_intersections->push_back({overlapping_part.end, false});
+                }
+                for (const Point& point: intersections.improper_intersections)
+                    element_intersections->push_back({point, false});
+                for (const Point& point: intersections.proper_intersections)
+                    element_intersections->push_back({point, true});
+            }
+        }
+    }
+
+    // The parts of the boundaries are classified with the tree of the
+    // elements of the other shape.
+    AreaShape area_shapes[2] = {shape_1, shape_2};
+    IntersectionTree::QueryScratch scratches[2] = {
+        IntersectionTree::QueryScratch(intersection_trees[0]),
+        IntersectionTree::QueryScratch(intersection_trees[1])};
+
+    // Walk along each loop. The position of the parts with respect to the
+    // other shape only changes at intersection points. At a proper
+    // intersection, the boundary crosses the other one, so the position
+    // switches between inside and outside; after the other intersection
+    // points, it is computed again.
+    AreaDbl area = 0.0;
+    AreaElementPosition position = AreaElementPosition::Outside;
+    bool update_position = true;
+    for (ShapePos shape_pos = 0; shape_pos < 2; ++shape_pos) {
+        ShapePos other_shape_pos = 1 - shape_pos;
+        for (ElementPos element_pos = 0;
+                element_pos < (ElementPos)area_elements[shape_pos].size();
+                ++element_pos) {
+            const AreaElement& area_element = area_elements[shape_pos][element_pos];
+            ShapeElement element = area_element.element;
+            std::vector<AreaIntersection>& intersections = elements_intersections[shape_pos][element_pos];
+
+            auto add_part = [&](const ShapeElement& part)
+            {
+                if (update_position) {
+                    position = compute_area_element_position(
+                            intersection_trees[other_shape_pos],
+                            scratches[other_shape_pos],
+                            area_elements[other_shape_pos],
+                            area_shapes[other_shape_pos],
+                            part,
+                            area_element.hole);
+                    update_position = false;
+                }
+                // Parts of the boundaries of both shapes are counted once, with
+                // the first shape.
+                if (position == AreaElementPosition::Inside
+                        || (position == AreaElementPosition::SameSideBoundary
+                            && area_element.shape_pos == 0)) {
+                    AreaDbl contribution = compute_area_contribution(part);
+                    area += (area_element.hole)? -contribution: contribution;
+                }
+            };
+
+            if (element.type == ShapeElementType::CircularArc
+                    && element.orientation == ShapeElementOrientation::Full
+                    && !intersections.empty()) {
+                // Turn the circle into an arc starting at an intersection point.
+                const Point point = intersections.front().point;
+                if (std::all_of(
+                            intersections.begin(),
+                            intersections.end(),
+                            [&point](const AreaIntersection& intersection) { return equal(intersection.point, point); })) {
+                    intersections.push_back({{
+                            2 * element.center.x - point.x,
+                            2 * element.center.y - point.y}, false});
+                }
+                element.start = point;
+                element.end = point;
+                element.orientation = ShapeElementOrientation::Anticlockwise;
+                update_position = true;
+            }
+            std::sort(
+                    intersections.begin(),
+                    intersections.end(),
+                    [&element](
+                        const AreaIntersection& intersection_1,
+                        const AreaIntersection& intersection_2)
+                    {
+                        return element.length(intersection_1.point) < element.length(intersection_2.point);
+                    });
+
+            bool end_intersection = false;
+            for (ElementPos intersection_pos = 0;
+                    intersection_pos < (ElementPos)intersections.size();
+                    ) {
+                // Group the equal intersection points.
+                const Point& point = intersections[intersection_pos].point;
+                ElementPos next_intersection_pos = intersection_pos + 1;
+                while (next_intersection_pos < (ElementPos)intersections.size()
+                        && equal(intersections[next_intersection_pos].point, point)) {
+                    next_intersection_pos++;
+                }
+                bool crossing = (next_intersection_pos == intersection_pos + 1
+                        && intersections[intersection_pos].proper);
+                intersection_pos = next_intersection_pos;
+
+                if (equal(point, element.start)) {
+                    update_position = true;
+                    continue;
+                }
+                if (equal(point, element.end)) {
+                    end_intersection = true;
+                    continue;
+                }
+                ShapeElement part = element.extract(element.start, point);
+                element = element.extract(point, element.end);
+                add_part(part);
+                if (crossing && position == AreaElementPosition::Inside) {
+                    position = AreaElementPosition::Outside;
+                } else if (crossing && position == AreaElementPosition::Outside) {
+                    position = AreaElementPosition::Inside;
+                } else {
+                    update_position = true;
+                }
+            }
+            add_part(element);
+            update_position = area_element.last || end_intersection;
+        }
+    }
+    return area / 2;
+}
+
+std::vector<AreaDbl> shape::compute_intersection_area(
+        const std::vector<ShapeWithHoles>& shapes,
+        const std::vector<std::pair<ShapePos, ShapePos>>& pairs,
+        const BooleanOperationParameters& parameters)
+{
+    std::vector<AreaDbl> output(pairs.size(), 0.0);
+    std::vector<std::exception_ptr> exceptions(pairs.size());
+    run_tasks(
+            pairs.size(),
+            [&](ComponentPos pair_pos)
+            {
+                try {
+                    output[pair_pos] = compute_intersection_area(
+                            shapes[pairs[pair_pos].first],
+                            shapes[pairs[pair_pos].second]);
+                } catch (...) {
+                    exceptions[pair_pos] = std::current_exception();
+                }
+            },
+            parameters.number_of_threads,
+            parameters.executor);
+    for (const std::exception_ptr& exception: exceptions)
+        if (exception)
+            std::rethrow_exception(exception);
+    return output;
+}
+
 MultiShapeWithHoles shape::compute_difference(
         const MultiShapeWithHoles& shapes_1,
-        const MultiShapeWithHoles& shapes_2)
+        const MultiShapeWithHoles& shapes_2,
+        const BooleanOperationParameters& parameters)
 {
     std::vector<ShapeWithHoles> v = shapes_1.shapes_with_holes;
     v.insert(v.end(), shapes_2.shapes_with_holes.begin(), shapes_2.shapes_with_holes.end());
     std::vector<ShapeWithHoles> faces = compute_boolean_operation(
             v,
             BooleanOperation::Difference,
-            shapes_1.shapes_with_holes.size());
-    return compute_union(faces);
+            shapes_1.shapes_with_holes.size(),
+            {},
+            parameters);
+    return compute_union(faces, parameters);
 }
 
 MultiShapeWithHoles shape::compute_difference(
@@ -1608,15 +2990,18 @@ MultiShapeWithHoles shape::compute_difference(
 
 MultiShapeWithHoles shape::compute_symmetric_difference(
         const MultiShapeWithHoles& shapes_1,
-        const MultiShapeWithHoles& shapes_2)
+        const MultiShapeWithHoles& shapes_2,
+        const BooleanOperationParameters& parameters)
 {
     std::vector<ShapeWithHoles> v = shapes_1.shapes_with_holes;
     v.insert(v.end(), shapes_2.shapes_with_holes.begin(), shapes_2.shapes_with_holes.end());
     std::vector<ShapeWithHoles> faces = compute_boolean_operation(
             v,
             BooleanOperation::SymmetricDifference,
-            shapes_1.shapes_with_holes.size());
-    return compute_union(faces);
+            shapes_1.shapes_with_holes.size(),
+            {},
+            parameters);
+    return compute_union(faces, parameters);
 }
 
 MultiShapeWithHoles shape::compute_symmetric_difference(
@@ -1628,6 +3013,277 @@ MultiShapeWithHoles shape::compute_symmetric_difference(
             MultiShapeWithHoles{{shape_2}});
 }
 
+namespace
+{
+
+/**
+ * Check if two bounding boxes intersect or touch.
+ */
+bool intersect_or_touch(
+        const AxisAlignedBoundingBox& aabb_1,
+        const AxisAlignedBoundingBox& aabb_2)
+{
+    return !strictly_lesser(aabb_1.x_max, aabb_2.x_min)
+        && !strictly_greater(aabb_1.x_min, aabb_2.x_max)
+        && !strictly_lesser(aabb_1.y_max, aabb_2.y_min)
+        && !strictly_greater(aabb_1.y_min, aabb_2.y_max);
+}
+
+std::vector<AxisAlignedBoundingBox> build_aabb_tree(
+        const std::vector<AxisAlignedBoundingBox>& aabbs)
+{
+    ElementPos n = aabbs.size();
+    std::vector<AxisAlignedBoundingBox> tree(2 * n);
+    std::copy(aabbs.begin(), aabbs.end(), tree.begin() + n);
+    for (ElementPos node_id = n - 1; node_id >= 1; --node_id)
+        tree[node_id] = merge(tree[2 * node_id], tree[2 * node_id + 1]);
+    return tree;
+}
+
+std::vector<ElementPos> find_in_aabb_tree(
+        const std::vector<AxisAlignedBoundingBox>& tree,
+        const AxisAlignedBoundingBox& aabb)
+{
+    std::vector<ElementPos> output;
+    ElementPos n = tree.size() / 2;
+    if (n == 0)
+        return output;
+    std::vector<ElementPos> stack = {1};
+    while (!stack.empty()) {
+        ElementPos node_id = stack.back();
+        stack.pop_back();
+        if (!intersect_or_touch(tree[node_id], aabb))
+            continue;
+        if (node_id >= n) {
+            output.push_back(node_id - n);
+        } else {
+            stack.push_back(2 * node_id + 1);
+            stack.push_back(2 * node_id);
+        }
+    }
+    std::sort(output.begin(), output.end());
+    return output;
+}
+
+}
+
+PreparedShape::PreparedShape(const ShapeWithHoles& shape):
+    shape_(shape),
+    aabb_(shape.compute_min_max()),
+    outline_locator_(shape.shape)
+{
+    std::vector<AxisAlignedBoundingBox> aabbs;
+    for (const ShapeElement& element: shape_.shape.elements)
+        aabbs.push_back(element.min_max());
+    outline_elements_tree_ = build_aabb_tree(aabbs);
+
+    aabbs.clear();
+    for (const Shape& hole: shape_.holes)
+        aabbs.push_back(hole.compute_min_max());
+    holes_tree_ = build_aabb_tree(aabbs);
+
+    for (const Shape& hole: shape_.holes)
+        holes_locators_.push_back(PointLocator(hole));
+
+    std::vector<std::vector<ShapeElement>> loops = compute_directed_loops(shape_);
+    for (ShapePos loop_pos = 0;
+            loop_pos < (ShapePos)loops.size();
+            ++loop_pos) {
+        ElementPos offset = boundary_elements_.size();
+        boundary_loops_offsets_.push_back(offset);
+        const std::vector<ShapeElement>& loop = loops[loop_pos];
+        for (ElementPos pos = 0; pos < (ElementPos)loop.size(); ++pos) {
+            boundary_elements_.push_back(loop[pos]);
+            boundary_next_.push_back(offset + (pos + 1) % loop.size());
+            boundary_prev_.push_back(offset + (pos + loop.size() - 1) % loop.size());
+            boundary_loops_.push_back(loop_pos);
+        }
+    }
+    boundary_loops_offsets_.push_back(boundary_elements_.size());
+    aabbs.clear();
+    for (const ShapeElement& element: boundary_elements_)
+        aabbs.push_back(element.min_max());
+    boundary_elements_tree_ = build_aabb_tree(aabbs);
+}
+
+std::vector<ElementPos> PreparedShape::find_outline_elements(
+        const AxisAlignedBoundingBox& aabb) const
+{
+    return find_in_aabb_tree(outline_elements_tree_, aabb);
+}
+
+std::vector<ShapePos> PreparedShape::find_holes(
+        const AxisAlignedBoundingBox& aabb) const
+{
+    return find_in_aabb_tree(holes_tree_, aabb);
+}
+
+bool PreparedShape::contains(
+        const Point& point,
+        bool strict) const
+{
+    if (!outline_locator_.contains(point, strict))
+        return false;
+    // Only the holes whose bounding box contains the point might contain it.
+    AxisAlignedBoundingBox aabb;
+    aabb.x_min = point.x - bounding_box_margin;
+    aabb.x_max = point.x + bounding_box_margin;
+    aabb.y_min = point.y - bounding_box_margin;
+    aabb.y_max = point.y + bounding_box_margin;
+    for (ShapePos hole_pos: find_holes(aabb))
+        if (holes_locators_[hole_pos].contains(point, !strict))
+            return false;
+    return true;
+}
+
+std::vector<ElementPos> PreparedShape::find_boundary_elements(
+        const ShapeWithHoles& shape,
+        const AxisAlignedBoundingBox& aabb) const
+{
+    std::vector<ElementPos> element_ids;
+    for (ElementPos element_id: find_in_aabb_tree(boundary_elements_tree_, aabb))
+        if (intersect(shape, boundary_elements_[element_id], false))
+            element_ids.push_back(element_id);
+    return element_ids;
+}
+
+Shape PreparedShape::boundary_loop(ShapePos loop_pos) const
+{
+    Shape loop;
+    loop.elements.assign(
+            boundary_elements_.begin() + boundary_loops_offsets_[loop_pos],
+            boundary_elements_.begin() + boundary_loops_offsets_[loop_pos + 1]);
+    return loop;
+}
+
+MultiShapeWithHoles shape::compute_intersection(
+        const PreparedShape& shape_1,
+        const ShapeWithHoles& shape_2,
+        const BooleanOperationParameters& parameters)
+{
+    const ShapeWithHoles& shape = shape_1.shape();
+    AxisAlignedBoundingBox aabb = shape_2.compute_min_max();
+    if (!intersect_or_touch(shape_1.min_max(), aabb))
+        return {};
+
+    // Find the elements of the boundary which touch shape_2.
+    std::vector<ElementPos> element_ids = shape_1.find_boundary_elements(shape_2, aabb);
+    if (element_ids.empty()) {
+        // shape_2 is either inside shape_1 or outside it.
+        if (!shape_1.contains(shape_2.shape.elements.front().start))
+            return {};
+        return {{shape_2}};
+    }
+
+    SplitBoundaryOutput split_output = split_boundary(
+            [&shape_1](ElementPos element_id) -> const ShapeElement& { return shape_1.boundary_elements_[element_id]; },
+            shape_1.boundary_next_,
+            shape_1.boundary_prev_,
+            element_ids,
+            compute_directed_loops(shape_2),
+            [&shape_1](const Point& point) { return shape_1.contains(point); },
+            BooleanOperation::Intersection);
+    if (!split_output.consistent) {
+        // Nearly tangent elements have not been split consistently; fall back
+        // to the intersection with the whole shape.
+        return compute_intersection(
+                std::vector<ShapeWithHoles>{shape, shape_2},
+                parameters);
+    }
+    std::vector<Shape> loops = follow_split_boundary_loops(
+            split_output,
+            [&shape_1](ElementPos element_id) -> const ShapeElement& { return shape_1.boundary_elements_[element_id]; },
+            shape_1.boundary_next_);
+
+    // The loops of the boundary which don't touch shape_2 belong to the
+    // intersection if they are inside it. Only the outline and the holes
+    // close to shape_2 might be.
+    std::vector<uint8_t> loop_is_touched(shape.holes.size() + 1, 0);
+    for (ElementPos element_id: element_ids)
+        loop_is_touched[shape_1.boundary_loops_[element_id]] = 1;
+    std::vector<ShapePos> loop_ids = {0};
+    for (ShapePos hole_pos: shape_1.find_holes(aabb))
+        loop_ids.push_back(hole_pos + 1);
+    for (ShapePos loop_pos: loop_ids) {
+        if (loop_is_touched[loop_pos])
+            continue;
+        Shape loop = shape_1.boundary_loop(loop_pos);
+        if (!loop.elements.empty()
+                && shape_2.contains(loop.elements.front().start)) {
+            loops.push_back(loop);
+        }
+    }
+    return build_shapes_from_loops(loops);
+}
+
+MultiShapeWithHoles shape::compute_difference(
+        const PreparedShape& shape_1,
+        const ShapeWithHoles& shape_2,
+        const BooleanOperationParameters& parameters)
+{
+    const ShapeWithHoles& shape = shape_1.shape();
+    AxisAlignedBoundingBox aabb = shape_2.compute_min_max();
+    if (!intersect_or_touch(shape_1.min_max(), aabb))
+        return {{shape}};
+
+    // Find the elements of the boundary which touch shape_2.
+    std::vector<ElementPos> element_ids = shape_1.find_boundary_elements(shape_2, aabb);
+    if (element_ids.empty()
+            && !shape_1.contains(shape_2.shape.elements.front().start)) {
+        // shape_2 is outside shape_1.
+        return {{shape}};
+    }
+
+    SplitBoundaryOutput split_output = split_boundary(
+            [&shape_1](ElementPos element_id) -> const ShapeElement& { return shape_1.boundary_elements_[element_id]; },
+            shape_1.boundary_next_,
+            shape_1.boundary_prev_,
+            element_ids,
+            compute_directed_loops(shape_2),
+            [&shape_1](const Point& point) { return shape_1.contains(point); },
+            BooleanOperation::Difference);
+    if (!split_output.consistent) {
+        // Nearly tangent elements have not been split consistently; fall back
+        // to the difference with the whole shape.
+        return compute_difference(
+                MultiShapeWithHoles{{shape}},
+                MultiShapeWithHoles{{shape_2}},
+                parameters);
+    }
+    std::vector<Shape> loops = follow_split_boundary_loops(
+            split_output,
+            [&shape_1](ElementPos element_id) -> const ShapeElement& { return shape_1.boundary_elements_[element_id]; },
+            shape_1.boundary_next_);
+
+    // The loops of the boundary which don't touch shape_2 are kept, unless
+    // they are inside it. Only the outline and the holes close to shape_2
+    // might be.
+    std::vector<uint8_t> loop_is_kept(shape.holes.size() + 1, 1);
+    for (ElementPos element_id: element_ids)
+        loop_is_kept[shape_1.boundary_loops_[element_id]] = 0;
+    std::vector<ShapePos> loop_ids = {0};
+    for (ShapePos hole_pos: shape_1.find_holes(aabb))
+        loop_ids.push_back(hole_pos + 1);
+    for (ShapePos loop_pos: loop_ids) {
+        if (!loop_is_kept[loop_pos])
+            continue;
+        const Shape& loop_shape = (loop_pos == 0)?
+            shape.shape:
+            shape.holes[loop_pos - 1];
+        if (!loop_shape.elements.empty()
+                && shape_2.contains(loop_shape.elements.front().start)) {
+            loop_is_kept[loop_pos] = 0;
+        }
+    }
+    for (ShapePos loop_pos = 0;
+            loop_pos < (ShapePos)loop_is_kept.size();
+            ++loop_pos) {
+        if (loop_is_kept[loop_pos])
+            loops.push_back(shape_1.boundary_loop(loop_pos));
+    }
+    return build_shapes_from_loops(loops);
+}
+
 Shape shape::extract_outline(
         const Shape& shape)
 {
@@ -1662,7 +3318,7 @@ HoleGraph compute_hole_graph(
     std::vector<ShapeWithHoles> intersection_tree_shapes;
     for (const Shape& hole: shape.holes)
         intersection_tree_shapes.push_back({hole});
-    IntersectionTree intersection_tree({intersection_tree_shapes}, {}, {});
+    IntersectionTree intersection_tree(intersection_tree_shapes, {}, {});
     std::vector<std::pair<ShapePos, ShapePos>> touching_shapes
         = intersection_tree.compute_intersecting_shapes(false);
 
@@ -1739,6 +3395,18 @@ std::vector<ShapeElement> shape::find_holes_bridges(
 
     std::vector<ShapeElement> bridges;
     AxisAlignedBoundingBox aabb = shape.compute_min_max();
+
+    // Compute the bounding boxes of the elements once, to skip the elements
+    // that can't intersect the ray of a component.
+    std::vector<std::vector<AxisAlignedBoundingBox>> elements_aabbs(shape.holes.size() + 1);
+    for (ShapePos shape_pos = 0;
+            shape_pos <= (ShapePos)shape.holes.size();
+            ++shape_pos) {
+        const Shape& current_shape = (shape_pos == (ShapePos)shape.holes.size())? shape.shape: shape.holes[shape_pos];
+        for (const ShapeElement& element: current_shape.elements)
+            elements_aabbs[shape_pos].push_back(element.min_max());
+    }
+
     for (ShapePos component_id = 0;
             component_id < (ShapePos)hole_graph.components.size();
             ++component_id) {
@@ -1775,6 +3443,12 @@ std::vector<ShapeElement> shape::find_holes_bridges(
             for (ElementPos element_pos = 0;
                     element_pos < (ElementPos)current_shape.elements.size();
                     ++element_pos) {
+                const AxisAlignedBoundingBox& element_aabb = elements_aabbs[shape_pos][element_pos];
+                if (strictly_lesser(element_aabb.y_max, end.y)
+                        || strictly_greater(element_aabb.y_min, end.y)
+                        || strictly_greater(element_aabb.x_min, end.x)) {
+                    continue;
+                }
                 const ShapeElement& element = current_shape.elements[element_pos];
                 ShapeElementIntersectionsOutput intersections = compute_intersections(ray, element);
                 for (const ShapeElement& overlapping_part: intersections.overlapping_parts) {
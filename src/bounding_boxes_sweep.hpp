@@ -0,0 +1,215 @@
+#pragma once
+
+#include "axis_aligned_bounding_boxes.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <queue>
+
+namespace shape
+{
+
+/**
+ * Bounding boxes whose x-interval contains the sweep line.
+ *
+ * The boxes are the leaves of a segment tree, sorted by smallest y, and each
+ * node stores the greatest y of the active boxes below it. The active boxes
+ * whose y-interval overlaps a given one are found in O(log n) per reported
+ * box, whatever the number of active boxes.
+ */
+class ActiveBoundingBoxes
+{
+
+public:
+
+    /** Build an empty set able to hold the boxes at given positions. */
+    ActiveBoundingBoxes(
+            const AxisAlignedBoundingBoxes& aabbs,
+            std::vector<ElementPos> positions):
+        aabbs_(aabbs),
+        positions_(std::move(positions))
+    {
+        std::sort(
+                positions_.begin(),
+                positions_.end(),
+                [&aabbs](ElementPos pos_1, ElementPos pos_2)
+                {
+                    if (aabbs.y_min[pos_1] != aabbs.y_min[pos_2])
+                        return aabbs.y_min[pos_1] < aabbs.y_min[pos_2];
+                    return pos_1 < pos_2;
+                });
+        y_mins_.reserve(positions_.size());
+        leaves_.resize(aabbs.size(), -1);
+        for (ElementPos leaf = 0; leaf < (ElementPos)positions_.size(); ++leaf) {
+            y_mins_.push_back(aabbs.y_min[positions_[leaf]]);
+            leaves_[positions_[leaf]] = leaf;
+        }
+        number_of_leaves_ = 1;
+        while (number_of_leaves_ < (ElementPos)positions_.size())
+            number_of_leaves_ *= 2;
+        y_maxs_.resize(2 * number_of_leaves_, -std::numeric_limits<LengthDbl>::infinity());
+    }
+
+    /** Add a box to the set. */
+    void insert(ElementPos pos)
+    {
+        update(leaves_[pos], aabbs_.y_max[pos] + bounding_box_margin);
+    }
+
+    /** Remove a box from the set. */
+    void remove(ElementPos pos)
+    {
+        update(leaves_[pos], -std::numeric_limits<LengthDbl>::infinity());
+    }
+
+    /**
+     * Call a function on the boxes of the set overlapping a given y-interval,
+     * until it returns true.
+     *
+     * Return true if the function returned true.
+     */
+    template <typename F>
+    bool find(
+            LengthDbl y_min,
+            LengthDbl y_max,
+            F function) const
+    {
+        ElementPos leaf_end = std::upper_bound(
+                y_mins_.begin(),
+                y_mins_.end(),
+                y_max + bounding_box_margin) - y_mins_.begin();
+        return find(1, 0, number_of_leaves_, leaf_end, y_min, function);
+    }
+
+private:
+
+    void update(
+            ElementPos leaf,
+            LengthDbl y_max)
+    {
+        ElementPos node = number_of_leaves_ + leaf;
+        y_maxs_[node] = y_max;
+        for (node /= 2; node >= 1; node /= 2)
+            y_maxs_[node] = (std::max)(y_maxs_[2 * node], y_maxs_[2 * node + 1]);
+    }
+
+    template <typename F>
+    bool find(
+            ElementPos node,
+            ElementPos leaf_start,
+            ElementPos leaf_end,
+            ElementPos leaf_end_max,
+            LengthDbl y_min,
+            F& function) const
+    {
+        if (leaf_start >= leaf_end_max || y_maxs_[node] < y_min)
+            return false;
+        if (node >= number_of_leaves_)
+            return function(positions_[leaf_start]);
+        ElementPos leaf_middle = (leaf_start + leaf_end) / 2;
+        return find(2 * node, leaf_start, leaf_middle, leaf_end_max, y_min, function)
+            || find(2 * node + 1, leaf_middle, leaf_end, leaf_end_max, y_min, function);
+    }
+
+    /** Bounding boxes. */
+    const AxisAlignedBoundingBoxes& aabbs_;
+
+    /** Positions of the boxes of the set, sorted by smallest y. */
+    std::vector<ElementPos> positions_;
+
+    /** Smallest y of the boxes, in the same order. */
+    std::vector<LengthDbl> y_mins_;
+
+    /** Leaf of each box; -1 for the boxes which are not part of the set. */
+    std::vector<ElementPos> leaves_;
+
+    /** Number of leaves of the segment tree, a power of two. */
+    ElementPos number_of_leaves_ = 1;
+
+    /**
+     * Greatest y, margin included, of the active boxes below each node;
+     * minus infinity if there is none.
+     */
+    std::vector<LengthDbl> y_maxs_;
+
+};
+
+/**
+ * Call a function on the pairs of overlapping bounding boxes, until it
+ * returns true.
+ *
+ * Two boxes overlap if they are at most bounding_box_margin from each other.
+ *
+ * If 'sides' is empty, every pair is considered, the box with the smallest
+ * x being passed first. Otherwise, 'sides' gives the side, 0 or 1, of each
+ * box; only the pairs of boxes of different sides are considered, the box
+ * of side 0 being passed first.
+ *
+ * The boxes are visited by a vertical line sweeping them by smallest x. The
+ * boxes crossing the line are stored in an ActiveBoundingBoxes, so the
+ * sweep runs in O((n + k) log n), k being the number of reported pairs,
+ * even if some long boxes cross the line during the whole sweep.
+ *
+ * Return true if the function returned true.
+ */
+template <typename F>
+bool find_overlapping_bounding_boxes(
+        const AxisAlignedBoundingBoxes& aabbs,
+        const std::vector<int>& sides,
+        F function)
+{
+    int number_of_sides = (sides.empty())? 1: 2;
+    std::vector<ElementPos> positions[2];
+    for (ElementPos pos = 0; pos < aabbs.size(); ++pos)
+        positions[(sides.empty())? 0: sides[pos]].push_back(pos);
+    std::vector<ActiveBoundingBoxes> active_aabbs;
+    for (int side = 0; side < number_of_sides; ++side)
+        active_aabbs.emplace_back(aabbs, std::move(positions[side]));
+
+    std::vector<ElementPos> sorted_positions(aabbs.size());
+    std::iota(sorted_positions.begin(), sorted_positions.end(), 0);
+    std::sort(
+            sorted_positions.begin(),
+            sorted_positions.end(),
+            [&aabbs](ElementPos pos_1, ElementPos pos_2)
+            {
+                if (aabbs.x_min[pos_1] != aabbs.x_min[pos_2])
+                    return aabbs.x_min[pos_1] < aabbs.x_min[pos_2];
+                return pos_1 < pos_2;
+            });
+
+    // Active boxes, by greatest x, margin included.
+    std::priority_queue<
+        std::pair<LengthDbl, ElementPos>,
+        std::vector<std::pair<LengthDbl, ElementPos>>,
+        std::greater<std::pair<LengthDbl, ElementPos>>> x_maxs;
+    for (ElementPos pos: sorted_positions) {
+        while (!x_maxs.empty() && x_maxs.top().first < aabbs.x_min[pos]) {
+            ElementPos pos_old = x_maxs.top().second;
+            active_aabbs[(sides.empty())? 0: sides[pos_old]].remove(pos_old);
+            x_maxs.pop();
+        }
+
+        int side = (sides.empty())? 0: sides[pos];
+        ActiveBoundingBoxes& other_active_aabbs = active_aabbs[(sides.empty())? 0: 1 - side];
+        bool found = other_active_aabbs.find(
+                aabbs.y_min[pos],
+                aabbs.y_max[pos],
+                [&sides, side, pos, &function](ElementPos active_pos)
+                {
+                    return (!sides.empty() && side == 0)?
+                        function(pos, active_pos):
+                        function(active_pos, pos);
+                });
+        if (found)
+            return true;
+
+        active_aabbs[side].insert(pos);
+        x_maxs.push({aabbs.x_max[pos] + bounding_box_margin, pos});
+    }
+    return false;
+}
+
+}
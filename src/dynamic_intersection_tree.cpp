@@ -0,0 +1,546 @@
+#include "shape/dynamic_intersection_tree.hpp"
+
+#include "shape/shapes_intersections.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace shape;
+
+namespace
+{
+
+LengthDbl perimeter(const AxisAlignedBoundingBox& aabb)
+{
+    return 2 * (aabb.x_max - aabb.x_min + aabb.y_max - aabb.y_min);
+}
+
+bool intersect_or_touch(
+        const AxisAlignedBoundingBox& aabb_1,
+        const AxisAlignedBoundingBox& aabb_2)
+{
+    return !strictly_lesser(aabb_1.x_max, aabb_2.x_min)
+        && !strictly_lesser(aabb_2.x_max, aabb_1.x_min)
+        && !strictly_lesser(aabb_1.y_max, aabb_2.y_min)
+        && !strictly_lesser(aabb_2.y_max, aabb_1.y_min);
+}
+
+}
+
+ShapePos DynamicIntersectionTree::insert(const ShapeWithHoles& shape)
+{
+    ShapePos shape_id = -1;
+    if (!free_shape_ids_.empty()) {
+        shape_id = free_shape_ids_.back();
+        free_shape_ids_.pop_back();
+        shapes_[shape_id].shape = shape;
+    } else {
+        shape_id = shapes_.size();
+        shapes_.push_back({shape, -1});
+    }
+    shapes_[shape_id].node_id = insert_item(shape.compute_min_max(), shape_id, true);
+    add_modification();
+    return shape_id;
+}
+
+ElementPos DynamicIntersectionTree::insert(const ShapeElement& element)
+{
+    ElementPos element_id = -1;
+    if (!free_element_ids_.empty()) {
+        element_id = free_element_ids_.back();
+        free_element_ids_.pop_back();
+        elements_[element_id].element = element;
+    } else {
+        element_id = elements_.size();
+        elements_.push_back({element, -1});
+    }
+    elements_[element_id].node_id = insert_item(element.min_max(), element_id, false);
+    add_modification();
+    return element_id;
+}
+
+bool DynamicIntersectionTree::contains_shape(ShapePos shape_id) const
+{
+    return shape_id >= 0
+        && shape_id < (ShapePos)shapes_.size()
+        && shapes_[shape_id].node_id != -1;
+}
+
+bool DynamicIntersectionTree::contains_element(ElementPos element_id) const
+{
+    return element_id >= 0
+        && element_id < (ElementPos)elements_.size()
+        && elements_[element_id].node_id != -1;
+}
+
+void DynamicIntersectionTree::remove_shape(ShapePos shape_id)
+{
+    if (!contains_shape(shape_id)) {
+        throw std::invalid_argument(
+                FUNC_SIGNATURE + ": "
+                "invalid shape id; "
+                "shape_id: " + std::to_string(shape_id) + ".");
+    }
+    remove_item(shapes_[shape_id].node_id);
+    shapes_[shape_id].node_id = -1;
+    shapes_[shape_id].shape = ShapeWithHoles();
+    free_shape_ids_.push_back(shape_id);
+    add_modification();
+}
+
+void DynamicIntersectionTree::remove_element(ElementPos element_id)
+{
+    if (!contains_element(element_id)) {
+        throw std::invalid_argument(
+                FUNC_SIGNATURE + ": "
+                "invalid element id; "
+                "element_id: " + std::to_string(element_id) + ".");
+    }
+    remove_item(elements_[element_id].node_id);
+    elements_[element_id].node_id = -1;
+    elements_[element_id].element = ShapeElement();
+    free_element_ids_.push_back(element_id);
+    add_modification();
+}
+
+Counter DynamicIntersectionTree::height() const
+{
+    if (root_id_ == -1)
+        return 0;
+    return nodes_[root_id_].height;
+}
+
+DynamicIntersectionTree::NodeId DynamicIntersectionTree::allocate_node()
+{
+    if (free_node_id_ == -1) {
+        nodes_.push_back(Node());
+        return nodes_.size() - 1;
+    }
+    NodeId node_id = free_node_id_;
+    free_node_id_ = nodes_[node_id].child_1_id;
+    nodes_[node_id] = Node();
+    return node_id;
+}
+
+void DynamicIntersectionTree::free_node(NodeId node_id)
+{
+    Node& node = nodes_[node_id];
+    node.parent_id = -1;
+    node.child_1_id = free_node_id_;
+    node.child_2_id = -1;
+    node.height = -1;
+    free_node_id_ = node_id;
+}
+
+DynamicIntersectionTree::NodeId DynamicIntersectionTree::insert_item(
+        const AxisAlignedBoundingBox& aabb,
+        ShapePos item_id,
+        bool is_shape)
+{
+    NodeId leaf_id = allocate_node();
+    Node& leaf = nodes_[leaf_id];
+    leaf.aabb = aabb;
+    leaf.item_id = item_id;
+    leaf.is_shape = is_shape;
+    insert_leaf(leaf_id);
+    return leaf_id;
+}
+
+void DynamicIntersectionTree::remove_item(NodeId node_id)
+{
+    remove_leaf(node_id);
+    free_node(node_id);
+}
+
+void DynamicIntersectionTree::insert_leaf(NodeId leaf_id)
+{
+    if (root_id_ == -1) {
+        root_id_ = leaf_id;
+        nodes_[leaf_id].parent_id = -1;
+        return;
+    }
+
+    // Find the best sibling, going down the tree while the increase of the
+    // sum of the perimeters of the bounding boxes decreases.
+    AxisAlignedBoundingBox leaf_aabb = nodes_[leaf_id].aabb;
+    NodeId node_id = root_id_;
+    while (!nodes_[node_id].is_leaf()) {
+        const Node& node = nodes_[node_id];
+        LengthDbl node_perimeter = perimeter(node.aabb);
+        LengthDbl merged_perimeter = perimeter(merge(node.aabb, leaf_aabb));
+
+        // Cost of creating a new parent for this node and the new leaf.
+        LengthDbl cost = 2 * merged_perimeter;
+        // Minimum cost of pushing the leaf further down the tree.
+        LengthDbl inheritance_cost = 2 * (merged_perimeter - node_perimeter);
+
+        LengthDbl costs[2];
+        NodeId child_ids[2] = {node.child_1_id, node.child_2_id};
+        for (int c = 0; c < 2; ++c) {
+            const Node& child = nodes_[child_ids[c]];
+            costs[c] = perimeter(merge(child.aabb, leaf_aabb)) + inheritance_cost;
+            if (!child.is_leaf())
+                costs[c] -= perimeter(child.aabb);
+        }
+
+        if (cost < costs[0] && cost < costs[1])
+            break;
+        node_id = (costs[0] < costs[1])? child_ids[0]: child_ids[1];
+    }
+    NodeId sibling_id = node_id;
+
+    // Create a new parent.
+    NodeId new_parent_id = allocate_node();
+    NodeId old_parent_id = nodes_[sibling_id].parent_id;
+    Node& new_parent = nodes_[new_parent_id];
+    new_parent.parent_id = old_parent_id;
+    new_parent.aabb = merge(leaf_aabb, nodes_[sibling_id].aabb);
+    new_parent.height = nodes_[sibling_id].height + 1;
+    new_parent.child_1_id = sibling_id;
+    new_parent.child_2_id = leaf_id;
+    if (old_parent_id != -1) {
+        Node& old_parent = nodes_[old_parent_id];
+        if (old_parent.child_1_id == sibling_id) {
+            old_parent.child_1_id = new_parent_id;
+        } else {
+            old_parent.child_2_id = new_parent_id;
+        }
+    } else {
+        root_id_ = new_parent_id;
+    }
+    nodes_[sibling_id].parent_id = new_parent_id;
+    nodes_[leaf_id].parent_id = new_parent_id;
+
+    update_ancestors(new_parent_id);
+}
+
+void DynamicIntersectionTree::remove_leaf(NodeId leaf_id)
+{
+    if (leaf_id == root_id_) {
+        root_id_ = -1;
+        return;
+    }
+
+    NodeId parent_id = nodes_[leaf_id].parent_id;
+    NodeId grand_parent_id = nodes_[parent_id].parent_id;
+    NodeId sibling_id = (nodes_[parent_id].child_1_id == leaf_id)?
+        nodes_[parent_id].child_2_id:
+        nodes_[parent_id].child_1_id;
+
+    // Replace the parent by the sibling.
+    if (grand_parent_id != -1) {
+        Node& grand_parent = nodes_[grand_parent_id];
+        if (grand_parent.child_1_id == parent_id) {
+            grand_parent.child_1_id = sibling_id;
+        } else {
+            grand_parent.child_2_id = sibling_id;
+        }
+        nodes_[sibling_id].parent_id = grand_parent_id;
+        free_node(parent_id);
+        update_ancestors(grand_parent_id);
+    } else {
+        root_id_ = sibling_id;
+        nodes_[sibling_id].parent_id = -1;
+        free_node(parent_id);
+    }
+    nodes_[leaf_id].parent_id = -1;
+}
+
+void DynamicIntersectionTree::update_ancestors(NodeId node_id)
+{
+    while (node_id != -1) {
+        if (!parameters_.lazy_rebalancing)
+            node_id = balance(node_id);
+        Node& node = nodes_[node_id];
+        const Node& child_1 = nodes_[node.child_1_id];
+        const Node& child_2 = nodes_[node.child_2_id];
+        node.height = 1 + (std::max)(child_1.height, child_2.height);
+        node.aabb = merge(child_1.aabb, child_2.aabb);
+        node_id = node.parent_id;
+    }
+}
+
+DynamicIntersectionTree::NodeId DynamicIntersectionTree::balance(NodeId node_id)
+{
+    Node& node = nodes_[node_id];
+    if (node.is_leaf() || node.height < 2)
+        return node_id;
+
+    NodeId child_1_id = node.child_1_id;
+    NodeId child_2_id = node.child_2_id;
+    Height difference = nodes_[child_2_id].height - nodes_[child_1_id].height;
+    if (-1 <= difference && difference <= 1)
+        return node_id;
+
+    // Rotate the highest child up: it takes the place of the node, the node
+    // becomes its first child and receives its lowest grandchild.
+    bool first = (difference < -1);
+    NodeId up_id = (first)? child_1_id: child_2_id;
+    Node& up = nodes_[up_id];
+    NodeId grandchild_1_id = up.child_1_id;
+    NodeId grandchild_2_id = up.child_2_id;
+
+    up.child_1_id = node_id;
+    up.parent_id = node.parent_id;
+    node.parent_id = up_id;
+    if (up.parent_id != -1) {
+        Node& parent = nodes_[up.parent_id];
+        if (parent.child_1_id == node_id) {
+            parent.child_1_id = up_id;
+        } else {
+            parent.child_2_id = up_id;
+        }
+    } else {
+        root_id_ = up_id;
+    }
+
+    NodeId high_id = grandchild_1_id;
+    NodeId low_id = grandchild_2_id;
+    if (nodes_[grandchild_1_id].height < nodes_[grandchild_2_id].height)
+        std::swap(high_id, low_id);
+    up.child_2_id = high_id;
+    if (first) {
+        node.child_1_id = low_id;
+    } else {
+        node.child_2_id = low_id;
+    }
+    nodes_[low_id].parent_id = node_id;
+
+    const Node& node_child_1 = nodes_[node.child_1_id];
+    const Node& node_child_2 = nodes_[node.child_2_id];
+    node.aabb = merge(node_child_1.aabb, node_child_2.aabb);
+    node.height = 1 + (std::max)(node_child_1.height, node_child_2.height);
+    up.aabb = merge(node.aabb, nodes_[high_id].aabb);
+    up.height = 1 + (std::max)(node.height, nodes_[high_id].height);
+    return up_id;
+}
+
+void DynamicIntersectionTree::add_modification()
+{
+    if (!parameters_.lazy_rebalancing)
+        return;
+    number_of_modifications_++;
+    // Rebuild after a number of modifications proportional to the number of
+    // items, so that the cost of the rebuilds is amortized; sooner if the
+    // tree is getting much higher than a balanced one.
+    Counter number_of_items = number_of_shapes() + number_of_elements();
+    if (number_of_modifications_ > number_of_items
+            || (8 * number_of_modifications_ > number_of_items
+                && height() > 2 * (std::log2(number_of_items + 1) + 1))) {
+        rebalance();
+    }
+}
+
+DynamicIntersectionTree::NodeId DynamicIntersectionTree::build(
+        std::vector<NodeId>::iterator leaves_begin,
+        std::vector<NodeId>::iterator leaves_end)
+{
+    if (leaves_end - leaves_begin == 1)
+        return *leaves_begin;
+
+    // Split the leaves at the median of the centers of their bounding boxes
+    // along the largest dimension.
+    AxisAlignedBoundingBox centers_aabb;
+    for (auto it = leaves_begin; it != leaves_end; ++it) {
+        const AxisAlignedBoundingBox& aabb = nodes_[*it].aabb;
+        LengthDbl x = (aabb.x_min + aabb.x_max) / 2;
+        LengthDbl y = (aabb.y_min + aabb.y_max) / 2;
+        centers_aabb.x_min = (std::min)(centers_aabb.x_min, x);
+        centers_aabb.x_max = (std::max)(centers_aabb.x_max, x);
+        centers_aabb.y_min = (std::min)(centers_aabb.y_min, y);
+        centers_aabb.y_max = (std::max)(centers_aabb.y_max, y);
+    }
+    bool vertical = (centers_aabb.x_max - centers_aabb.x_min
+            >= centers_aabb.y_max - centers_aabb.y_min);
+    auto leaves_middle = leaves_begin + (leaves_end - leaves_begin) / 2;
+    std::nth_element(
+            leaves_begin,
+            leaves_middle,
+            leaves_end,
+            [this, vertical](NodeId node_id_1, NodeId node_id_2)
+            {
+                const AxisAlignedBoundingBox& aabb_1 = nodes_[node_id_1].aabb;
+                const AxisAlignedBoundingBox& aabb_2 = nodes_[node_id_2].aabb;
+                if (vertical)
+                    return aabb_1.x_min + aabb_1.x_max < aabb_2.x_min + aabb_2.x_max;
+                return aabb_1.y_min + aabb_1.y_max < aabb_2.y_min + aabb_2.y_max;
+            });
+
+    NodeId child_1_id = build(leaves_begin, leaves_middle);
+    NodeId child_2_id = build(leaves_middle, leaves_end);
+    NodeId node_id = allocate_node();
+    Node& node = nodes_[node_id];
+    node.child_1_id = child_1_id;
+    node.child_2_id = child_2_id;
+    node.aabb = merge(nodes_[child_1_id].aabb, nodes_[child_2_id].aabb);
+    node.height = 1 + (std::max)(nodes_[child_1_id].height, nodes_[child_2_id].height);
+    nodes_[child_1_id].parent_id = node_id;
+    nodes_[child_2_id].parent_id = node_id;
+    return node_id;
+}
+
+void DynamicIntersectionTree::rebalance()
+{
+    number_of_modifications_ = 0;
+
+    // Free the internal nodes.
+    for (NodeId node_id = 0; node_id < (NodeId)nodes_.size(); ++node_id)
+        if (nodes_[node_id].height > 0)
+            free_node(node_id);
+
+    std::vector<NodeId> leaves;
+    for (const ShapeItem& item: shapes_)
+        if (item.node_id != -1)
+            leaves.push_back(item.node_id);
+    for (const ElementItem& item: elements_)
+        if (item.node_id != -1)
+            leaves.push_back(item.node_id);
+    if (leaves.empty()) {
+        root_id_ = -1;
+        return;
+    }
+    root_id_ = build(leaves.begin(), leaves.end());
+    nodes_[root_id_].parent_id = -1;
+}
+
+void DynamicIntersectionTree::find_potentially_intersecting(
+        const AxisAlignedBoundingBox& aabb,
+        std::vector<ShapePos>& shape_ids,
+        std::vector<ElementPos>& element_ids) const
+{
+    if (root_id_ == -1)
+        return;
+    std::vector<NodeId> stack = {root_id_};
+    while (!stack.empty()) {
+        const Node& node = nodes_[stack.back()];
+        stack.pop_back();
+        if (!intersect_or_touch(node.aabb, aabb))
+            continue;
+        if (node.is_leaf()) {
+            if (node.is_shape) {
+                shape_ids.push_back(node.item_id);
+            } else {
+                element_ids.push_back(node.item_id);
+            }
+        } else {
+            stack.push_back(node.child_2_id);
+            stack.push_back(node.child_1_id);
+        }
+    }
+    std::sort(shape_ids.begin(), shape_ids.end());
+    std::sort(element_ids.begin(), element_ids.end());
+}
+
+DynamicIntersectionTree::IntersectOutput DynamicIntersectionTree::intersect(
+        const ShapeWithHoles& shape,
+        bool strict) const
+{
+    std::vector<ShapePos> shape_ids;
+    std::vector<ElementPos> element_ids;
+    find_potentially_intersecting(shape.compute_min_max(), shape_ids, element_ids);
+
+    IntersectOutput output;
+    for (ShapePos shape_id: shape_ids)
+        if (shape::intersect(shape, this->shape(shape_id), strict))
+            output.shape_ids.push_back(shape_id);
+    for (ElementPos element_id: element_ids)
+        if (shape::intersect(shape, this->element(element_id), strict))
+            output.element_ids.push_back(element_id);
+    return output;
+}
+
+DynamicIntersectionTree::IntersectOutput DynamicIntersectionTree::intersect(
+        const Shape& shape,
+        bool strict) const
+{
+    std::vector<ShapePos> shape_ids;
+    std::vector<ElementPos> element_ids;
+    find_potentially_intersecting(shape.compute_min_max(), shape_ids, element_ids);
+
+    IntersectOutput output;
+    for (ShapePos shape_id: shape_ids)
+        if (shape::intersect(this->shape(shape_id), shape, strict))
+            output.shape_ids.push_back(shape_id);
+    for (ElementPos element_id: element_ids)
+        if (shape::intersect(shape, this->element(element_id), strict))
+            output.element_ids.push_back(element_id);
+    return output;
+}
+
+DynamicIntersectionTree::IntersectOutput DynamicIntersectionTree::intersect(
+        const ShapeElement& element,
+        bool strict) const
+{
+    std::vector<ShapePos> shape_ids;
+    std::vector<ElementPos> element_ids;
+    find_potentially_intersecting(element.min_max(), shape_ids, element_ids);
+
+    IntersectOutput output;
+    for (ShapePos shape_id: shape_ids)
+        if (shape::intersect(this->shape(shape_id), element, strict))
+            output.shape_ids.push_back(shape_id);
+    if (strict) {
+        FixedShapeElementIntersectionsOutput intersections;
+        for (ElementPos element_id: element_ids) {
+            compute_intersections(this->element(element_id), element, intersections);
+            if (intersections.number_of_improper_intersections > 0)
+                output.element_ids.push_back(element_id);
+        }
+    } else {
+        for (ElementPos element_id: element_ids)
+            if (shape::intersect(this->element(element_id), element))
+                output.element_ids.push_back(element_id);
+    }
+    return output;
+}
+
+DynamicIntersectionTree::IntersectOutput DynamicIntersectionTree::intersect(
+        const Point& point,
+        bool strict) const
+{
+    AxisAlignedBoundingBox aabb;
+    aabb.x_min = point.x;
+    aabb.x_max = point.x;
+    aabb.y_min = point.y;
+    aabb.y_max = point.y;
+    std::vector<ShapePos> shape_ids;
+    std::vector<ElementPos> element_ids;
+    find_potentially_intersecting(aabb, shape_ids, element_ids);
+
+    IntersectOutput output;
+    for (ShapePos shape_id: shape_ids)
+        if (this->shape(shape_id).contains(point, strict))
+            output.shape_ids.push_back(shape_id);
+    if (!strict) {
+        for (ElementPos element_id: element_ids)
+            if (this->element(element_id).contains(point))
+                output.element_ids.push_back(element_id);
+    }
+    return output;
+}
+
+std::vector<std::pair<ShapePos, ShapePos>> DynamicIntersectionTree::compute_intersecting_shapes(bool strict) const
+{
+    std::vector<std::pair<ShapePos, ShapePos>> intersecting_shapes;
+    std::vector<ShapePos> shape_ids;
+    std::vector<ElementPos> element_ids;
+    for (ShapePos shape_id_1 = 0;
+            shape_id_1 < (ShapePos)shapes_.size();
+            ++shape_id_1) {
+        if (shapes_[shape_id_1].node_id == -1)
+            continue;
+        shape_ids.clear();
+        element_ids.clear();
+        find_potentially_intersecting(
+                nodes_[shapes_[shape_id_1].node_id].aabb,
+                shape_ids,
+                element_ids);
+        for (ShapePos shape_id_2: shape_ids) {
+            if (shape_id_2 <= shape_id_1)
+                continue;
+            if (shape::intersect(this->shape(shape_id_1), this->shape(shape_id_2), strict))
+                intersecting_shapes.push_back({shape_id_1, shape_id_2});
+        }
+    }
+    return intersecting_shapes;
+}
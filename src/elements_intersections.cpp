@@ -169,13 +169,25 @@ std::pair<bool, Point> shape::compute_line_intersection(
     }
 }
 
-std::vector<Point> shape::compute_line_circle_intersections(
+namespace
+{
+
+/** Intersection points of a line or a circle with a circle. */
+struct CircleIntersections
+{
+    Point points[2];
+    ElementPos size = 0;
+
+    void push_back(const Point& point) { points[size++] = point; }
+};
+
+CircleIntersections line_circle_intersections(
         const Point& line_point_1,
         const Point& line_point_2,
         const Point& circle_center,
         LengthDbl circle_radius)
 {
-    std::vector<Point> points;
+    CircleIntersections points;
 
     if (line_point_1.x == line_point_2.x) {
         LengthDbl dx = line_point_1.x - circle_center.x;
@@ -226,16 +238,18 @@ std::vector<Point> shape::compute_line_circle_intersections(
     }
 
     // Collapse to a single tangent point when the two computed points coincide.
-    if (points.size() == 2) {
-        Point midpoint = 0.5 * (points[0] + points[1]);
-        if (equal(distance(midpoint, circle_center), circle_radius))
-            return {midpoint};
+    if (points.size == 2) {
+        Point midpoint = 0.5 * (points.points[0] + points.points[1]);
+        if (equal(distance(midpoint, circle_center), circle_radius)) {
+            points.points[0] = midpoint;
+            points.size = 1;
+        }
     }
 
     return points;
 }
 
-std::vector<Point> shape::compute_circle_circle_intersections(
+CircleIntersections circle_circle_intersections(
         const Point& center_1,
         LengthDbl radius_1,
         const Point& center_2,
@@ -268,7 +282,7 @@ std::vector<Point> shape::compute_circle_circle_intersections(
     LengthDbl teta_2 = (line_b * c_prime + line_a * sqrt_disc) / denom;
     Point point_1 = {center_1.x + eta_1, center_1.y + teta_1};
     Point point_2 = {center_1.x + eta_2, center_1.y + teta_2};
-    std::vector<Point> points;
+    CircleIntersections points;
     if (equal(distance(point_1, center_1), radius_1)
             && equal(distance(point_1, center_2), radius_2)) {
         points.push_back(point_1);
@@ -279,24 +293,56 @@ std::vector<Point> shape::compute_circle_circle_intersections(
     }
 
     // Collapse to a single tangent point when the two computed points coincide.
-    if (points.size() == 2) {
-        Point midpoint = 0.5 * (points[0] + points[1]);
+    if (points.size == 2) {
+        Point midpoint = 0.5 * (points.points[0] + points.points[1]);
         if (equal(distance(midpoint, center_1), radius_1)
                 || equal(distance(midpoint, center_2), radius_2)) {
-            return {midpoint};
+            points.points[0] = midpoint;
+            points.size = 1;
         }
     }
 
     return points;
 }
 
+}
+
+std::vector<Point> shape::compute_line_circle_intersections(
+        const Point& line_point_1,
+        const Point& line_point_2,
+        const Point& circle_center,
+        LengthDbl circle_radius)
+{
+    CircleIntersections points = line_circle_intersections(
+            line_point_1,
+            line_point_2,
+            circle_center,
+            circle_radius);
+    return std::vector<Point>(points.points, points.points + points.size);
+}
+
+std::vector<Point> shape::compute_circle_circle_intersections(
+        const Point& center_1,
+        LengthDbl radius_1,
+        const Point& center_2,
+        LengthDbl radius_2)
+{
+    CircleIntersections points = circle_circle_intersections(
+            center_1,
+            radius_1,
+            center_2,
+            radius_2);
+    return std::vector<Point>(points.points, points.points + points.size);
+}
+
 namespace
 {
 
 // Helper function to compute line-line intersections
-ShapeElementIntersectionsOutput compute_line_line_intersections(
+void compute_line_line_intersections(
         const ShapeElement& line1,
-        const ShapeElement& line2)
+        const ShapeElement& line2,
+        FixedShapeElementIntersectionsOutput& output)
 {
     auto p = compute_line_intersection(line1.start, line1.end, line2.start, line2.end);
     //std::cout << p.first << " " << p.second.to_string() << std::endl;
@@ -305,7 +351,7 @@ ShapeElementIntersectionsOutput compute_line_line_intersections(
         // If they are colinear, check if they are aligned.
         if (!equal(signed_distance_point_to_line(line1.start, line2.start, line2.end), 0.0)
                 && !equal(signed_distance_point_to_line(line2.start, line1.start, line1.end), 0.0)) {
-            return {};
+            return;
         }
 
         Point ref = line1.end - line1.start;
@@ -341,56 +387,60 @@ ShapeElementIntersectionsOutput compute_line_line_intersections(
 
         if (sorted_points[0] + sorted_points[1] == 1
                 || sorted_points[0] + sorted_points[1] == 5) {
-            if (equal(point_1, point_2)) {
-                return {{}, {point_1}, {}};
-            } else {
-                return {};
-            }
+            if (equal(point_1, point_2))
+                output.add_improper_intersection(point_1);
+            return;
         }
         if (equal(point_1, point_2)) {
-            return {{}, {point_1}, {}};
+            output.add_improper_intersection(point_1);
         } else {
-            return {{build_line_segment(point_1, point_2)}, {}, {}};
+            output.add_overlapping_part(build_line_segment(point_1, point_2));
         }
+        return;
     }
 
     if (p.second == line1.start
             || p.second == line1.end) {
-        if (line2.contains(p.second))
-            return {{}, {p.second}, {}};
+        if (line2.contains(p.second)) {
+            output.add_improper_intersection(p.second);
+            return;
+        }
     }
     if (p.second == line2.start
             || p.second == line2.end) {
-        if (line1.contains(p.second))
-            return {{}, {p.second}, {}};
+        if (line1.contains(p.second)) {
+            output.add_improper_intersection(p.second);
+            return;
+        }
     }
 
     if (line1.contains(p.second) && line2.contains(p.second))
-        return {{}, {}, {p.second}};
-    return {};
+        output.add_proper_intersection(p.second);
 }
 
 // Helper function to compute line-arc intersections
-ShapeElementIntersectionsOutput compute_line_arc_intersections(
+void compute_line_arc_intersections(
         const ShapeElement& line,
-        const ShapeElement& arc)
+        const ShapeElement& arc,
+        FixedShapeElementIntersectionsOutput& output)
 {
     //std::cout << "line " << line.to_string() << std::endl;
     //std::cout << "arc " << arc.to_string() << std::endl;
 
     LengthDbl radius = arc.radius();
 
-    std::vector<Point> computed_points = shape::compute_line_circle_intersections(
+    CircleIntersections computed_points = line_circle_intersections(
             line.start, line.end, arc.center, radius);
-    std::vector<uint8_t> computed_points_valid(computed_points.size(), true);
-    std::vector<Point> end_points;
+    bool computed_points_valid[2] = {true, true};
+    std::array<Point, 4> end_points;
+    ElementPos number_of_end_points = 0;
 
     // Circle contains line start.
     if (equal(distance(line.start, arc.center), radius)) {
-        end_points.push_back(line.start);
-        if (computed_points.size() == 0) {
-        } else if (computed_points.size() == 1
-                || squared_distance(line.start, computed_points[0]) < squared_distance(line.start, computed_points[1])) {
+        end_points[number_of_end_points++] = line.start;
+        if (computed_points.size == 0) {
+        } else if (computed_points.size == 1
+                || squared_distance(line.start, computed_points.points[0]) < squared_distance(line.start, computed_points.points[1])) {
             computed_points_valid[0] = false;
         } else {
             computed_points_valid[1] = false;
@@ -399,10 +449,10 @@ ShapeElementIntersectionsOutput compute_line_arc_intersections(
     // Circle contains line end.
     if (!(line.end == line.start)
             && equal(distance(line.end, arc.center), radius)) {
-        end_points.push_back(line.end);
-        if (computed_points.size() == 0) {
-        } else if (computed_points.size() == 1
-                || squared_distance(line.end, computed_points[0]) < squared_distance(line.end, computed_points[1])) {
+        end_points[number_of_end_points++] = line.end;
+        if (computed_points.size == 0) {
+        } else if (computed_points.size == 1
+                || squared_distance(line.end, computed_points.points[0]) < squared_distance(line.end, computed_points.points[1])) {
             computed_points_valid[0] = false;
         } else {
             computed_points_valid[1] = false;
@@ -412,10 +462,10 @@ ShapeElementIntersectionsOutput compute_line_arc_intersections(
     if (!(arc.start == line.start)
             && !(arc.start == line.end)
             && equal(distance_point_to_line(arc.start, line.start, line.end), 0.0)) {
-        end_points.push_back(arc.start);
-        if (computed_points.size() == 0) {
-        } else if (computed_points.size() == 1
-                || squared_distance(arc.start, computed_points[0]) < squared_distance(arc.start, computed_points[1])) {
+        end_points[number_of_end_points++] = arc.start;
+        if (computed_points.size == 0) {
+        } else if (computed_points.size == 1
+                || squared_distance(arc.start, computed_points.points[0]) < squared_distance(arc.start, computed_points.points[1])) {
             computed_points_valid[0] = false;
         } else {
             computed_points_valid[1] = false;
@@ -426,40 +476,41 @@ ShapeElementIntersectionsOutput compute_line_arc_intersections(
             && !(arc.end == line.end)
             && !(arc.end == arc.start)
             && equal(distance_point_to_line(arc.end, line.start, line.end), 0.0)) {
-        end_points.push_back(arc.end);
-        if (computed_points.size() == 0) {
-        } else if (computed_points.size() == 1
-                || squared_distance(arc.end, computed_points[0]) < squared_distance(arc.end, computed_points[1])) {
+        end_points[number_of_end_points++] = arc.end;
+        if (computed_points.size == 0) {
+        } else if (computed_points.size == 1
+                || squared_distance(arc.end, computed_points.points[0]) < squared_distance(arc.end, computed_points.points[1])) {
             computed_points_valid[0] = false;
         } else {
             computed_points_valid[1] = false;
         }
     }
 
-    ShapeElementIntersectionsOutput output;
-    for (const Point& p: end_points)
+    for (ElementPos pos = 0; pos < number_of_end_points; ++pos) {
+        const Point& p = end_points[pos];
         if (arc.contains(p) && line.contains(p))
-            output.improper_intersections.push_back(p);
-    for (ElementPos pos = 0; pos < (ElementPos)computed_points.size(); ++pos) {
+            output.add_improper_intersection(p);
+    }
+    for (ElementPos pos = 0; pos < computed_points.size; ++pos) {
         if (!computed_points_valid[pos])
             continue;
-        const Point& p = computed_points[pos];
+        const Point& p = computed_points.points[pos];
         // Check if any intersection coincides with an arc_2 endpoint
         if (arc.contains(p) && line.contains(p)) {
-            if (computed_points.size() == 1) {
-                output.improper_intersections.push_back(p);
+            if (computed_points.size == 1) {
+                output.add_improper_intersection(p);
             } else {
-                output.proper_intersections.push_back(p);
+                output.add_proper_intersection(p);
             }
         }
     }
-    return output;
 }
 
 // Helper function to compute arc-arc intersections
-ShapeElementIntersectionsOutput compute_arc_arc_intersections(
+void compute_arc_arc_intersections(
         const ShapeElement& arc,
-        const ShapeElement& arc_2)
+        const ShapeElement& arc_2,
+        FixedShapeElementIntersectionsOutput& output)
 {
 #ifdef ELEMENTS_INTERSECTIONS_ENABLE_DEBUG
     std::cout << "recompute_center_1 " << arc.recompute_center().to_string() << std::endl;
@@ -472,16 +523,22 @@ ShapeElementIntersectionsOutput compute_arc_arc_intersections(
             if (equal(arc.start, arc_2.start)
                     && equal(arc.end, arc_2.end)) {
                 if (arc.orientation == arc_2.orientation) {
-                    return {{arc}, {}, {}};
+                    output.add_overlapping_part(arc);
+                    return;
                 } else {
-                    return {{}, {arc.start, arc.end}, {}};
+                    output.add_improper_intersection(arc.start);
+                    output.add_improper_intersection(arc.end);
+                    return;
                 }
             } else if (equal(arc.start, arc_2.end)
                     && equal(arc.end, arc_2.start)) {
                 if (arc.orientation == arc_2.orientation) {
-                    return {{}, {arc.start, arc.end}, {}};
+                    output.add_improper_intersection(arc.start);
+                    output.add_improper_intersection(arc.end);
+                    return;
                 } else {
-                    return {{arc}, {}, {}};
+                    output.add_overlapping_part(arc);
+                    return;
                 }
             }
 
@@ -506,59 +563,65 @@ ShapeElementIntersectionsOutput compute_arc_arc_intersections(
 #endif
             if (strictly_greater(angle_2e, angle_2s)) {
                 if (strictly_greater(angle_2s, angle_1e)) {
-                    return {};
+                    return;
                 } else if (strictly_greater(angle_2e, angle_1e)) {
                     if (equal(arc2s, arc1e)) {
-                        return {{}, {arc2s}, {}};
+                        output.add_improper_intersection(arc2s);
+                        return;
                     } else {
-                        return {{build_circular_arc(arc2s, arc1e, arc.center, ShapeElementOrientation::Anticlockwise)}, {}, {}};
+                        output.add_overlapping_part(build_circular_arc(arc2s, arc1e, arc.center, ShapeElementOrientation::Anticlockwise));
+                        return;
                     }
                 } else {
-                    return {{build_circular_arc(arc2s, arc2e, arc.center, ShapeElementOrientation::Anticlockwise)}, {}, {}};
+                    output.add_overlapping_part(build_circular_arc(arc2s, arc2e, arc.center, ShapeElementOrientation::Anticlockwise));
+                    return;
                 }
             } else {
                 if (strictly_greater(angle_2e, angle_1e)) {
-                    return {{build_circular_arc(arc1s, arc1e, arc.center, ShapeElementOrientation::Anticlockwise)}, {}, {}};
+                    output.add_overlapping_part(build_circular_arc(arc1s, arc1e, arc.center, ShapeElementOrientation::Anticlockwise));
+                    return;
                 } else if (strictly_greater(angle_2s, angle_1e)) {
                     if (equal(arc1s, arc2e)) {
-                        return {{}, {arc1s}, {}};
+                        output.add_improper_intersection(arc1s);
+                        return;
                     } else {
-                        return {{build_circular_arc(arc1s, arc2e, arc.center, ShapeElementOrientation::Anticlockwise)}, {}, {}};
+                        output.add_overlapping_part(build_circular_arc(arc1s, arc2e, arc.center, ShapeElementOrientation::Anticlockwise));
+                        return;
                     }
                 } else {
-                    ShapeElementIntersectionsOutput output;
                     if (equal(arc2s, arc1e)) {
-                        output.improper_intersections.push_back(arc2s);
+                        output.add_improper_intersection(arc2s);
                     } else {
-                        output.overlapping_parts.push_back(build_circular_arc(arc2s, arc1e, arc.center, ShapeElementOrientation::Anticlockwise));
+                        output.add_overlapping_part(build_circular_arc(arc2s, arc1e, arc.center, ShapeElementOrientation::Anticlockwise));
                     }
                     if (equal(arc1s, arc2e)) {
-                        output.improper_intersections.push_back(arc1s);
+                        output.add_improper_intersection(arc1s);
                     } else {
-                        output.overlapping_parts.push_back(build_circular_arc(arc1s, arc2e, arc.center, ShapeElementOrientation::Anticlockwise));
+                        output.add_overlapping_part(build_circular_arc(arc1s, arc2e, arc.center, ShapeElementOrientation::Anticlockwise));
                     }
-                    return output;
+                    return;
                 }
             }
         } else {
-            return {};
+            return;
         }
     }
 
     LengthDbl radius_1 = arc.radius();
     LengthDbl radius_2 = arc_2.radius();
 
-    std::vector<Point> computed_points = shape::compute_circle_circle_intersections(
+    CircleIntersections computed_points = circle_circle_intersections(
             arc.center, radius_1, arc_2.center, radius_2);
-    std::vector<uint8_t> computed_points_valid(computed_points.size(), true);
-    std::vector<Point> end_points;
+    bool computed_points_valid[2] = {true, true};
+    std::array<Point, 4> end_points;
+    ElementPos number_of_end_points = 0;
 
     // Circle 1 contains arc 2 start.
     if (equal(distance(arc_2.start, arc.center), radius_1)) {
-        end_points.push_back(arc_2.start);
-        if (computed_points.size() == 0) {
-        } else if (computed_points.size() == 1
-                || squared_distance(arc_2.start, computed_points[0]) < squared_distance(arc_2.start, computed_points[1])) {
+        end_points[number_of_end_points++] = arc_2.start;
+        if (computed_points.size == 0) {
+        } else if (computed_points.size == 1
+                || squared_distance(arc_2.start, computed_points.points[0]) < squared_distance(arc_2.start, computed_points.points[1])) {
             computed_points_valid[0] = false;
         } else {
             computed_points_valid[1] = false;
@@ -567,10 +630,10 @@ ShapeElementIntersectionsOutput compute_arc_arc_intersections(
     // Circle 1 contains arc 2 end.
     if (!(arc_2.end == arc_2.start)
             && equal(distance(arc_2.end, arc.center), radius_1)) {
-        end_points.push_back(arc_2.end);
-        if (computed_points.size() == 0) {
-        } else if (computed_points.size() == 1
-                || squared_distance(arc_2.end, computed_points[0]) < squared_distance(arc_2.end, computed_points[1])) {
+        end_points[number_of_end_points++] = arc_2.end;
+        if (computed_points.size == 0) {
+        } else if (computed_points.size == 1
+                || squared_distance(arc_2.end, computed_points.points[0]) < squared_distance(arc_2.end, computed_points.points[1])) {
             computed_points_valid[0] = false;
         } else {
             computed_points_valid[1] = false;
@@ -580,10 +643,10 @@ ShapeElementIntersectionsOutput compute_arc_arc_intersections(
     if (!(arc.start == arc_2.start)
             && !(arc.start == arc_2.end)
             && equal(distance(arc.start, arc_2.center), radius_2)) {
-        end_points.push_back(arc.start);
-        if (computed_points.size() == 0) {
-        } else if (computed_points.size() == 1
-                || squared_distance(arc.start, computed_points[0]) < squared_distance(arc.start, computed_points[1])) {
+        end_points[number_of_end_points++] = arc.start;
+        if (computed_points.size == 0) {
+        } else if (computed_points.size == 1
+                || squared_distance(arc.start, computed_points.points[0]) < squared_distance(arc.start, computed_points.points[1])) {
             computed_points_valid[0] = false;
         } else {
             computed_points_valid[1] = false;
@@ -594,62 +657,428 @@ ShapeElementIntersectionsOutput compute_arc_arc_intersections(
             && !(arc.end == arc_2.end)
             && !(arc.end == arc.start)
             && equal(distance(arc.end, arc_2.center), radius_2)) {
-        end_points.push_back(arc.end);
-        if (computed_points.size() == 0) {
-        } else if (computed_points.size() == 1
-                || squared_distance(arc.end, computed_points[0]) < squared_distance(arc.end, computed_points[1])) {
+        end_points[number_of_end_points++] = arc.end;
+        if (computed_points.size == 0) {
+        } else if (computed_points.size == 1
+                || squared_distance(arc.end, computed_points.points[0]) < squared_distance(arc.end, computed_points.points[1])) {
             computed_points_valid[0] = false;
         } else {
             computed_points_valid[1] = false;
         }
     }
 
-    ShapeElementIntersectionsOutput output;
-    for (const Point& p: end_points)
+    for (ElementPos pos = 0; pos < number_of_end_points; ++pos) {
+        const Point& p = end_points[pos];
         if (arc.contains(p) && arc_2.contains(p))
-            output.improper_intersections.push_back(p);
-    for (ElementPos pos = 0; pos < (ElementPos)computed_points.size(); ++pos) {
+            output.add_improper_intersection(p);
+    }
+    for (ElementPos pos = 0; pos < computed_points.size; ++pos) {
         if (!computed_points_valid[pos])
             continue;
-        const Point& p = computed_points[pos];
+        const Point& p = computed_points.points[pos];
         // Check if any intersection coincides with an arc_2 endpoint
         if (arc.contains(p) && arc_2.contains(p)) {
-            if (computed_points.size() == 1) {
-                output.improper_intersections.push_back(p);
+            if (computed_points.size == 1) {
+                output.add_improper_intersection(p);
             } else {
-                output.proper_intersections.push_back(p);
+                output.add_proper_intersection(p);
             }
         }
     }
-    return output;
 }
 
+
+/**
+ * Check if two line segments intersect, without computing the
+ * intersections.
+ *
+ * Same cases as compute_line_line_intersections.
+ */
+bool line_line_intersect(
+        const ShapeElement& line1,
+        const ShapeElement& line2,
+        bool strict)
+{
+    if ((std::max)(line1.start.x, line1.end.x) + bounding_box_margin < (std::min)(line2.start.x, line2.end.x)
+            || (std::max)(line2.start.x, line2.end.x) + bounding_box_margin < (std::min)(line1.start.x, line1.end.x)
+            || (std::max)(line1.start.y, line1.end.y) + bounding_box_margin < (std::min)(line2.start.y, line2.end.y)
+            || (std::max)(line2.start.y, line2.end.y) + bounding_box_margin < (std::min)(line1.start.y, line1.end.y)) {
+        return false;
+    }
+
+    auto p = compute_line_intersection(line1.start, line1.end, line2.start, line2.end);
+
+    if (!p.first) {
+        // Colinear line segments only have overlapping parts and improper
+        // intersections.
+        if (strict)
+            return false;
+        if (!equal(signed_distance_point_to_line(line1.start, line2.start, line2.end), 0.0)
+                && !equal(signed_distance_point_to_line(line2.start, line1.start, line1.end), 0.0)) {
+            return false;
+        }
+
+        Point ref = line1.end - line1.start;
+        std::array<LengthDbl, 4> points_values = {
+            dot_product(line1.start - line1.start, ref),
+            dot_product(line1.end - line1.start, ref),
+            dot_product(line2.start - line1.start, ref),
+            dot_product(line2.end - line1.start, ref)};
+        std::array<ElementPos, 4> sorted_points = {0, 1, 2, 3};
+        std::sort(
+                sorted_points.begin(),
+                sorted_points.end(),
+                [&points_values](
+                    ElementPos point_pos_1,
+                    ElementPos point_pos_2)
+                {
+                    return points_values[point_pos_1] < points_values[point_pos_2];
+                });
+        if (sorted_points[0] + sorted_points[1] == 1
+                || sorted_points[0] + sorted_points[1] == 5) {
+            // The line segments are disjoint, unless they touch.
+            const Point& point_1 =
+                (sorted_points[1] == 0)? line1.start:
+                (sorted_points[1] == 1)? line1.end:
+                (sorted_points[1] == 2)? line2.start:
+                line2.end;
+            const Point& point_2 =
+                (sorted_points[2] == 0)? line1.start:
+                (sorted_points[2] == 1)? line1.end:
+                (sorted_points[2] == 2)? line2.start:
+                line2.end;
+            return equal(point_1, point_2);
+        }
+        return true;
+    }
+
+    if (!line1.contains(p.second) || !line2.contains(p.second))
+        return false;
+    if (!strict)
+        return true;
+    // The intersection is improper if it is an end point of one of the line
+    // segments.
+    return !(p.second == line1.start)
+        && !(p.second == line1.end)
+        && !(p.second == line2.start)
+        && !(p.second == line2.end);
 }
 
-ShapeElementIntersectionsOutput shape::compute_intersections(
+/**
+ * Check if a line segment and a circular arc intersect, without computing
+ * the intersections.
+ *
+ * Same cases as compute_line_arc_intersections.
+ */
+bool line_arc_intersect(
+        const ShapeElement& line,
+        const ShapeElement& arc,
+        bool strict)
+{
+    LengthDbl radius = arc.radius();
+
+    // The line segment is outside the circle or strictly inside the disk.
+    if (distance(arc.center, line) > radius + bounding_box_margin)
+        return false;
+    if (distance(line.start, arc.center) + bounding_box_margin < radius
+            && distance(line.end, arc.center) + bounding_box_margin < radius) {
+        return false;
+    }
+
+    CircleIntersections computed_points = line_circle_intersections(
+            line.start, line.end, arc.center, radius);
+    bool computed_points_valid[2] = {true, true};
+    // Invalidate the computed point corresponding to an end point and check
+    // if the end point is an intersection.
+    auto check_end_point = [&line, &arc, &computed_points, &computed_points_valid](
+            const Point& point)
+    {
+        if (computed_points.size == 0) {
+        } else if (computed_points.size == 1
+                || squared_distance(point, computed_points.points[0]) < squared_distance(point, computed_points.points[1])) {
+            computed_points_valid[0] = false;
+        } else {
+            computed_points_valid[1] = false;
+        }
+        return arc.contains(point) && line.contains(point);
+    };
+
+    // Circle contains line start.
+    if (equal(distance(line.start, arc.center), radius)) {
+        if (check_end_point(line.start) && !strict)
+            return true;
+    }
+    // Circle contains line end.
+    if (!(line.end == line.start)
+            && equal(distance(line.end, arc.center), radius)) {
+        if (check_end_point(line.end) && !strict)
+            return true;
+    }
+    // Line contains arc start.
+    if (!(arc.start == line.start)
+            && !(arc.start == line.end)
+            && equal(distance_point_to_line(arc.start, line.start, line.end), 0.0)) {
+        if (check_end_point(arc.start) && !strict)
+            return true;
+    }
+    // Line contains arc end.
+    if (!(arc.end == line.start)
+            && !(arc.end == line.end)
+            && !(arc.end == arc.start)
+            && equal(distance_point_to_line(arc.end, line.start, line.end), 0.0)) {
+        if (check_end_point(arc.end) && !strict)
+            return true;
+    }
+
+    // A single computed point is an improper intersection.
+    if (strict && computed_points.size != 2)
+        return false;
+    for (ElementPos pos = 0; pos < computed_points.size; ++pos) {
+        if (!computed_points_valid[pos])
+            continue;
+        const Point& p = computed_points.points[pos];
+        if (arc.contains(p) && line.contains(p))
+            return true;
+    }
+    return false;
+}
+
+/**
+ * Check if two circular arcs intersect, without computing the
+ * intersections.
+ *
+ * Same cases as compute_arc_arc_intersections.
+ */
+bool arc_arc_intersect(
+        const ShapeElement& arc,
+        const ShapeElement& arc_2,
+        bool strict)
+{
+    LengthDbl rsq = squared_distance(arc.center, arc.start);
+    LengthDbl r2sq = squared_distance(arc_2.center, arc_2.start);
+    if (equal(arc.center, arc_2.center)) {
+        // Arcs of a same circle only have overlapping parts and improper
+        // intersections.
+        if (strict || !equal(rsq, r2sq))
+            return false;
+        if (equal(arc.start, arc_2.start)
+                && equal(arc.end, arc_2.end)) {
+            return true;
+        } else if (equal(arc.start, arc_2.end)
+                && equal(arc.end, arc_2.start)) {
+            return true;
+        }
+
+        Point arc1s = (arc.orientation == ShapeElementOrientation::Anticlockwise)? arc.start: arc.end;
+        Point arc1e = (arc.orientation == ShapeElementOrientation::Anticlockwise)? arc.end: arc.start;
+        Point arc2s = (arc_2.orientation == ShapeElementOrientation::Anticlockwise)? arc_2.start: arc_2.end;
+        Point arc2e = (arc_2.orientation == ShapeElementOrientation::Anticlockwise)? arc_2.end: arc_2.start;
+        Point ref = arc1s - arc.center;
+        Angle angle_1e = angle_radian(ref, arc1e - arc.center);
+        Angle angle_2s = angle_radian(ref, arc2s - arc.center);
+        Angle angle_2e = angle_radian(ref, arc2e - arc.center);
+        return !strictly_greater(angle_2e, angle_2s)
+            || !strictly_greater(angle_2s, angle_1e);
+    }
+
+    LengthDbl radius_1 = arc.radius();
+    LengthDbl radius_2 = arc_2.radius();
+
+    // The circles are disjoint or one of them is strictly inside the other.
+    LengthDbl centers_distance = distance(arc.center, arc_2.center);
+    if (centers_distance > radius_1 + radius_2 + bounding_box_margin)
+        return false;
+    if (centers_distance + bounding_box_margin < std::abs(radius_1 - radius_2))
+        return false;
+
+    CircleIntersections computed_points = circle_circle_intersections(
+            arc.center, radius_1, arc_2.center, radius_2);
+    bool computed_points_valid[2] = {true, true};
+    // Invalidate the computed point corresponding to an end point and check
+    // if the end point is an intersection.
+    auto check_end_point = [&arc, &arc_2, &computed_points, &computed_points_valid](
+            const Point& point)
+    {
+        if (computed_points.size == 0) {
+        } else if (computed_points.size == 1
+                || squared_distance(point, computed_points.points[0]) < squared_distance(point, computed_points.points[1])) {
+            computed_points_valid[0] = false;
+        } else {
+            computed_points_valid[1] = false;
+        }
+        return arc.contains(point) && arc_2.contains(point);
+    };
+
+    // Circle 1 contains arc 2 start.
+    if (equal(distance(arc_2.start, arc.center), radius_1)) {
+        if (check_end_point(arc_2.start) && !strict)
+            return true;
+    }
+    // Circle 1 contains arc 2 end.
+    if (!(arc_2.end == arc_2.start)
+            && equal(distance(arc_2.end, arc.center), radius_1)) {
+        if (check_end_point(arc_2.end) && !strict)
+            return true;
+    }
+    // Circle 2 contains arc 1 start.
+    if (!(arc.start == arc_2.start)
+            && !(arc.start == arc_2.end)
+            && equal(distance(arc.start, arc_2.center), radius_2)) {
+        if (check_end_point(arc.start) && !strict)
+            return true;
+    }
+    // Circle 2 contains arc 1 end.
+    if (!(arc.end == arc_2.start)
+            && !(arc.end == arc_2.end)
+            && !(arc.end == arc.start)
+            && equal(distance(arc.end, arc_2.center), radius_2)) {
+        if (check_end_point(arc.end) && !strict)
+            return true;
+    }
+
+    // A single computed point is an improper intersection.
+    if (strict && computed_points.size != 2)
+        return false;
+    for (ElementPos pos = 0; pos < computed_points.size; ++pos) {
+        if (!computed_points_valid[pos])
+            continue;
+        const Point& p = computed_points.points[pos];
+        if (arc.contains(p) && arc_2.contains(p))
+            return true;
+    }
+    return false;
+}
+
+}
+
+void shape::compute_intersections(
         const ShapeElement& element_1,
-        const ShapeElement& element_2)
+        const ShapeElement& element_2,
+        FixedShapeElementIntersectionsOutput& output)
 {
+    output.number_of_overlapping_parts = 0;
+    output.number_of_improper_intersections = 0;
+    output.number_of_proper_intersections = 0;
     if (element_1.type == ShapeElementType::LineSegment
             && element_2.type == ShapeElementType::LineSegment) {
         // Line segment - Line segment intersection
-        return compute_line_line_intersections(element_1, element_2);
+        compute_line_line_intersections(element_1, element_2, output);
     } else if (element_1.type == ShapeElementType::LineSegment
             && element_2.type == ShapeElementType::CircularArc) {
         // Line segment - Circular arc intersection
-        return compute_line_arc_intersections(element_1, element_2);
+        compute_line_arc_intersections(element_1, element_2, output);
     } else if (element_1.type == ShapeElementType::CircularArc
             && element_2.type == ShapeElementType::LineSegment) {
-        return compute_line_arc_intersections(element_2, element_1);
+        compute_line_arc_intersections(element_2, element_1, output);
     } else if (element_1.type == ShapeElementType::CircularArc
             && element_2.type == ShapeElementType::CircularArc) {
         // Circular arc - Circular arc intersection
-        return compute_arc_arc_intersections(element_1, element_2);
+        compute_arc_arc_intersections(element_1, element_2, output);
+    } else {
+        throw std::invalid_argument(
+                FUNC_SIGNATURE + ": unsupported element types.");
+    }
+}
+
+ShapeElementIntersectionsOutput shape::compute_intersections(
+        const ShapeElement& element_1,
+        const ShapeElement& element_2)
+{
+    FixedShapeElementIntersectionsOutput output;
+    compute_intersections(element_1, element_2, output);
+    return output.to_output();
+}
+
+bool shape::intersect(
+        const ShapeElement& element_1,
+        const ShapeElement& element_2,
+        bool strict)
+{
+    if (element_1.type == ShapeElementType::LineSegment
+            && element_2.type == ShapeElementType::LineSegment) {
+        return line_line_intersect(element_1, element_2, strict);
+    } else if (element_1.type == ShapeElementType::LineSegment
+            && element_2.type == ShapeElementType::CircularArc) {
+        return line_arc_intersect(element_1, element_2, strict);
+    } else if (element_1.type == ShapeElementType::CircularArc
+            && element_2.type == ShapeElementType::LineSegment) {
+        return line_arc_intersect(element_2, element_1, strict);
+    } else if (element_1.type == ShapeElementType::CircularArc
+            && element_2.type == ShapeElementType::CircularArc) {
+        return arc_arc_intersect(element_1, element_2, strict);
     }
 
     throw std::invalid_argument(
             FUNC_SIGNATURE + ": unsupported element types.");
-    return {};
+    return false;
+}
+
+ShapeElementIntersectionsOutput FixedShapeElementIntersectionsOutput::to_output() const
+{
+    ShapeElementIntersectionsOutput output;
+    output.overlapping_parts.assign(
+            overlapping_parts.begin(),
+            overlapping_parts.begin() + number_of_overlapping_parts);
+    output.improper_intersections.assign(
+            improper_intersections.begin(),
+            improper_intersections.begin() + number_of_improper_intersections);
+    output.proper_intersections.assign(
+            proper_intersections.begin(),
+            proper_intersections.begin() + number_of_proper_intersections);
+    return output;
+}
+
+LengthDbl shape::distance(
+        const Point& point,
+        const ShapeElement& element)
+{
+    return distance(point, element.closest_point(point));
+}
+
+LengthDbl shape::distance(
+        const ShapeElement& element_1,
+        const ShapeElement& element_2)
+{
+    FixedShapeElementIntersectionsOutput intersections;
+    compute_intersections(element_1, element_2, intersections);
+    if (!intersections.empty())
+        return 0.0;
+
+    // If the elements don't intersect, the distance is reached at an
+    // endpoint of one of them, or at interior points of both. In the latter
+    // case, the segment between these points is normal to both elements, so
+    // the point of a circular arc is on the line through its center normal
+    // to the other element.
+    LengthDbl d = (std::min)(
+            (std::min)(distance(element_1.start, element_2), distance(element_1.end, element_2)),
+            (std::min)(distance(element_2.start, element_1), distance(element_2.end, element_1)));
+    for (int arc_pos = 0; arc_pos < 2; ++arc_pos) {
+        const ShapeElement& arc = (arc_pos == 0)? element_1: element_2;
+        const ShapeElement& other = (arc_pos == 0)? element_2: element_1;
+        if (arc.type != ShapeElementType::CircularArc)
+            continue;
+        Point direction;
+        if (other.type == ShapeElementType::LineSegment) {
+            if (other.start == other.end)
+                continue;
+            direction = {other.start.y - other.end.y, other.end.x - other.start.x};
+        } else {
+            if (other.center == arc.center)
+                continue;
+            direction = other.center - arc.center;
+        }
+        direction = normalize(direction);
+        LengthDbl radius = arc.radius();
+        for (LengthDbl sign: {-1.0, 1.0}) {
+            Point point = arc.center + (sign * radius) * direction;
+            if (arc.orientation != ShapeElementOrientation::Full
+                    && !arc.in_circular_arc_cone(point)) {
+                continue;
+            }
+            d = (std::min)(d, distance(point, other));
+        }
+    }
+    return d;
 }
 
 std::string ShapeElementIntersectionsOutput::to_string(Counter indentation) const
@@ -2,6 +2,10 @@
 
 #include "shape/shapes_intersections.hpp"
 
+#include "axis_aligned_bounding_boxes.hpp"
+#include "tasks.hpp"
+
+#include <queue>
 //#include <iostream>
 
 using namespace shape;
@@ -45,567 +49,1241 @@ SplitPositions find_median(
     return result;
 }
 
+/** Count the values which are not strictly greater than a position. */
+ShapePos count_not_strictly_greater(
+        const std::vector<LengthDbl>& values,
+        LengthDbl position)
+{
+    ShapePos count = 0;
+    for (LengthDbl value: values)
+        count += !strictly_greater(value, position);
+    return count;
 }
 
-IntersectionTree::IntersectionTree(
-        const std::vector<ShapeWithHoles>& shapes,
-        const std::vector<ShapeElement>& elements,
-        const std::vector<Point>& points):
-    shapes_(&shapes),
-    elements_(&elements),
-    points_(&points),
-    potentially_intersecting_shapes_(this->number_of_shapes()),
-    potentially_intersecting_elements_(this->number_of_elements()),
-    potentially_intersecting_points_(this->number_of_points())
-{
-    if (shapes.size() + elements.size() + points.size() < 32) {
-        small_ = true;
-        return;
-    }
+/** Count the values which are not strictly lesser than a position. */
+ShapePos count_not_strictly_lesser(
+        const std::vector<LengthDbl>& values,
+        LengthDbl position)
+{
+    ShapePos count = 0;
+    for (LengthDbl value: values)
+        count += !strictly_lesser(value, position);
+    return count;
+}
 
-    // Compute min/max of shapes and elements.
-    std::vector<AxisAlignedBoundingBox> shapes_min_max(shapes.size());
-    for (ShapePos shape_id = 0;
-            shape_id < (ShapePos)shapes.size();
-            ++shape_id) {
-        const ShapeWithHoles& shape = shapes[shape_id];
-        shapes_min_max[shape_id] = shape.compute_min_max();
-    }
-    std::vector<AxisAlignedBoundingBox> elements_min_max(elements.size());
-    for (ElementPos element_id = 0;
-            element_id < (ElementPos)elements.size();
-            ++element_id) {
-        const ShapeElement& element = elements[element_id];
-        elements_min_max[element_id] = element.min_max();
+/** Compute the distance between two bounding boxes. */
+LengthDbl aabb_distance(
+        const AxisAlignedBoundingBox& aabb_1,
+        const AxisAlignedBoundingBox& aabb_2)
+{
+    LengthDbl dx = (std::max)((std::max)(aabb_1.x_min - aabb_2.x_max, aabb_2.x_min - aabb_1.x_max), 0.0);
+    LengthDbl dy = (std::max)((std::max)(aabb_1.y_min - aabb_2.y_max, aabb_2.y_min - aabb_1.y_max), 0.0);
+    return std::hypot(dx, dy);
+}
+
+/**
+ * Convert (query, id) pairs into offsets and ids; the ids of each query are
+ * sorted and without duplicates.
+ */
+void build_offsets(
+        ElementPos number_of_queries,
+        const std::vector<std::pair<uint32_t, uint32_t>>& pairs,
+        std::vector<ElementPos>& offsets,
+        std::vector<ElementPos>& ids)
+{
+    offsets.assign(number_of_queries + 1, 0);
+    for (const auto& p: pairs)
+        offsets[p.first + 1]++;
+    for (ElementPos query_pos = 0; query_pos < number_of_queries; ++query_pos)
+        offsets[query_pos + 1] += offsets[query_pos];
+    ids.resize(pairs.size());
+    std::vector<ElementPos> positions(offsets.begin(), offsets.end() - 1);
+    for (const auto& p: pairs)
+        ids[positions[p.first]++] = p.second;
+
+    // Sort the ids of each query and remove duplicates.
+    ElementPos number_of_ids = 0;
+    for (ElementPos query_pos = 0; query_pos < number_of_queries; ++query_pos) {
+        auto begin = ids.begin() + offsets[query_pos];
+        auto end = ids.begin() + offsets[query_pos + 1];
+        std::sort(begin, end);
+        end = std::unique(begin, end);
+        offsets[query_pos] = number_of_ids;
+        std::copy(begin, end, ids.begin() + number_of_ids);
+        number_of_ids += end - begin;
     }
+    offsets[number_of_queries] = number_of_ids;
+    ids.resize(number_of_ids);
+}
 
-    ShapePos total_items = shapes.size() + elements.size() + points.size();
-    tree_.reserve(2 * total_items + 1);
+/**
+ * Keep the candidate ids of each query which pass the exact intersection
+ * test.
+ */
+template <typename Test>
+void filter_candidates(
+        const std::vector<ElementPos>& candidate_offsets,
+        const std::vector<ElementPos>& candidate_ids,
+        Test test,
+        std::vector<ElementPos>& offsets,
+        std::vector<ElementPos>& ids)
+{
+    ElementPos number_of_queries = candidate_offsets.size() - 1;
+    offsets.resize(number_of_queries + 1);
+    offsets[0] = 0;
+    for (ElementPos query_pos = 0; query_pos < number_of_queries; ++query_pos) {
+        for (ElementPos pos = candidate_offsets[query_pos];
+                pos < candidate_offsets[query_pos + 1];
+                ++pos) {
+            if (test(query_pos, candidate_ids[pos]))
+                ids.push_back(candidate_ids[pos]);
+        }
+        offsets[query_pos + 1] = ids.size();
+    }
+}
 
-    Node root;
-    // Compute root bounds.
-    for (ShapePos shape_id = 0;
-            shape_id < (ShapePos)shapes.size();
-            ++shape_id) {
-        root.l = (std::min)(root.l, shapes_min_max[shape_id].x_min);
-        root.r = (std::max)(root.r, shapes_min_max[shape_id].x_max);
-        root.b = (std::min)(root.b, shapes_min_max[shape_id].y_min);
-        root.t = (std::max)(root.t, shapes_min_max[shape_id].y_max);
-    }
-    for (ElementPos element_id = 0;
-            element_id < (ElementPos)elements.size();
-            ++element_id) {
-        const ShapeElement& element = elements[element_id];
-        root.l = (std::min)(root.l, elements_min_max[element_id].x_min);
-        root.r = (std::max)(root.r, elements_min_max[element_id].x_max);
-        root.b = (std::min)(root.b, elements_min_max[element_id].y_min);
-        root.t = (std::max)(root.t, elements_min_max[element_id].y_max);
+/**
+ * Evaluate candidates and return the outputs in the order of the
+ * candidates.
+ *
+ * The candidates are split into contiguous chunks, one per thread, run with
+ * run_tasks. Each chunk is written to its own buffer; the buffers are then
+ * concatenated in the order of the chunks, so the output doesn't depend on
+ * the number of threads.
+ */
+template <typename Candidate, typename Output, typename Evaluate>
+void evaluate_candidates(
+        const std::vector<Candidate>& candidates,
+        Counter number_of_threads,
+        const Executor& executor,
+        Evaluate evaluate,
+        std::vector<Output>& outputs)
+{
+    // Minimum number of candidates of a chunk.
+    const ElementPos chunk_size_min = 256;
+
+    ElementPos number_of_chunks = (std::min)(
+            (ElementPos)number_of_threads,
+            (ElementPos)candidates.size() / chunk_size_min);
+    if (number_of_chunks <= 1) {
+        for (const Candidate& candidate: candidates)
+            evaluate(candidate, outputs);
+        return;
     }
-    for (ElementPos point_id = 0;
-            point_id < (ElementPos)points.size();
-            ++point_id) {
-        const Point& point = points[point_id];
-        root.l = (std::min)(root.l, point.x);
-        root.r = (std::max)(root.r, point.x);
-        root.b = (std::min)(root.b, point.y);
-        root.t = (std::max)(root.t, point.y);
+
+    std::vector<std::vector<Output>> chunks_outputs(number_of_chunks);
+    auto evaluate_chunk = [&candidates, &evaluate, &chunks_outputs, number_of_chunks](
+            ElementPos chunk_pos)
+    {
+        ElementPos begin = candidates.size() * chunk_pos / number_of_chunks;
+        ElementPos end = candidates.size() * (chunk_pos + 1) / number_of_chunks;
+        for (ElementPos pos = begin; pos < end; ++pos)
+            evaluate(candidates[pos], chunks_outputs[chunk_pos]);
+    };
+    run_tasks(number_of_chunks, evaluate_chunk, number_of_threads, executor);
+
+    ElementPos number_of_outputs = outputs.size();
+    for (const std::vector<Output>& chunk_outputs: chunks_outputs)
+        number_of_outputs += chunk_outputs.size();
+    outputs.reserve(number_of_outputs);
+    for (std::vector<Output>& chunk_outputs: chunks_outputs) {
+        outputs.insert(
+                outputs.end(),
+                std::make_move_iterator(chunk_outputs.begin()),
+                std::make_move_iterator(chunk_outputs.end()));
     }
-    tree_.push_back(root);
+}
 
-    std::vector<StackElement> stack;
-    StackElement stack_initial_element;
-    stack_initial_element.node_id = 0;
-    stack_initial_element.shape_ids = std::vector<ShapePos>(shapes.size());
-    std::iota(stack_initial_element.shape_ids.begin(), stack_initial_element.shape_ids.end(), 0);
-    stack_initial_element.element_ids = std::vector<ElementPos>(elements.size());
-    std::iota(stack_initial_element.element_ids.begin(), stack_initial_element.element_ids.end(), 0);
-    stack_initial_element.point_ids = std::vector<ElementPos>(points.size());
-    std::iota(stack_initial_element.point_ids.begin(), stack_initial_element.point_ids.end(), 0);
-    stack.push_back(std::move(stack_initial_element));
+}
+
+struct IntersectionTree::BuildData
+{
+    const AxisAlignedBoundingBoxes& shapes_min_max;
+
+    const AxisAlignedBoundingBoxes& elements_min_max;
+
+    const std::vector<Point>& points;
+
+    ElementPos parallel_threshold;
+};
 
+struct IntersectionTree::BuildScratch
+{
     std::vector<double> values_x_right;
+
     std::vector<double> values_x_left;
+
     std::vector<double> values_y_bottom;
+
     std::vector<double> values_y_top;
+};
 
-    while (!stack.empty()) {
-        StackElement stack_element = std::move(stack.back());
-        stack.pop_back();
+char IntersectionTree::split_node(
+        const BuildData& data,
+        BuildScratch& scratch,
+        const StackElement& stack_element,
+        LengthDbl& split,
+        StackElement& stack_element_lesser,
+        StackElement& stack_element_greater)
+{
+    const AxisAlignedBoundingBoxes& shapes_min_max = data.shapes_min_max;
+    const AxisAlignedBoundingBoxes& elements_min_max = data.elements_min_max;
+    const std::vector<Point>& points = data.points;
+    const AxisAlignedBoundingBox& node_aabb = stack_element.aabb;
+
+    std::vector<double>& values_x_right = scratch.values_x_right;
+    std::vector<double>& values_x_left = scratch.values_x_left;
+    std::vector<double>& values_y_bottom = scratch.values_y_bottom;
+    std::vector<double>& values_y_top = scratch.values_y_top;
+    values_x_right.clear();
+    values_x_left.clear();
+    values_y_bottom.clear();
+    values_y_top.clear();
+    for (ItemPos shape_id: stack_element.shape_ids)
+        values_x_left.push_back(shapes_min_max.x_min[shape_id]);
+    for (ItemPos element_id: stack_element.element_ids)
+        values_x_left.push_back(elements_min_max.x_min[element_id]);
+    for (ItemPos shape_id: stack_element.shape_ids)
+        values_x_right.push_back(shapes_min_max.x_max[shape_id]);
+    for (ItemPos element_id: stack_element.element_ids)
+        values_x_right.push_back(elements_min_max.x_max[element_id]);
+    for (ItemPos shape_id: stack_element.shape_ids)
+        values_y_bottom.push_back(shapes_min_max.y_min[shape_id]);
+    for (ItemPos element_id: stack_element.element_ids)
+        values_y_bottom.push_back(elements_min_max.y_min[element_id]);
+    for (ItemPos shape_id: stack_element.shape_ids)
+        values_y_top.push_back(shapes_min_max.y_max[shape_id]);
+    for (ItemPos element_id: stack_element.element_ids)
+        values_y_top.push_back(elements_min_max.y_max[element_id]);
+    for (ItemPos point_id: stack_element.point_ids) {
+        const Point& point = points[point_id];
+        values_x_left.push_back(point.x);
+        values_x_right.push_back(point.x);
+        values_y_bottom.push_back(point.y);
+        values_y_top.push_back(point.y);
+    }
 
-        NodeId node_id = stack_element.node_id;
-        Node& node = tree_[node_id];
-
-        values_x_right.clear();
-        values_x_left.clear();
-        values_y_bottom.clear();
-        values_y_top.clear();
-        for (ShapePos shape_id: stack_element.shape_ids) {
-            values_x_left.push_back(shapes_min_max[shape_id].x_min);
-            values_x_right.push_back(shapes_min_max[shape_id].x_max);
-            values_y_bottom.push_back(shapes_min_max[shape_id].y_min);
-            values_y_top.push_back(shapes_min_max[shape_id].y_max);
-        }
-        for (ElementPos element_id: stack_element.element_ids) {
-            const AxisAlignedBoundingBox& aabb = elements_min_max[element_id];
-            values_x_left.push_back(aabb.x_min);
-            values_x_right.push_back(aabb.x_max);
-            values_y_bottom.push_back(aabb.y_min);
-            values_y_top.push_back(aabb.y_max);
-        }
-        for (ElementPos point_id: stack_element.point_ids) {
+    // Compute split position candidates.
+    SplitPositions xs = find_median(values_x_left, values_x_right, node_aabb.x_min, node_aabb.x_max);
+    SplitPositions ys = find_median(values_y_bottom, values_y_top, node_aabb.y_min, node_aabb.y_max);
+
+    // Count the items on each side of each candidate. The counts don't
+    // depend on the order of the values, so they are computed with streaming
+    // passes over the values reordered by find_median.
+    ShapePos nl[2] = {}, nr[2] = {}, nb[2] = {}, nt[2] = {};
+    for (int i = 0; i < xs.count; ++i) {
+        nl[i] = count_not_strictly_greater(values_x_left, xs.values[i]);
+        nr[i] = count_not_strictly_lesser(values_x_right, xs.values[i]);
+    }
+    for (int i = 0; i < ys.count; ++i) {
+        nb[i] = count_not_strictly_greater(values_y_bottom, ys.values[i]);
+        nt[i] = count_not_strictly_lesser(values_y_top, ys.values[i]);
+    }
+
+    // Select best cut.
+    char best = 'x';
+    ShapePos n = stack_element.shape_ids.size() + stack_element.element_ids.size() + stack_element.point_ids.size();
+    ShapePos n_best = n * (n - 1) / 2;
+    int i_best = -1;
+    for (int i = 0; i < xs.count; ++i) {
+        if (nl[i] == 0 || nr[i] == 0)
+            continue;
+        ShapePos nv = nl[i] * (nl[i] - 1) / 2 + nr[i] * (nr[i] - 1) / 2;
+        if (n_best > nv) {
+            n_best = nv;
+            best = 'v';
+            i_best = i;
+        }
+    }
+    for (int i = 0; i < ys.count; ++i) {
+        if (nb[i] == 0 || nt[i] == 0)
+            continue;
+        ShapePos nh = nb[i] * (nb[i] - 1) / 2 + nt[i] * (nt[i] - 1) / 2;
+        if (n_best > nh) {
+            n_best = nh;
+            best = 'h';
+            i_best = i;
+        }
+    }
+    if (best == 'x')
+        return best;
+
+    // Build only the winning split's two partition lists.
+    stack_element_lesser.aabb = node_aabb;
+    stack_element_greater.aabb = node_aabb;
+    split = (best == 'v')? xs.values[i_best]: ys.values[i_best];
+    if (best == 'v') {
+        for (ItemPos shape_id: stack_element.shape_ids) {
+            if (!strictly_greater(shapes_min_max.x_min[shape_id], split))
+                stack_element_lesser.shape_ids.push_back(shape_id);
+            if (!strictly_lesser(shapes_min_max.x_max[shape_id], split))
+                stack_element_greater.shape_ids.push_back(shape_id);
+        }
+        for (ItemPos element_id: stack_element.element_ids) {
+            if (!strictly_greater(elements_min_max.x_min[element_id], split))
+                stack_element_lesser.element_ids.push_back(element_id);
+            if (!strictly_lesser(elements_min_max.x_max[element_id], split))
+                stack_element_greater.element_ids.push_back(element_id);
+        }
+        for (ItemPos point_id: stack_element.point_ids) {
             const Point& point = points[point_id];
-            values_x_left.push_back(point.x);
-            values_x_right.push_back(point.x);
-            values_y_bottom.push_back(point.y);
-            values_y_top.push_back(point.y);
-        }
-
-        // Compute split position candidates.
-        SplitPositions xs = find_median(values_x_left, values_x_right, node.l, node.r);
-        SplitPositions ys = find_median(values_y_bottom, values_y_top, node.b, node.t);
-
-        // Count-only pass: determine item counts per candidate without building lists.
-        ShapePos nl[2] = {}, nr[2] = {}, nb[2] = {}, nt[2] = {};
-        for (ShapePos shape_id: stack_element.shape_ids) {
-            const AxisAlignedBoundingBox& aabb = shapes_min_max[shape_id];
-            for (int i = 0; i < xs.count; ++i) {
-                if (!strictly_greater(aabb.x_min, xs.values[i]))
-                    nl[i]++;
-                if (!strictly_lesser(aabb.x_max, xs.values[i]))
-                    nr[i]++;
-            }
-            for (int i = 0; i < ys.count; ++i) {
-                if (!strictly_greater(aabb.y_min, ys.values[i]))
-                    nb[i]++;
-                if (!strictly_lesser(aabb.y_max, ys.values[i]))
-                    nt[i]++;
-            }
+            if (!strictly_greater(point.x, split))
+                stack_element_lesser.point_ids.push_back(point_id);
+            if (!strictly_lesser(point.x, split))
+                stack_element_greater.point_ids.push_back(point_id);
         }
-        for (ElementPos element_id: stack_element.element_ids) {
-            const AxisAlignedBoundingBox& aabb = elements_min_max[element_id];
-            for (int i = 0; i < xs.count; ++i) {
-                if (!strictly_greater(aabb.x_min, xs.values[i]))
-                    nl[i]++;
-                if (!strictly_lesser(aabb.x_max, xs.values[i]))
-                    nr[i]++;
-            }
-            for (int i = 0; i < ys.count; ++i) {
-                if (!strictly_greater(aabb.y_min, ys.values[i]))
-                    nb[i]++;
-                if (!strictly_lesser(aabb.y_max, ys.values[i]))
-                    nt[i]++;
-            }
+        stack_element_lesser.aabb.x_max = split;
+        stack_element_greater.aabb.x_min = split;
+    } else {  // best == 'h'
+        for (ItemPos shape_id: stack_element.shape_ids) {
+            if (!strictly_greater(shapes_min_max.y_min[shape_id], split))
+                stack_element_lesser.shape_ids.push_back(shape_id);
+            if (!strictly_lesser(shapes_min_max.y_max[shape_id], split))
+                stack_element_greater.shape_ids.push_back(shape_id);
         }
-        for (ElementPos point_id: stack_element.point_ids) {
+        for (ItemPos element_id: stack_element.element_ids) {
+            if (!strictly_greater(elements_min_max.y_min[element_id], split))
+                stack_element_lesser.element_ids.push_back(element_id);
+            if (!strictly_lesser(elements_min_max.y_max[element_id], split))
+                stack_element_greater.element_ids.push_back(element_id);
+        }
+        for (ItemPos point_id: stack_element.point_ids) {
             const Point& point = points[point_id];
-            for (int i = 0; i < xs.count; ++i) {
-                if (!strictly_greater(point.x, xs.values[i]))
-                    nl[i]++;
-                if (!strictly_lesser(point.x, xs.values[i]))
-                    nr[i]++;
-            }
-            for (int i = 0; i < ys.count; ++i) {
-                if (!strictly_greater(point.y, ys.values[i]))
-                    nb[i]++;
-                if (!strictly_lesser(point.y, ys.values[i]))
-                    nt[i]++;
-            }
+            if (!strictly_greater(point.y, split))
+                stack_element_lesser.point_ids.push_back(point_id);
+            if (!strictly_lesser(point.y, split))
+                stack_element_greater.point_ids.push_back(point_id);
         }
+        stack_element_lesser.aabb.y_max = split;
+        stack_element_greater.aabb.y_min = split;
+    }
+    return best;
+}
 
-        // Select best cut.
-        char best = 'x';
-        ShapePos n = stack_element.shape_ids.size() + stack_element.element_ids.size() + stack_element.point_ids.size();
-        ShapePos n_best = n * (n - 1) / 2;
-        int i_best = -1;
-        for (int i = 0; i < xs.count; ++i) {
-            if (nl[i] == 0 || nr[i] == 0)
-                continue;
-            ShapePos nv = nl[i] * (nl[i] - 1) / 2 + nr[i] * (nr[i] - 1) / 2;
-            if (n_best > nv) {
-                n_best = nv;
-                best = 'v';
-                i_best = i;
-            }
+IntersectionTree::Subtree IntersectionTree::build_subtree(
+        const BuildData& data,
+        StackElement stack_element)
+{
+    Subtree subtree;
+    ElementPos number_of_items = stack_element.shape_ids.size()
+        + stack_element.element_ids.size()
+        + stack_element.point_ids.size();
+    subtree.nodes.reserve(2 * number_of_items + 1);
+    subtree.item_ids.reserve(2 * number_of_items);
+    subtree.nodes.push_back(Node());
+    stack_element.node_id = 0;
+
+    BuildScratch scratch;
+    std::vector<StackElement> stack;
+    stack.push_back(std::move(stack_element));
+    while (!stack.empty()) {
+        StackElement stack_element = std::move(stack.back());
+        stack.pop_back();
+        NodeId node_id = stack_element.node_id;
+
+        LengthDbl split = 0.0;
+        StackElement stack_element_lesser;
+        StackElement stack_element_greater;
+        char direction = split_node(
+                data,
+                scratch,
+                stack_element,
+                split,
+                stack_element_lesser,
+                stack_element_greater);
+
+        Node& node = subtree.nodes[node_id];
+        node.direction = direction;
+        if (direction == 'x') {
+            node.items_start = subtree.item_ids.size();
+            node.number_of_shapes = stack_element.shape_ids.size();
+            node.number_of_elements = stack_element.element_ids.size();
+            node.number_of_points = stack_element.point_ids.size();
+            subtree.item_ids.insert(subtree.item_ids.end(), stack_element.shape_ids.begin(), stack_element.shape_ids.end());
+            subtree.item_ids.insert(subtree.item_ids.end(), stack_element.element_ids.begin(), stack_element.element_ids.end());
+            subtree.item_ids.insert(subtree.item_ids.end(), stack_element.point_ids.begin(), stack_element.point_ids.end());
+            continue;
         }
-        for (int i = 0; i < ys.count; ++i) {
-            if (nb[i] == 0 || nt[i] == 0)
-                continue;
-            ShapePos nh = nb[i] * (nb[i] - 1) / 2 + nt[i] * (nt[i] - 1) / 2;
-            if (n_best > nh) {
-                n_best = nh;
-                best = 'h';
-                i_best = i;
+        node.position = split;
+        node.lesser_child_id = subtree.nodes.size();
+        stack_element_lesser.node_id = subtree.nodes.size();
+        stack_element_greater.node_id = subtree.nodes.size() + 1;
+        subtree.nodes.push_back(Node());
+        subtree.nodes.push_back(Node());
+        stack.push_back(std::move(stack_element_greater));
+        stack.push_back(std::move(stack_element_lesser));
+    }
+    return subtree;
+}
+
+IntersectionTree::Subtree IntersectionTree::merge_subtrees(
+        const Node& node,
+        Subtree&& subtree_lesser,
+        Subtree&& subtree_greater)
+{
+    Subtree subtree;
+    subtree.nodes.reserve(
+            subtree_lesser.nodes.size()
+            + subtree_greater.nodes.size() + 1);
+    subtree.item_ids.reserve(
+            subtree_lesser.item_ids.size()
+            + subtree_greater.item_ids.size());
+    subtree.nodes.push_back(node);
+    subtree.nodes[0].lesser_child_id = 1;
+    subtree.nodes.push_back(Node());
+    subtree.nodes.push_back(Node());
+
+    // Append the subtrees of the children at the positions they have in a
+    // sequential build.
+    NodeId lesser_offset = subtree.nodes.size() - 1;
+    NodeId greater_offset = lesser_offset + subtree_lesser.nodes.size() - 1;
+    for (const auto& p: {
+            std::make_pair(&subtree_lesser, lesser_offset),
+            std::make_pair(&subtree_greater, greater_offset)}) {
+        Subtree& child_subtree = *p.first;
+        NodeId offset = p.second;
+        ItemPos items_offset = subtree.item_ids.size();
+        for (NodeId child_node_id = 0;
+                child_node_id < (NodeId)child_subtree.nodes.size();
+                ++child_node_id) {
+            Node& child_node = child_subtree.nodes[child_node_id];
+            if (child_node.direction == 'x') {
+                child_node.items_start += items_offset;
+            } else {
+                child_node.lesser_child_id += offset;
             }
+            if (child_node_id > 0)
+                subtree.nodes.push_back(child_node);
         }
+        subtree.item_ids.insert(
+                subtree.item_ids.end(),
+                child_subtree.item_ids.begin(),
+                child_subtree.item_ids.end());
+    }
+    subtree.nodes[1] = subtree_lesser.nodes[0];
+    subtree.nodes[2] = subtree_greater.nodes[0];
+    return subtree;
+}
 
-        if (best == 'x') {
-            node.direction = 'x';
-            node.shape_ids = std::move(stack_element.shape_ids);
-            node.element_ids = std::move(stack_element.element_ids);
-            node.point_ids = std::move(stack_element.point_ids);
-        } else {
-            // Build only the winning split's two partition lists.
-            StackElement stack_element_lesser;
-            StackElement stack_element_greater;
-
-            if (best == 'v') {
-                LengthDbl split = xs.values[i_best];
-                node.direction = 'v';
-                node.position = split;
-                for (ShapePos shape_id: stack_element.shape_ids) {
-                    const AxisAlignedBoundingBox& aabb = shapes_min_max[shape_id];
-                    if (!strictly_greater(aabb.x_min, split))
-                        stack_element_lesser.shape_ids.push_back(shape_id);
-                    if (!strictly_lesser(aabb.x_max, split))
-                        stack_element_greater.shape_ids.push_back(shape_id);
-                }
-                for (ElementPos element_id: stack_element.element_ids) {
-                    const AxisAlignedBoundingBox& aabb = elements_min_max[element_id];
-                    if (!strictly_greater(aabb.x_min, split))
-                        stack_element_lesser.element_ids.push_back(element_id);
-                    if (!strictly_lesser(aabb.x_max, split))
-                        stack_element_greater.element_ids.push_back(element_id);
-                }
-                for (ElementPos point_id: stack_element.point_ids) {
-                    const Point& point = points[point_id];
-                    if (!strictly_greater(point.x, split))
-                        stack_element_lesser.point_ids.push_back(point_id);
-                    if (!strictly_lesser(point.x, split))
-                        stack_element_greater.point_ids.push_back(point_id);
-                }
-                Node child_lesser;
-                child_lesser.l = node.l;
-                child_lesser.r = split;
-                child_lesser.b = node.b;
-                child_lesser.t = node.t;
-                Node child_greater;
-                child_greater.l = split;
-                child_greater.r = node.r;
-                child_greater.b = node.b;
-                child_greater.t = node.t;
-                node.lesser_child_id = tree_.size();
-                node.greater_child_id = tree_.size() + 1;
-                tree_.push_back(child_lesser);
-                tree_.push_back(child_greater);
-            } else {  // best == 'h'
-                LengthDbl split = ys.values[i_best];
-                node.direction = 'h';
-                node.position = split;
-                for (ShapePos shape_id: stack_element.shape_ids) {
-                    const AxisAlignedBoundingBox& aabb = shapes_min_max[shape_id];
-                    if (!strictly_greater(aabb.y_min, split))
-                        stack_element_lesser.shape_ids.push_back(shape_id);
-                    if (!strictly_lesser(aabb.y_max, split))
-                        stack_element_greater.shape_ids.push_back(shape_id);
-                }
-                for (ElementPos element_id: stack_element.element_ids) {
-                    const AxisAlignedBoundingBox& aabb = elements_min_max[element_id];
-                    if (!strictly_greater(aabb.y_min, split))
-                        stack_element_lesser.element_ids.push_back(element_id);
-                    if (!strictly_lesser(aabb.y_max, split))
-                        stack_element_greater.element_ids.push_back(element_id);
-                }
-                for (ElementPos point_id: stack_element.point_ids) {
-                    const Point& point = points[point_id];
-                    if (!strictly_greater(point.y, split))
-                        stack_element_lesser.point_ids.push_back(point_id);
-                    if (!strictly_lesser(point.y, split))
-                        stack_element_greater.point_ids.push_back(point_id);
-                }
-                Node child_lesser;
-                child_lesser.l = node.l;
-                child_lesser.r = node.r;
-                child_lesser.b = node.b;
-                child_lesser.t = split;
-                Node child_greater;
-                child_greater.l = node.l;
-                child_greater.r = node.r;
-                child_greater.b = split;
-                child_greater.t = node.t;
-                node.lesser_child_id = tree_.size();
-                node.greater_child_id = tree_.size() + 1;
-                tree_.push_back(child_lesser);
-                tree_.push_back(child_greater);
-            }
+IntersectionTree::Subtree IntersectionTree::build_subtree(
+        const BuildData& data,
+        StackElement stack_element,
+        Counter number_of_threads,
+        const Executor& executor)
+{
+    // Node of the top of the subtree. Its children are split further as
+    // long as there are threads left; otherwise, it is the root of a task.
+    struct TopNode
+    {
+        StackElement stack_element;
+
+        Counter number_of_threads;
+
+        Node node;
+
+        /** Position of the lesser child in the top nodes. */
+        ElementPos lesser_child_pos = -1;
+
+        /** Position of the task of the node. */
+        ElementPos task_pos = -1;
+    };
+
+    // Split the top of the subtree. The children of a top node are after it.
+    std::vector<TopNode> top_nodes;
+    std::vector<StackElement> tasks;
+    top_nodes.push_back({std::move(stack_element), number_of_threads, Node()});
+    BuildScratch scratch;
+    for (ElementPos top_node_pos = 0;
+            top_node_pos < (ElementPos)top_nodes.size();
+            ++top_node_pos) {
+        TopNode& top_node = top_nodes[top_node_pos];
+        ElementPos number_of_items = top_node.stack_element.shape_ids.size()
+            + top_node.stack_element.element_ids.size()
+            + top_node.stack_element.point_ids.size();
+        LengthDbl split = 0.0;
+        StackElement stack_element_lesser;
+        StackElement stack_element_greater;
+        if (top_node.number_of_threads > 1
+                && number_of_items >= data.parallel_threshold) {
+            top_node.node.direction = split_node(
+                    data,
+                    scratch,
+                    top_node.stack_element,
+                    split,
+                    stack_element_lesser,
+                    stack_element_greater);
+        }
+        if (top_node.node.direction == 'x') {
+            top_node.task_pos = tasks.size();
+            tasks.push_back(std::move(top_node.stack_element));
+            continue;
+        }
+        top_node.node.position = split;
+        top_node.lesser_child_pos = top_nodes.size();
+        top_node.stack_element = StackElement();
+        Counter number_of_threads_lesser = top_node.number_of_threads / 2;
+        Counter number_of_threads_greater = top_node.number_of_threads - number_of_threads_lesser;
+        top_nodes.push_back({std::move(stack_element_lesser), number_of_threads_lesser, Node()});
+        top_nodes.push_back({std::move(stack_element_greater), number_of_threads_greater, Node()});
+    }
 
-            stack_element_lesser.node_id = node.lesser_child_id;
-            stack_element_greater.node_id = node.greater_child_id;
-            stack.push_back(std::move(stack_element_greater));
-            stack.push_back(std::move(stack_element_lesser));
+    // Build the subtrees of the tasks.
+    std::vector<Subtree> subtrees(tasks.size());
+    run_tasks(
+            tasks.size(),
+            [&data, &tasks, &subtrees](ElementPos task_pos)
+            {
+                subtrees[task_pos] = build_subtree(data, std::move(tasks[task_pos]));
+            },
+            number_of_threads,
+            executor);
+
+    // Merge the subtrees, from the bottom of the top.
+    std::vector<Subtree> top_subtrees(top_nodes.size());
+    for (ElementPos top_node_pos = top_nodes.size() - 1;
+            top_node_pos >= 0;
+            --top_node_pos) {
+        const TopNode& top_node = top_nodes[top_node_pos];
+        if (top_node.task_pos != -1) {
+            top_subtrees[top_node_pos] = std::move(subtrees[top_node.task_pos]);
+        } else {
+            top_subtrees[top_node_pos] = merge_subtrees(
+                    top_node.node,
+                    std::move(top_subtrees[top_node.lesser_child_pos]),
+                    std::move(top_subtrees[top_node.lesser_child_pos + 1]));
         }
     }
-    //std::cout << "IntersectionTree::IntersectionTree end" << std::endl;
+    return std::move(top_subtrees.front());
 }
 
-IntersectionTree::IntersectOutput IntersectionTree::intersect(
-        const ShapeWithHoles& shape,
-        bool strict) const
+IntersectionTree::IntersectionTree(
+        const std::vector<ShapeWithHoles>& shapes,
+        const std::vector<ShapeElement>& elements,
+        const std::vector<Point>& points,
+        const IntersectionTreeParameters& parameters):
+    shapes_((!shapes.empty())? &shapes: nullptr),
+    elements_((!elements.empty())? &elements: nullptr),
+    points_((!points.empty())? &points: nullptr),
+    scratch_(*this)
 {
-    //std::cout << "intersect..." << std::endl;
-    IntersectOutput output;
+    build(parameters);
+}
 
-    if (small_) {
-        potentially_intersecting_shapes_.fill();
-        potentially_intersecting_elements_.fill();
-        potentially_intersecting_points_.fill();
+namespace
+{
 
-    } else {
-        AxisAlignedBoundingBox aabb = shape.compute_min_max();
+std::vector<ElementPos> compute_rings_elements_offsets(
+        const std::vector<Ring>& rings)
+{
+    std::vector<ElementPos> offsets = {0};
+    for (const Ring& ring: rings)
+        offsets.push_back(offsets.back() + ring.number_of_elements());
+    return offsets;
+}
+
+}
+
+IntersectionTree::IntersectionTree(
+        const std::vector<Ring>& rings,
+        const IntersectionTreeParameters& parameters):
+    rings_(&rings),
+    rings_elements_offsets_(compute_rings_elements_offsets(rings)),
+    scratch_(*this)
+{
+    build(parameters);
+}
+
+std::pair<ShapePos, ElementPos> IntersectionTree::ring_element(
+        ElementPos element_id) const
+{
+    if (rings_ == nullptr) {
+        throw std::invalid_argument(
+                FUNC_SIGNATURE + ": "
+                "the tree has not been built on rings.");
+    }
+    ShapePos ring_pos = std::upper_bound(
+            rings_elements_offsets_.begin(),
+            rings_elements_offsets_.end(),
+            element_id) - rings_elements_offsets_.begin() - 1;
+    return {ring_pos, element_id - rings_elements_offsets_[ring_pos]};
+}
+
+void IntersectionTree::build(const IntersectionTreeParameters& parameters)
+{
+    if (number_of_shapes() + number_of_elements() + number_of_points() < 32) {
+        small_ = true;
+        return;
+    }
+
+    // Compute min/max of shapes and elements.
+    AxisAlignedBoundingBoxes shapes_min_max;
+    if (shapes_ != nullptr)
+        shapes_min_max = AxisAlignedBoundingBoxes(*shapes_);
+    AxisAlignedBoundingBoxes elements_min_max;
+    if (elements_ != nullptr) {
+        elements_min_max = AxisAlignedBoundingBoxes(*elements_);
+    } else if (rings_ != nullptr) {
+        elements_min_max.reserve(number_of_elements());
+        for (const Ring& ring: *rings_)
+            for (ElementPos element_pos = 0;
+                    element_pos < ring.number_of_elements();
+                    ++element_pos)
+                elements_min_max.push_back(ring.element(element_pos).min_max());
+    }
+    std::vector<Point> points_empty;
+    const std::vector<Point>& points = (points_ != nullptr)? *points_: points_empty;
+
+    ShapePos total_items = number_of_shapes() + number_of_elements() + number_of_points();
+    if (total_items > (ShapePos)std::numeric_limits<ItemPos>::max() / 4) {
+        throw std::invalid_argument(
+                FUNC_SIGNATURE + ": "
+                "too many items; "
+                "total_items: " + std::to_string(total_items) + ".");
+    }
+
+    StackElement stack_initial_element;
+    stack_initial_element.node_id = 0;
+    // Compute root bounds.
+    AxisAlignedBoundingBox& root_aabb = stack_initial_element.aabb;
+    root_aabb = merge(shapes_min_max.merge(), elements_min_max.merge());
+    for (ElementPos point_id = 0;
+            point_id < (ElementPos)points.size();
+            ++point_id) {
+        const Point& point = points[point_id];
+        root_aabb.x_min = (std::min)(root_aabb.x_min, point.x);
+        root_aabb.x_max = (std::max)(root_aabb.x_max, point.x);
+        root_aabb.y_min = (std::min)(root_aabb.y_min, point.y);
+        root_aabb.y_max = (std::max)(root_aabb.y_max, point.y);
+    }
+    stack_initial_element.shape_ids = std::vector<ItemPos>(number_of_shapes());
+    std::iota(stack_initial_element.shape_ids.begin(), stack_initial_element.shape_ids.end(), 0);
+    stack_initial_element.element_ids = std::vector<ItemPos>(number_of_elements());
+    std::iota(stack_initial_element.element_ids.begin(), stack_initial_element.element_ids.end(), 0);
+    stack_initial_element.point_ids = std::vector<ItemPos>(points.size());
+    std::iota(stack_initial_element.point_ids.begin(), stack_initial_element.point_ids.end(), 0);
 
-        potentially_intersecting_shapes_.clear();
-        potentially_intersecting_elements_.clear();
-        potentially_intersecting_points_.clear();
-        intersect_stack_.clear();
-        intersect_stack_.push_back(0);
+    BuildData data = {
+        shapes_min_max,
+        elements_min_max,
+        points,
+        parameters.parallel_threshold};
+    Subtree subtree = build_subtree(
+            data,
+            std::move(stack_initial_element),
+            parameters.number_of_threads,
+            parameters.executor);
+    tree_ = std::move(subtree.nodes);
+    item_ids_ = std::move(subtree.item_ids);
+    //std::cout << "IntersectionTree::IntersectionTree end" << std::endl;
+}
 
-        while (!intersect_stack_.empty()) {
+IntersectionTree::IntersectionTree(
+        std::vector<ShapeWithHoles>&& shapes,
+        std::vector<ShapeElement>&& elements,
+        std::vector<Point>&& points,
+        const IntersectionTreeParameters& parameters):
+    IntersectionTree(
+            std::make_shared<const Geometry>(Geometry{
+                std::move(shapes),
+                std::move(elements),
+                std::move(points)}),
+            parameters)
+{
+}
 
-            NodeId node_id = intersect_stack_.back();
-            intersect_stack_.pop_back();
-            const Node& node = tree_[node_id];
+IntersectionTree::IntersectionTree(
+        std::shared_ptr<const Geometry> geometry,
+        const IntersectionTreeParameters& parameters):
+    IntersectionTree(
+            geometry->shapes,
+            geometry->elements,
+            geometry->points,
+            parameters)
+{
+    geometry_ = std::move(geometry);
+}
 
-            if (node.direction == 'x') {
-                for (ShapePos shape_id: node.shape_ids)
-                    potentially_intersecting_shapes_.add(shape_id);
-                for (ElementPos element_id: node.element_ids)
-                    potentially_intersecting_elements_.add(element_id);
-                for (ElementPos point_id: node.point_ids)
-                    potentially_intersecting_points_.add(point_id);
-            } else if (node.direction == 'v') {
-                if (!strictly_greater(aabb.x_min, node.position))
-                    intersect_stack_.push_back(node.lesser_child_id);
-                if (!strictly_lesser(aabb.x_max, node.position))
-                    intersect_stack_.push_back(node.greater_child_id);
-            } else {  // node.direction == 'h'
-                if (!strictly_greater(aabb.y_min, node.position))
-                    intersect_stack_.push_back(node.lesser_child_id);
-                if (!strictly_lesser(aabb.y_max, node.position))
-                    intersect_stack_.push_back(node.greater_child_id);
-            }
+IntersectionTree::QueryScratch::QueryScratch(
+        const IntersectionTree& intersection_tree):
+    potentially_intersecting_shapes(intersection_tree.number_of_shapes()),
+    potentially_intersecting_elements(intersection_tree.number_of_elements()),
+    potentially_intersecting_points(intersection_tree.number_of_points())
+{
+}
+
+void IntersectionTree::find_potentially_intersecting(
+        const AxisAlignedBoundingBox& aabb,
+        QueryScratch& scratch) const
+{
+    scratch.output.shape_ids.clear();
+    scratch.output.element_ids.clear();
+    scratch.output.point_ids.clear();
+
+    if (small_) {
+        scratch.potentially_intersecting_shapes.fill();
+        scratch.potentially_intersecting_elements.fill();
+        scratch.potentially_intersecting_points.fill();
+        return;
+    }
+
+    scratch.potentially_intersecting_shapes.clear();
+    scratch.potentially_intersecting_elements.clear();
+    scratch.potentially_intersecting_points.clear();
+    scratch.stack.clear();
+    scratch.stack.push_back(0);
+
+    while (!scratch.stack.empty()) {
+
+        NodeId node_id = scratch.stack.back();
+        scratch.stack.pop_back();
+        const Node& node = tree_[node_id];
+
+        if (node.direction == 'x') {
+            for (ItemPos pos = node.shapes_begin(); pos < node.elements_begin(); ++pos)
+                scratch.potentially_intersecting_shapes.add(item_ids_[pos]);
+            for (ItemPos pos = node.elements_begin(); pos < node.points_begin(); ++pos)
+                scratch.potentially_intersecting_elements.add(item_ids_[pos]);
+            for (ItemPos pos = node.points_begin(); pos < node.points_end(); ++pos)
+                scratch.potentially_intersecting_points.add(item_ids_[pos]);
+        } else if (node.direction == 'v') {
+            if (!strictly_greater(aabb.x_min, node.position))
+                scratch.stack.push_back(node.lesser_child_id);
+            if (!strictly_lesser(aabb.x_max, node.position))
+                scratch.stack.push_back(node.lesser_child_id + 1);
+        } else {  // node.direction == 'h'
+            if (!strictly_greater(aabb.y_min, node.position))
+                scratch.stack.push_back(node.lesser_child_id);
+            if (!strictly_lesser(aabb.y_max, node.position))
+                scratch.stack.push_back(node.lesser_child_id + 1);
         }
     }
+}
+
+const IntersectionTree::IntersectOutput& IntersectionTree::intersect(
+        const ShapeWithHoles& shape,
+        bool strict,
+        QueryScratch& scratch) const
+{
+    find_potentially_intersecting(
+            (small_)? AxisAlignedBoundingBox(): shape.compute_min_max(),
+            scratch);
 
-    for (ShapePos shape_id: potentially_intersecting_shapes_)
+    IntersectOutput& output = scratch.output;
+    for (ShapePos shape_id: scratch.potentially_intersecting_shapes)
         if (shape::intersect(shape, this->shape(shape_id), strict))
             output.shape_ids.push_back(shape_id);
-    for (ShapePos element_id: potentially_intersecting_elements_)
+    for (ShapePos element_id: scratch.potentially_intersecting_elements)
         if (shape::intersect(shape, this->element(element_id), strict))
             output.element_ids.push_back(element_id);
-    for (ShapePos point_id: potentially_intersecting_points_)
+    for (ShapePos point_id: scratch.potentially_intersecting_points)
         if (shape.contains(this->point(point_id), strict))
             output.point_ids.push_back(point_id);
     return output;
 }
 
-IntersectionTree::IntersectOutput IntersectionTree::intersect(
+const IntersectionTree::IntersectOutput& IntersectionTree::intersect(
         const Shape& shape,
-        bool strict) const
+        bool strict,
+        QueryScratch& scratch) const
 {
-    //std::cout << "intersect..." << std::endl;
-    IntersectOutput output;
-
-    if (small_) {
-        potentially_intersecting_shapes_.fill();
-        potentially_intersecting_elements_.fill();
-        potentially_intersecting_points_.fill();
-
-    } else {
-        AxisAlignedBoundingBox aabb = shape.compute_min_max();
-
-        potentially_intersecting_shapes_.clear();
-        potentially_intersecting_elements_.clear();
-        potentially_intersecting_points_.clear();
-        intersect_stack_.clear();
-        intersect_stack_.push_back(0);
-
-        while (!intersect_stack_.empty()) {
-
-            NodeId node_id = intersect_stack_.back();
-            intersect_stack_.pop_back();
-            const Node& node = tree_[node_id];
-
-            if (node.direction == 'x') {
-                for (ShapePos shape_id: node.shape_ids)
-                    potentially_intersecting_shapes_.add(shape_id);
-                for (ElementPos element_id: node.element_ids)
-                    potentially_intersecting_elements_.add(element_id);
-                for (ElementPos point_id: node.point_ids)
-                    potentially_intersecting_points_.add(point_id);
-            } else if (node.direction == 'v') {
-                if (!strictly_greater(aabb.x_min, node.position))
-                    intersect_stack_.push_back(node.lesser_child_id);
-                if (!strictly_lesser(aabb.x_max, node.position))
-                    intersect_stack_.push_back(node.greater_child_id);
-            } else {  // node.direction == 'h'
-                if (!strictly_greater(aabb.y_min, node.position))
-                    intersect_stack_.push_back(node.lesser_child_id);
-                if (!strictly_lesser(aabb.y_max, node.position))
-                    intersect_stack_.push_back(node.greater_child_id);
-            }
-        }
-    }
+    find_potentially_intersecting(
+            (small_)? AxisAlignedBoundingBox(): shape.compute_min_max(),
+            scratch);
 
-    for (ShapePos shape_id: potentially_intersecting_shapes_)
+    IntersectOutput& output = scratch.output;
+    for (ShapePos shape_id: scratch.potentially_intersecting_shapes)
         if (shape::intersect(shape, this->shape(shape_id), strict))
             output.shape_ids.push_back(shape_id);
-    for (ShapePos element_id: potentially_intersecting_elements_)
+    for (ShapePos element_id: scratch.potentially_intersecting_elements)
         if (shape::intersect(shape, this->element(element_id), strict))
             output.element_ids.push_back(element_id);
-    for (ShapePos point_id: potentially_intersecting_points_)
+    for (ShapePos point_id: scratch.potentially_intersecting_points)
         if (shape.contains(this->point(point_id), strict))
             output.point_ids.push_back(point_id);
     return output;
 }
 
-IntersectionTree::IntersectOutput IntersectionTree::intersect(
+const IntersectionTree::IntersectOutput& IntersectionTree::intersect(
         const ShapeElement& element,
-        bool strict) const
+        bool strict,
+        QueryScratch& scratch) const
 {
-    IntersectOutput output;
-
-    if (small_) {
-        potentially_intersecting_shapes_.fill();
-        potentially_intersecting_elements_.fill();
-        potentially_intersecting_points_.fill();
-
-    } else {
-        AxisAlignedBoundingBox aabb = element.min_max();
-
-        potentially_intersecting_shapes_.clear();
-        potentially_intersecting_elements_.clear();
-        potentially_intersecting_points_.clear();
-        intersect_stack_.clear();
-        intersect_stack_.push_back(0);
-
-        while (!intersect_stack_.empty()) {
-
-            NodeId node_id = intersect_stack_.back();
-            intersect_stack_.pop_back();
-            const Node& node = tree_[node_id];
-
-            if (node.direction == 'x') {
-                for (ShapePos shape_id: node.shape_ids)
-                    potentially_intersecting_shapes_.add(shape_id);
-                for (ElementPos element_id: node.element_ids)
-                    potentially_intersecting_elements_.add(element_id);
-                for (ElementPos point_id: node.point_ids)
-                    potentially_intersecting_points_.add(point_id);
-            } else if (node.direction == 'v') {
-                if (!strictly_greater(aabb.x_min, node.position))
-                    intersect_stack_.push_back(node.lesser_child_id);
-                if (!strictly_lesser(aabb.x_max, node.position))
-                    intersect_stack_.push_back(node.greater_child_id);
-            } else {  // node.direction == 'h'
-                if (!strictly_greater(aabb.y_min, node.position))
-                    intersect_stack_.push_back(node.lesser_child_id);
-                if (!strictly_lesser(aabb.y_max, node.position))
-                    intersect_stack_.push_back(node.greater_child_id);
-            }
-        }
-    }
+    find_potentially_intersecting(
+            (small_)? AxisAlignedBoundingBox(): element.min_max(),
+            scratch);
 
-    std::vector<ShapePos> intersecting_shapes;
-    for (ShapePos shape_id: potentially_intersecting_shapes_)
+    IntersectOutput& output = scratch.output;
+    for (ShapePos shape_id: scratch.potentially_intersecting_shapes)
         if (shape::intersect(this->shape(shape_id), element, strict))
             output.shape_ids.push_back(shape_id);
     if (strict) {
-        for (ElementPos element_id: potentially_intersecting_elements_) {
-            ShapeElementIntersectionsOutput intersections = compute_intersections(this->element(element_id), element);
-            if (!intersections.improper_intersections.empty())
+        FixedShapeElementIntersectionsOutput intersections;
+        for (ElementPos element_id: scratch.potentially_intersecting_elements) {
+            compute_intersections(this->element(element_id), element, intersections);
+            if (intersections.number_of_improper_intersections > 0)
                 output.element_ids.push_back(element_id);
         }
     } else {
-        for (ElementPos element_id: potentially_intersecting_elements_) {
-            ShapeElementIntersectionsOutput intersections = compute_intersections(this->element(element_id), element);
-            if (!intersections.overlapping_parts.empty()
-                    || !intersections.improper_intersections.empty()
-                    || !intersections.improper_intersections.empty()) {
+        for (ElementPos element_id: scratch.potentially_intersecting_elements)
+            if (shape::intersect(this->element(element_id), element))
                 output.element_ids.push_back(element_id);
-            }
-        }
-
     }
     if (!strict) {
-        for (ShapePos point_id: potentially_intersecting_points_)
+        for (ShapePos point_id: scratch.potentially_intersecting_points)
             if (element.contains(this->point(point_id)))
                 output.point_ids.push_back(point_id);
     }
     return output;
 }
 
+const IntersectionTree::IntersectOutput& IntersectionTree::intersect(
+        const Point& point,
+        bool strict,
+        QueryScratch& scratch) const
+{
+    AxisAlignedBoundingBox aabb;
+    aabb.x_min = point.x;
+    aabb.x_max = point.x;
+    aabb.y_min = point.y;
+    aabb.y_max = point.y;
+    find_potentially_intersecting(aabb, scratch);
+
+    IntersectOutput& output = scratch.output;
+    for (ShapePos shape_id: scratch.potentially_intersecting_shapes)
+        if (this->shape(shape_id).contains(point, strict))
+            output.shape_ids.push_back(shape_id);
+    if (!strict) {
+        for (ElementPos element_id: scratch.potentially_intersecting_elements)
+            if (this->element(element_id).contains(point))
+                output.element_ids.push_back(element_id);
+        for (ShapePos point_id: scratch.potentially_intersecting_points)
+            if (equal(point, this->point(point_id)))
+                output.point_ids.push_back(point_id);
+    }
+    return output;
+}
+
+IntersectionTree::IntersectOutput IntersectionTree::intersect(
+        const ShapeWithHoles& shape,
+        bool strict) const
+{
+    return intersect(shape, strict, scratch_);
+}
+
+IntersectionTree::IntersectOutput IntersectionTree::intersect(
+        const Shape& shape,
+        bool strict) const
+{
+    return intersect(shape, strict, scratch_);
+}
+
+IntersectionTree::IntersectOutput IntersectionTree::intersect(
+        const ShapeElement& element,
+        bool strict) const
+{
+    return intersect(element, strict, scratch_);
+}
+
 IntersectionTree::IntersectOutput IntersectionTree::intersect(
         const Point& point,
         bool strict) const
 {
-    IntersectOutput output;
+    return intersect(point, strict, scratch_);
+}
+
+void IntersectionTree::find_potentially_intersecting_batch(
+        const std::vector<AxisAlignedBoundingBox>& aabbs,
+        IntersectBatchOutput& candidates) const
+{
+    std::vector<std::pair<uint32_t, uint32_t>> shape_pairs;
+    std::vector<std::pair<uint32_t, uint32_t>> element_pairs;
+    std::vector<std::pair<uint32_t, uint32_t>> point_pairs;
+    ItemPos number_of_queries = aabbs.size();
 
     if (small_) {
-        potentially_intersecting_shapes_.fill();
-        potentially_intersecting_elements_.fill();
-        potentially_intersecting_points_.fill();
+        for (ItemPos query_pos = 0; query_pos < number_of_queries; ++query_pos) {
+            for (ItemPos shape_id = 0; shape_id < number_of_shapes(); ++shape_id)
+                shape_pairs.push_back({query_pos, shape_id});
+            for (ItemPos element_id = 0; element_id < number_of_elements(); ++element_id)
+                element_pairs.push_back({query_pos, element_id});
+            for (ItemPos point_id = 0; point_id < number_of_points(); ++point_id)
+                point_pairs.push_back({query_pos, point_id});
+        }
+    } else if (number_of_queries > 0) {
+        // Lists of the queries reaching the nodes being processed. The root
+        // uses the first list, and the children of a node at depth d use the
+        // lists 2d + 1 and 2d + 2, so that the list of a node which is still
+        // in the stack is never overwritten.
+        std::vector<std::vector<ItemPos>> query_lists(1);
+        query_lists[0].resize(number_of_queries);
+        std::iota(query_lists[0].begin(), query_lists[0].end(), 0);
+
+        struct BatchStackElement
+        {
+            NodeId node_id;
+            ItemPos depth;
+            ItemPos list_id;
+        };
+        std::vector<BatchStackElement> stack = {{0, 0, 0}};
+        while (!stack.empty()) {
+            BatchStackElement stack_element = stack.back();
+            stack.pop_back();
+            const Node& node = tree_[stack_element.node_id];
+
+            ItemPos list_id_lesser = 2 * stack_element.depth + 1;
+            ItemPos list_id_greater = 2 * stack_element.depth + 2;
+            if (node.direction != 'x' && query_lists.size() <= list_id_greater)
+                query_lists.resize(list_id_greater + 1);
+            const std::vector<ItemPos>& queries = query_lists[stack_element.list_id];
 
-    } else {
-        potentially_intersecting_shapes_.clear();
-        potentially_intersecting_elements_.clear();
-        potentially_intersecting_points_.clear();
-        intersect_stack_.clear();
-        intersect_stack_.push_back(0);
+            if (node.direction == 'x') {
+                for (ItemPos query_pos: queries) {
+                    for (ItemPos pos = node.shapes_begin(); pos < node.elements_begin(); ++pos)
+                        shape_pairs.push_back({query_pos, item_ids_[pos]});
+                    for (ItemPos pos = node.elements_begin(); pos < node.points_begin(); ++pos)
+                        element_pairs.push_back({query_pos, item_ids_[pos]});
+                    for (ItemPos pos = node.points_begin(); pos < node.points_end(); ++pos)
+                        point_pairs.push_back({query_pos, item_ids_[pos]});
+                }
+                continue;
+            }
+
+            std::vector<ItemPos>& queries_lesser = query_lists[list_id_lesser];
+            std::vector<ItemPos>& queries_greater = query_lists[list_id_greater];
+            queries_lesser.clear();
+            queries_greater.clear();
+            for (ItemPos query_pos: queries) {
+                const AxisAlignedBoundingBox& aabb = aabbs[query_pos];
+                LengthDbl min = (node.direction == 'v')? aabb.x_min: aabb.y_min;
+                LengthDbl max = (node.direction == 'v')? aabb.x_max: aabb.y_max;
+                if (!strictly_greater(min, node.position))
+                    queries_lesser.push_back(query_pos);
+                if (!strictly_lesser(max, node.position))
+                    queries_greater.push_back(query_pos);
+            }
+            if (!queries_greater.empty()) {
+                stack.push_back({
+                        node.lesser_child_id + 1,
+                        stack_element.depth + 1,
+                        list_id_greater});
+            }
+            if (!queries_lesser.empty()) {
+                stack.push_back({
+                        node.lesser_child_id,
+                        stack_element.depth + 1,
+                        list_id_lesser});
+            }
+        }
+    }
+
+    build_offsets(number_of_queries, shape_pairs, candidates.shape_offsets, candidates.shape_ids);
+    build_offsets(number_of_queries, element_pairs, candidates.element_offsets, candidates.element_ids);
+    build_offsets(number_of_queries, point_pairs, candidates.point_offsets, candidates.point_ids);
+}
+
+IntersectionTree::IntersectBatchOutput IntersectionTree::intersect_batch(
+        const std::vector<Point>& points,
+        bool strict) const
+{
+    std::vector<AxisAlignedBoundingBox> aabbs(points.size());
+    for (ElementPos query_pos = 0;
+            query_pos < (ElementPos)points.size();
+            ++query_pos) {
+        const Point& point = points[query_pos];
+        AxisAlignedBoundingBox& aabb = aabbs[query_pos];
+        aabb.x_min = point.x;
+        aabb.x_max = point.x;
+        aabb.y_min = point.y;
+        aabb.y_max = point.y;
+    }
+    IntersectBatchOutput candidates;
+    find_potentially_intersecting_batch(aabbs, candidates);
+
+    IntersectBatchOutput output;
+    filter_candidates(
+            candidates.shape_offsets,
+            candidates.shape_ids,
+            [this, &points, strict](ElementPos query_pos, ShapePos shape_id)
+            {
+                return this->shape(shape_id).contains(points[query_pos], strict);
+            },
+            output.shape_offsets,
+            output.shape_ids);
+    filter_candidates(
+            candidates.element_offsets,
+            candidates.element_ids,
+            [this, &points, strict](ElementPos query_pos, ElementPos element_id)
+            {
+                return !strict && this->element(element_id).contains(points[query_pos]);
+            },
+            output.element_offsets,
+            output.element_ids);
+    filter_candidates(
+            candidates.point_offsets,
+            candidates.point_ids,
+            [this, &points, strict](ElementPos query_pos, ElementPos point_id)
+            {
+                return !strict && equal(points[query_pos], this->point(point_id));
+            },
+            output.point_offsets,
+            output.point_ids);
+    return output;
+}
+
+IntersectionTree::IntersectBatchOutput IntersectionTree::intersect_batch(
+        const std::vector<ShapeElement>& elements,
+        bool strict) const
+{
+    std::vector<AxisAlignedBoundingBox> aabbs(elements.size());
+    for (ElementPos query_pos = 0;
+            query_pos < (ElementPos)elements.size();
+            ++query_pos) {
+        aabbs[query_pos] = elements[query_pos].min_max();
+    }
+    IntersectBatchOutput candidates;
+    find_potentially_intersecting_batch(aabbs, candidates);
+
+    IntersectBatchOutput output;
+    filter_candidates(
+            candidates.shape_offsets,
+            candidates.shape_ids,
+            [this, &elements, strict](ElementPos query_pos, ShapePos shape_id)
+            {
+                return shape::intersect(this->shape(shape_id), elements[query_pos], strict);
+            },
+            output.shape_offsets,
+            output.shape_ids);
+    filter_candidates(
+            candidates.element_offsets,
+            candidates.element_ids,
+            [this, &elements, strict](ElementPos query_pos, ElementPos element_id)
+            {
+                if (!strict)
+                    return shape::intersect(this->element(element_id), elements[query_pos]);
+                FixedShapeElementIntersectionsOutput intersections;
+                compute_intersections(
+                        this->element(element_id),
+                        elements[query_pos],
+                        intersections);
+                return intersections.number_of_improper_intersections > 0;
+            },
+            output.element_offsets,
+            output.element_ids);
+    filter_candidates(
+            candidates.point_offsets,
+            candidates.point_ids,
+            [this, &elements, strict](ElementPos query_pos, ElementPos point_id)
+            {
+                return !strict && elements[query_pos].contains(this->point(point_id));
+            },
+            output.point_offsets,
+            output.point_ids);
+    return output;
+}
+
+IntersectionTree::ElementDistance IntersectionTree::nearest_element(
+        const Point& point) const
+{
+    std::vector<ElementDistance> output = k_nearest(point, 1);
+    if (output.empty())
+        return ElementDistance();
+    return output.front();
+}
+
+std::vector<IntersectionTree::ElementDistance> IntersectionTree::k_nearest(
+        const Point& point,
+        ElementPos k) const
+{
+    std::vector<ElementDistance> output;
+    if (k <= 0 || number_of_elements() == 0)
+        return output;
+
+    // Sorted by distance, then by id.
+    auto compare = [](const ElementDistance& element_distance_1, const ElementDistance& element_distance_2)
+    {
+        if (element_distance_1.distance != element_distance_2.distance)
+            return element_distance_1.distance < element_distance_2.distance;
+        return element_distance_1.element_id < element_distance_2.element_id;
+    };
+    auto add = [this, &point, k, &output, &compare](ElementPos element_id)
+    {
+        // An element might be in several leaves.
+        for (const ElementDistance& element_distance: output)
+            if (element_distance.element_id == element_id)
+                return;
+        ElementDistance element_distance;
+        element_distance.element_id = element_id;
+        element_distance.distance = distance(point, this->element(element_id));
+        if ((ElementPos)output.size() == k && !compare(element_distance, output.back()))
+            return;
+        output.insert(
+                std::upper_bound(output.begin(), output.end(), element_distance, compare),
+                element_distance);
+        if ((ElementPos)output.size() > k)
+            output.pop_back();
+    };
+
+    if (small_) {
+        for (ElementPos element_id = 0; element_id < number_of_elements(); ++element_id)
+            add(element_id);
+        return output;
+    }
+
+    // Best-first traversal. The region of a node is the part of the plane
+    // delimited by the cuts of its ancestors. An element at distance d of
+    // the point is in a leaf whose region is at distance at most d.
+    struct QueueElement
+    {
+        LengthDbl bound;
+        NodeId node_id;
+        AxisAlignedBoundingBox region;
+
+        bool operator<(const QueueElement& queue_element) const
+        {
+            return bound > queue_element.bound;
+        }
+    };
+    AxisAlignedBoundingBox root_region;
+    root_region.x_min = -std::numeric_limits<LengthDbl>::infinity();
+    root_region.x_max = +std::numeric_limits<LengthDbl>::infinity();
+    root_region.y_min = -std::numeric_limits<LengthDbl>::infinity();
+    root_region.y_max = +std::numeric_limits<LengthDbl>::infinity();
+    std::priority_queue<QueueElement> queue;
+    queue.push({0.0, 0, root_region});
+    while (!queue.empty()) {
+        QueueElement queue_element = queue.top();
+        queue.pop();
+        if ((ElementPos)output.size() == k
+                && queue_element.bound > output.back().distance) {
+            break;
+        }
+        const Node& node = tree_[queue_element.node_id];
 
-        while (!intersect_stack_.empty()) {
+        if (node.direction == 'x') {
+            for (ItemPos pos = node.elements_begin(); pos < node.points_begin(); ++pos)
+                add(item_ids_[pos]);
+            continue;
+        }
 
-            NodeId node_id = intersect_stack_.back();
-            intersect_stack_.pop_back();
-            const Node& node = tree_[node_id];
+        AxisAlignedBoundingBox region_lesser = queue_element.region;
+        AxisAlignedBoundingBox region_greater = queue_element.region;
+        if (node.direction == 'v') {
+            region_lesser.x_max = node.position;
+            region_greater.x_min = node.position;
+        } else {  // node.direction == 'h'
+            region_lesser.y_max = node.position;
+            region_greater.y_min = node.position;
+        }
+        for (int child_pos = 0; child_pos < 2; ++child_pos) {
+            const AxisAlignedBoundingBox& region = (child_pos == 0)? region_lesser: region_greater;
+            LengthDbl dx = (std::max)((std::max)(region.x_min - point.x, point.x - region.x_max), 0.0);
+            LengthDbl dy = (std::max)((std::max)(region.y_min - point.y, point.y - region.y_max), 0.0);
+            LengthDbl bound = (std::max)(queue_element.bound, std::hypot(dx, dy));
+            if ((ElementPos)output.size() == k && bound > output.back().distance)
+                continue;
+            queue.push({bound, node.lesser_child_id + child_pos, region});
+        }
+    }
+    return output;
+}
 
+std::vector<IntersectionTree::ElementDistance> IntersectionTree::elements_within_distance(
+        const ShapeWithHoles& shape,
+        LengthDbl distance) const
+{
+    std::vector<ElementDistance> output;
+    if (number_of_elements() == 0)
+        return output;
+
+    // Find the elements whose bounding box is at distance at most 'distance'
+    // of the bounding box of the shape.
+    AxisAlignedBoundingBox shape_aabb = shape.compute_min_max();
+    AxisAlignedBoundingBox aabb = shape_aabb;
+    aabb.x_min -= distance;
+    aabb.x_max += distance;
+    aabb.y_min -= distance;
+    aabb.y_max += distance;
+    std::vector<ElementPos> element_ids;
+    if (small_) {
+        for (ElementPos element_id = 0; element_id < number_of_elements(); ++element_id)
+            element_ids.push_back(element_id);
+    } else {
+        std::vector<NodeId> stack = {0};
+        while (!stack.empty()) {
+            const Node& node = tree_[stack.back()];
+            stack.pop_back();
             if (node.direction == 'x') {
-                for (ShapePos shape_id: node.shape_ids)
-                    potentially_intersecting_shapes_.add(shape_id);
-                for (ElementPos element_id: node.element_ids)
-                    potentially_intersecting_elements_.add(element_id);
-                for (ElementPos point_id: node.point_ids)
-                    potentially_intersecting_points_.add(point_id);
+                for (ItemPos pos = node.elements_begin(); pos < node.points_begin(); ++pos)
+                    element_ids.push_back(item_ids_[pos]);
             } else if (node.direction == 'v') {
-                if (!strictly_greater(point.x, node.position))
-                    intersect_stack_.push_back(node.lesser_child_id);
-                if (!strictly_lesser(point.x, node.position))
-                    intersect_stack_.push_back(node.greater_child_id);
+                if (!strictly_greater(aabb.x_min, node.position))
+                    stack.push_back(node.lesser_child_id);
+                if (!strictly_lesser(aabb.x_max, node.position))
+                    stack.push_back(node.lesser_child_id + 1);
             } else {  // node.direction == 'h'
-                if (!strictly_greater(point.y, node.position))
-                    intersect_stack_.push_back(node.lesser_child_id);
-                if (!strictly_lesser(point.y, node.position))
-                    intersect_stack_.push_back(node.greater_child_id);
+                if (!strictly_greater(aabb.y_min, node.position))
+                    stack.push_back(node.lesser_child_id);
+                if (!strictly_lesser(aabb.y_max, node.position))
+                    stack.push_back(node.lesser_child_id + 1);
             }
         }
+        std::sort(element_ids.begin(), element_ids.end());
+        element_ids.erase(
+                std::unique(element_ids.begin(), element_ids.end()),
+                element_ids.end());
     }
 
-    std::vector<ShapePos> intersecting_shapes;
-    for (ShapePos shape_id: potentially_intersecting_shapes_)
-        if (this->shape(shape_id).contains(point, strict))
-            output.shape_ids.push_back(shape_id);
-    if (!strict) {
-        for (ElementPos element_id: potentially_intersecting_elements_)
-            if (this->element(element_id).contains(point))
-                output.element_ids.push_back(element_id);
-        for (ShapePos point_id: potentially_intersecting_points_)
-            if (equal(point, this->point(point_id)))
-                output.point_ids.push_back(point_id);
+    std::vector<const ShapeElement*> shape_elements;
+    std::vector<AxisAlignedBoundingBox> shape_elements_aabbs;
+    for (ShapePos hole_pos = -1;
+            hole_pos < (ShapePos)shape.holes.size();
+            ++hole_pos) {
+        const Shape& loop = (hole_pos == -1)? shape.shape: shape.holes[hole_pos];
+        for (const ShapeElement& shape_element: loop.elements) {
+            shape_elements.push_back(&shape_element);
+            shape_elements_aabbs.push_back(shape_element.min_max());
+        }
+    }
+
+    for (ElementPos element_id: element_ids) {
+        const ShapeElement& element = this->element(element_id);
+        AxisAlignedBoundingBox element_aabb = element.min_max();
+        if (strictly_greater(aabb_distance(element_aabb, shape_aabb), distance))
+            continue;
+        LengthDbl element_distance = 0.0;
+        if (!shape::intersect(shape, element, false)) {
+            // Distance to the boundary of the shape.
+            element_distance = std::numeric_limits<LengthDbl>::infinity();
+            for (ElementPos pos = 0; pos < (ElementPos)shape_elements.size(); ++pos) {
+                if (aabb_distance(element_aabb, shape_elements_aabbs[pos]) >= element_distance)
+                    continue;
+                element_distance = (std::min)(
+                        element_distance,
+                        shape::distance(element, *shape_elements[pos]));
+            }
+        }
+        if (!strictly_greater(element_distance, distance))
+            output.push_back({element_id, element_distance});
     }
     return output;
 }
 
-std::vector<std::pair<ShapePos, ShapePos>> IntersectionTree::compute_intersecting_shapes(bool strict) const
+std::vector<std::pair<ShapePos, ShapePos>> IntersectionTree::compute_intersecting_shapes(
+        bool strict,
+        Counter number_of_threads,
+        const Executor& executor) const
 {
     //std::cout << "compute_intersecting_shapes..." << std::endl;
-    if (shapes_->empty())
+    if (number_of_shapes() == 0)
         return {};
 
     if (small_) {
         std::vector<std::pair<ShapePos, ShapePos>> intersecting_shapes;
         for (ShapePos shape_1_pos = 0;
-                shape_1_pos < (ShapePos)shapes_->size();
+                shape_1_pos < number_of_shapes();
                 ++shape_1_pos) {
             for (ShapePos shape_2_pos = shape_1_pos + 1;
-                    shape_2_pos < (ShapePos)shapes_->size();
+                    shape_2_pos < number_of_shapes();
                     ++shape_2_pos) {
                 if (shape::intersect(this->shape(shape_1_pos), this->shape(shape_2_pos), strict))
                     intersecting_shapes.push_back({shape_1_pos, shape_2_pos});
@@ -618,14 +1296,14 @@ std::vector<std::pair<ShapePos, ShapePos>> IntersectionTree::compute_intersectin
     for (const Node& node: tree_) {
         if (node.direction != 'x')
             continue;
-        for (ShapePos pos_1 = 0;
-                pos_1 < node.shape_ids.size();
+        for (ItemPos pos_1 = node.shapes_begin();
+                pos_1 < node.elements_begin();
                 ++pos_1) {
-            ShapePos shape_id_1 = node.shape_ids[pos_1];
-            for (ShapePos pos_2 = pos_1 + 1;
-                    pos_2 < node.shape_ids.size();
+            ShapePos shape_id_1 = item_ids_[pos_1];
+            for (ItemPos pos_2 = pos_1 + 1;
+                    pos_2 < node.elements_begin();
                     ++pos_2) {
-                ShapePos shape_id_2 = node.shape_ids[pos_2];
+                ShapePos shape_id_2 = item_ids_[pos_2];
                 potentially_intersecting_shapes.push_back({shape_id_1, shape_id_2});
             }
         }
@@ -639,25 +1317,37 @@ std::vector<std::pair<ShapePos, ShapePos>> IntersectionTree::compute_intersectin
 
     // Compute intersections.
     std::vector<std::pair<ShapePos, ShapePos>> intersecting_shapes;
-    for (auto p: potentially_intersecting_shapes)
-        if (shape::intersect(this->shape(p.first), this->shape(p.second), strict))
-            intersecting_shapes.push_back(p);
+    evaluate_candidates(
+            potentially_intersecting_shapes,
+            number_of_threads,
+            executor,
+            [this, strict](
+                const std::pair<ShapePos, ShapePos>& p,
+                std::vector<std::pair<ShapePos, ShapePos>>& intersecting_shapes)
+            {
+                if (shape::intersect(this->shape(p.first), this->shape(p.second), strict))
+                    intersecting_shapes.push_back(p);
+            },
+            intersecting_shapes);
     return intersecting_shapes;
 }
 
-std::vector<ElementElementIntersection> IntersectionTree::compute_intersecting_elements(bool strict) const
+std::vector<ElementElementIntersection> IntersectionTree::compute_intersecting_elements(
+        bool strict,
+        Counter number_of_threads,
+        const Executor& executor) const
 {
     //std::cout << "compute_intersecting_elements..." << std::endl;
-    if (elements_->empty())
+    if (number_of_elements() == 0)
         return {};
 
     if (small_) {
         std::vector<ElementElementIntersection> intersecting_elements;
         for (ElementPos element_1_pos = 0;
-                element_1_pos < (ElementPos)elements_->size();
+                element_1_pos < number_of_elements();
                 ++element_1_pos) {
             for (ElementPos element_2_pos = element_1_pos + 1;
-                    element_2_pos < (ElementPos)elements_->size();
+                    element_2_pos < number_of_elements();
                     ++element_2_pos) {
                 auto intersections = shape::compute_intersections(
                         this->element(element_1_pos),
@@ -690,14 +1380,14 @@ std::vector<ElementElementIntersection> IntersectionTree::compute_intersecting_e
     for (const Node& node: tree_) {
         if (node.direction != 'x')
             continue;
-        for (ElementPos pos_1 = 0;
-                pos_1 < node.element_ids.size();
+        for (ItemPos pos_1 = node.elements_begin();
+                pos_1 < node.points_begin();
                 ++pos_1) {
-            ElementPos element_id_1 = node.element_ids[pos_1];
-            for (ElementPos pos_2 = pos_1 + 1;
-                    pos_2 < node.element_ids.size();
+            ElementPos element_id_1 = item_ids_[pos_1];
+            for (ItemPos pos_2 = pos_1 + 1;
+                    pos_2 < node.points_begin();
                     ++pos_2) {
-                ElementPos element_id_2 = node.element_ids[pos_2];
+                ElementPos element_id_2 = item_ids_[pos_2];
                 potentially_intersecting_elements.push_back({element_id_1, element_id_2});
             }
         }
@@ -711,46 +1401,49 @@ std::vector<ElementElementIntersection> IntersectionTree::compute_intersecting_e
 
     // Compute intersections.
     std::vector<ElementElementIntersection> intersecting_elements;
-    for (auto p: potentially_intersecting_elements) {
-        auto intersections = shape::compute_intersections(
-                this->element(p.first),
-                this->element(p.second));
-        if (strict) {
-            if (!intersections.proper_intersections.empty()) {
-                ElementElementIntersection intersection;
-                intersection.element_id_1 = p.first;
-                intersection.element_id_2 = p.second;
-                intersection.intersections = intersections;
-                intersecting_elements.push_back(intersection);
-            }
-        } else {
-            if (!intersections.overlapping_parts.empty()
-                    || !intersections.improper_intersections.empty()
-                    || !intersections.proper_intersections.empty()) {
+    evaluate_candidates(
+            potentially_intersecting_elements,
+            number_of_threads,
+            executor,
+            [this, strict](
+                const std::pair<ElementPos, ElementPos>& p,
+                std::vector<ElementElementIntersection>& intersecting_elements)
+            {
+                FixedShapeElementIntersectionsOutput intersections;
+                shape::compute_intersections(
+                        this->element(p.first),
+                        this->element(p.second),
+                        intersections);
+                if (strict) {
+                    if (intersections.number_of_proper_intersections == 0)
+                        return;
+                } else {
+                    if (intersections.empty())
+                        return;
+                }
                 ElementElementIntersection intersection;
                 intersection.element_id_1 = p.first;
                 intersection.element_id_2 = p.second;
-                intersection.intersections = intersections;
+                intersection.intersections = intersections.to_output();
                 intersecting_elements.push_back(intersection);
-            }
-        }
-    }
+            },
+            intersecting_elements);
     return intersecting_elements;
 }
 
 std::vector<std::pair<ElementPos, ElementPos>> IntersectionTree::compute_equal_points() const
 {
     //std::cout << "compute_equal_points..." << std::endl;
-    if (points_->empty())
+    if (number_of_points() == 0)
         return {};
 
     if (small_) {
         std::vector<std::pair<ShapePos, ShapePos>> equal_points;
         for (ShapePos point_1_pos = 0;
-                point_1_pos < (ShapePos)points_->size();
+                point_1_pos < number_of_points();
                 ++point_1_pos) {
             for (ShapePos point_2_pos = point_1_pos + 1;
-                    point_2_pos < (ShapePos)points_->size();
+                    point_2_pos < number_of_points();
                     ++point_2_pos) {
                 if (equal(this->point(point_1_pos), this->point(point_2_pos)))
                     equal_points.push_back({point_1_pos, point_2_pos});
@@ -764,15 +1457,14 @@ std::vector<std::pair<ElementPos, ElementPos>> IntersectionTree::compute_equal_p
     for (const Node& node: tree_) {
         if (node.direction != 'x')
             continue;
-        //std::cout << node.point_ids.size() << std::endl;
-        for (ShapePos pos_1 = 0;
-                pos_1 < node.point_ids.size();
+        for (ItemPos pos_1 = node.points_begin();
+                pos_1 < node.points_end();
                 ++pos_1) {
-            ShapePos point_id_1 = node.point_ids[pos_1];
-            for (ShapePos pos_2 = pos_1 + 1;
-                    pos_2 < node.point_ids.size();
+            ShapePos point_id_1 = item_ids_[pos_1];
+            for (ItemPos pos_2 = pos_1 + 1;
+                    pos_2 < node.points_end();
                     ++pos_2) {
-                ShapePos point_id_2 = node.point_ids[pos_2];
+                ShapePos point_id_2 = item_ids_[pos_2];
                 potentially_equal_points.push_back({point_id_1, point_id_2});
             }
         }
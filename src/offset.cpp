@@ -632,6 +632,7 @@ void shape::inflate_export_inputs(
 {
     std::ofstream file{file_path};
     nlohmann::json json;
+    json["operation"] = "inflate_shape_with_holes";
     json["shape"] = shape.to_json();
     json["offset"] = offset;
     file << std::setw(4) << json << std::endl;
@@ -644,6 +645,7 @@ void shape::inflate_export_inputs(
 {
     std::ofstream file{file_path};
     nlohmann::json json;
+    json["operation"] = "inflate_shape";
     json["shape"] = shape.to_json();
     json["offset"] = offset;
     file << std::setw(4) << json << std::endl;
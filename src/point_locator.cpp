@@ -0,0 +1,623 @@
+#include "shape/point_locator.hpp"
+
+#include "shape/elements_intersections.hpp"
+
+#include <algorithm>
+#include <limits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SHAPE_CONTAINS_BATCH_AVX2
+#define SHAPE_TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define SHAPE_CONTAINS_BATCH_AVX2
+#define SHAPE_TARGET_AVX2
+#endif
+
+using namespace shape;
+
+namespace
+{
+
+/** y-monotone piece of an element. */
+struct Piece
+{
+    ElementPos element_pos;
+
+    /** See PointLocator::SlabPiece::side. */
+    int side;
+
+    LengthDbl y_min;
+
+    LengthDbl y_max;
+};
+
+/**
+ * Split an element into y-monotone pieces.
+ *
+ * Horizontal line segments and degenerate circular arcs don't have pieces;
+ * they are always checked exactly.
+ */
+void add_pieces(
+        const ShapeElement& element,
+        ElementPos element_pos,
+        std::vector<Piece>& pieces)
+{
+    if (element.type == ShapeElementType::LineSegment) {
+        if (equal(element.start.y, element.end.y))
+            return;
+        pieces.push_back({
+                element_pos,
+                0,
+                (std::min)(element.start.y, element.end.y),
+                (std::max)(element.start.y, element.end.y)});
+        return;
+    }
+
+    if (element.orientation == ShapeElementOrientation::Full
+            || equal(element.start, element.end)) {
+        return;
+    }
+    LengthDbl radius = element.radius();
+    if (!equal(distance(element.center, element.end), radius))
+        return;
+
+    // Go through the arc anticlockwise.
+    Point start = element.start;
+    Point end = element.end;
+    if (element.orientation == ShapeElementOrientation::Clockwise)
+        std::swap(start, end);
+    Angle angle_start = angle_radian(start - element.center);
+    Angle angle_end = angle_radian(end - element.center);
+    if (angle_end <= angle_start)
+        angle_end += 2 * M_PI;
+
+    // Split it at the top and at the bottom of the circle.
+    Angle angle_prev = angle_start;
+    LengthDbl y_prev = start.y;
+    Angle angle_split = M_PI / 2 + (std::floor((angle_start - M_PI / 2) / M_PI) + 1) * M_PI;
+    for (;;) {
+        bool last = !(angle_split < angle_end);
+        Angle angle_next = (last)? angle_end: angle_split;
+        LengthDbl y_next = (last)?
+            end.y:
+            element.center.y + ((std::sin(angle_split) > 0)? radius: -radius);
+        pieces.push_back({
+                element_pos,
+                (std::cos((angle_prev + angle_next) / 2) > 0)? 1: -1,
+                (std::min)(y_prev, y_next),
+                (std::max)(y_prev, y_next)});
+        if (last)
+            break;
+        angle_prev = angle_split;
+        y_prev = y_next;
+        angle_split += M_PI;
+    }
+}
+
+/** Get the position of a bound in the sorted bounds. */
+ElementPos bound_pos(
+        const std::vector<LengthDbl>& slab_bounds,
+        LengthDbl y)
+{
+    return std::lower_bound(slab_bounds.begin(), slab_bounds.end(), y) - slab_bounds.begin();
+}
+
+}
+
+LengthDbl PointLocator::x(
+        const SlabPiece& piece,
+        LengthDbl y) const
+{
+    const ShapeElement& element = shape_.elements[piece.element_pos];
+    if (piece.side == 0) {
+        return element.start.x
+            + (y - element.start.y)
+            * (element.end.x - element.start.x)
+            / (element.end.y - element.start.y);
+    }
+    LengthDbl radius = element.radius();
+    LengthDbl dy = y - element.center.y;
+    return element.center.x + piece.side * std::sqrt((std::max)(0.0, radius * radius - dy * dy));
+}
+
+PointLocator::PointLocator(const Shape& shape):
+    shape_(shape)
+{
+    std::vector<Piece> pieces;
+    for (ElementPos element_pos = 0;
+            element_pos < (ElementPos)shape_.elements.size();
+            ++element_pos) {
+        const ShapeElement& element = shape_.elements[element_pos];
+        add_pieces(element, element_pos, pieces);
+        AxisAlignedBoundingBox aabb = element.min_max();
+        slab_bounds_.push_back(aabb.y_min - bounding_box_margin);
+        slab_bounds_.push_back(aabb.y_max + bounding_box_margin);
+    }
+    for (const Piece& piece: pieces) {
+        slab_bounds_.push_back(piece.y_min - bounding_box_margin);
+        slab_bounds_.push_back(piece.y_max + bounding_box_margin);
+        if (piece.y_min + bounding_box_margin < piece.y_max - bounding_box_margin) {
+            slab_bounds_.push_back(piece.y_min + bounding_box_margin);
+            slab_bounds_.push_back(piece.y_max - bounding_box_margin);
+        }
+    }
+    std::sort(slab_bounds_.begin(), slab_bounds_.end());
+    slab_bounds_.erase(
+            std::unique(slab_bounds_.begin(), slab_bounds_.end()),
+            slab_bounds_.end());
+    ElementPos number_of_slabs = (std::max)((ElementPos)0, (ElementPos)slab_bounds_.size() - 1);
+
+    // For each slab, the elements to check exactly and the pieces crossing
+    // it.
+    std::vector<std::vector<ElementPos>> slabs_exact_elements(number_of_slabs);
+    std::vector<std::vector<ElementPos>> slabs_pieces(number_of_slabs);
+    std::vector<bool> has_pieces(shape_.elements.size(), false);
+    for (ElementPos piece_pos = 0;
+            piece_pos < (ElementPos)pieces.size();
+            ++piece_pos) {
+        const Piece& piece = pieces[piece_pos];
+        has_pieces[piece.element_pos] = true;
+        ElementPos stable_slab_pos_begin = -1;
+        ElementPos stable_slab_pos_end = -1;
+        if (piece.y_min + bounding_box_margin < piece.y_max - bounding_box_margin) {
+            stable_slab_pos_begin = bound_pos(slab_bounds_, piece.y_min + bounding_box_margin);
+            stable_slab_pos_end = bound_pos(slab_bounds_, piece.y_max - bounding_box_margin);
+        }
+        for (ElementPos slab_pos = bound_pos(slab_bounds_, piece.y_min - bounding_box_margin);
+                slab_pos < bound_pos(slab_bounds_, piece.y_max + bounding_box_margin);
+                ++slab_pos) {
+            if (stable_slab_pos_begin <= slab_pos && slab_pos < stable_slab_pos_end) {
+                slabs_pieces[slab_pos].push_back(piece_pos);
+            } else {
+                slabs_exact_elements[slab_pos].push_back(piece.element_pos);
+            }
+        }
+    }
+    for (ElementPos element_pos = 0;
+            element_pos < (ElementPos)shape_.elements.size();
+            ++element_pos) {
+        if (has_pieces[element_pos])
+            continue;
+        AxisAlignedBoundingBox aabb = shape_.elements[element_pos].min_max();
+        for (ElementPos slab_pos = bound_pos(slab_bounds_, aabb.y_min - bounding_box_margin);
+                slab_pos < bound_pos(slab_bounds_, aabb.y_max + bounding_box_margin);
+                ++slab_pos) {
+            slabs_exact_elements[slab_pos].push_back(element_pos);
+        }
+    }
+
+    exact_elements_offsets_.push_back(0);
+    slab_pieces_offsets_.push_back(0);
+    FixedShapeElementIntersectionsOutput intersections;
+    // Position, in the pieces of the current slab, of the last piece of each
+    // element.
+    std::vector<ElementPos> elements_last_pos(shape_.elements.size(), -1);
+    for (ElementPos slab_pos = 0; slab_pos < number_of_slabs; ++slab_pos) {
+        LengthDbl y_bottom = slab_bounds_[slab_pos];
+        LengthDbl y_top = slab_bounds_[slab_pos + 1];
+        LengthDbl y_middle = (y_bottom + y_top) / 2;
+        std::vector<ElementPos>& exact_elements = slabs_exact_elements[slab_pos];
+        std::sort(exact_elements.begin(), exact_elements.end());
+        exact_elements.erase(
+                std::unique(exact_elements.begin(), exact_elements.end()),
+                exact_elements.end());
+
+        // The pieces of the elements checked exactly are not needed.
+        std::vector<SlabPiece> slab_pieces;
+        for (ElementPos piece_pos: slabs_pieces[slab_pos]) {
+            const Piece& piece = pieces[piece_pos];
+            if (std::binary_search(exact_elements.begin(), exact_elements.end(), piece.element_pos))
+                continue;
+            const ShapeElement& element = shape_.elements[piece.element_pos];
+            SlabPiece slab_piece;
+            slab_piece.element_pos = piece.element_pos;
+            slab_piece.side = piece.side;
+            slab_piece.sibling_pos = -1;
+            // The distance between a point and the element is at least the
+            // horizontal distance times the sine of the angle between the
+            // element and the horizontal line.
+            LengthDbl sine = 0.0;
+            if (piece.side == 0) {
+                sine = std::abs(element.end.y - element.start.y) / element.length();
+            } else {
+                LengthDbl radius = element.radius();
+                LengthDbl dy = (std::max)(
+                        std::abs(y_bottom - element.center.y),
+                        std::abs(y_top - element.center.y));
+                sine = std::sqrt((std::max)(0.0, radius * radius - dy * dy)) / radius;
+            }
+            slab_piece.window = (sine > 0.0)?
+                2 * bounding_box_margin / sine:
+                std::numeric_limits<LengthDbl>::infinity();
+            slab_pieces.push_back(slab_piece);
+        }
+        std::sort(
+                slab_pieces.begin(),
+                slab_pieces.end(),
+                [this, y_middle](
+                    const SlabPiece& piece_1,
+                    const SlabPiece& piece_2)
+                {
+                    return x(piece_1, y_middle) < x(piece_2, y_middle);
+                });
+
+        // Check that the pieces don't cross inside the slab. If two of them
+        // cross, then two adjacent ones cross.
+        bool ordered = true;
+        for (ElementPos pos = 0; pos + 1 < (ElementPos)slab_pieces.size() && ordered; ++pos) {
+            const SlabPiece& piece_1 = slab_pieces[pos];
+            const SlabPiece& piece_2 = slab_pieces[pos + 1];
+            for (LengthDbl y: {y_bottom, y_middle, y_top})
+                if (!(x(piece_1, y) < x(piece_2, y)))
+                    ordered = false;
+            if (piece_1.element_pos == piece_2.element_pos)
+                continue;
+            compute_intersections(
+                    shape_.elements[piece_1.element_pos],
+                    shape_.elements[piece_2.element_pos],
+                    intersections);
+            auto in_slab = [y_bottom, y_top](const Point& point)
+            {
+                return y_bottom - bounding_box_margin <= point.y
+                    && point.y <= y_top + bounding_box_margin;
+            };
+            for (ElementPos pos = 0; pos < intersections.number_of_improper_intersections; ++pos)
+                if (in_slab(intersections.improper_intersections[pos]))
+                    ordered = false;
+            for (ElementPos pos = 0; pos < intersections.number_of_proper_intersections; ++pos)
+                if (in_slab(intersections.proper_intersections[pos]))
+                    ordered = false;
+            for (ElementPos pos = 0; pos < intersections.number_of_overlapping_parts; ++pos) {
+                const ShapeElement& overlapping_part = intersections.overlapping_parts[pos];
+                if (in_slab(overlapping_part.start) || in_slab(overlapping_part.end))
+                    ordered = false;
+            }
+        }
+        if (!ordered) {
+            for (const SlabPiece& piece: slab_pieces)
+                exact_elements.push_back(piece.element_pos);
+            std::sort(exact_elements.begin(), exact_elements.end());
+            exact_elements.erase(
+                    std::unique(exact_elements.begin(), exact_elements.end()),
+                    exact_elements.end());
+            slab_pieces.clear();
+        }
+
+        // An element has at most two pieces crossing a slab.
+        LengthDbl slab_window = 0.0;
+        ElementPos offset = slab_pieces_.size();
+        for (ElementPos pos = 0; pos < (ElementPos)slab_pieces.size(); ++pos) {
+            SlabPiece& piece = slab_pieces[pos];
+            slab_window = (std::max)(slab_window, piece.window);
+            ElementPos& last_pos = elements_last_pos[piece.element_pos];
+            if (last_pos != -1) {
+                piece.sibling_pos = offset + last_pos;
+                slab_pieces[last_pos].sibling_pos = offset + pos;
+            }
+            last_pos = pos;
+        }
+        for (const SlabPiece& piece: slab_pieces)
+            elements_last_pos[piece.element_pos] = -1;
+        exact_elements_.insert(exact_elements_.end(), exact_elements.begin(), exact_elements.end());
+        exact_elements_offsets_.push_back(exact_elements_.size());
+        slab_pieces_.insert(slab_pieces_.end(), slab_pieces.begin(), slab_pieces.end());
+        slab_pieces_offsets_.push_back(slab_pieces_.size());
+        slab_windows_.push_back(slab_window);
+    }
+}
+
+bool PointLocator::contains(
+        const Point& point,
+        bool strict) const
+{
+    // Find the slab of the point. Outside of the slabs, the point is far from
+    // all the elements.
+    auto it = std::upper_bound(slab_bounds_.begin(), slab_bounds_.end(), point.y);
+    if (it == slab_bounds_.begin() || it == slab_bounds_.end())
+        return false;
+    ElementPos slab_pos = (it - slab_bounds_.begin()) - 1;
+
+    ElementPos intersection_count = 0;
+    for (ElementPos pos = exact_elements_offsets_[slab_pos];
+            pos < exact_elements_offsets_[slab_pos + 1];
+            ++pos) {
+        const ShapeElement& element = shape_.elements[exact_elements_[pos]];
+        if (element.contains(point))
+            return (strict)? false: true;
+        intersection_count += element.count_ray_intersections(point);
+    }
+
+    // Pieces which might be close to the point.
+    LengthDbl slab_window = slab_windows_[slab_pos];
+    auto pieces_begin = slab_pieces_.begin() + slab_pieces_offsets_[slab_pos];
+    auto pieces_end = slab_pieces_.begin() + slab_pieces_offsets_[slab_pos + 1];
+    auto pieces_close_begin = std::partition_point(
+            pieces_begin,
+            pieces_end,
+            [this, &point, slab_window](const SlabPiece& piece)
+            {
+                return x(piece, point.y) < point.x - slab_window;
+            });
+    auto pieces_close_end = std::partition_point(
+            pieces_close_begin,
+            pieces_end,
+            [this, &point, slab_window](const SlabPiece& piece)
+            {
+                return x(piece, point.y) <= point.x + slab_window;
+            });
+
+    // Each piece to the right of the close ones crosses the ray once.
+    intersection_count += pieces_end - pieces_close_end;
+
+    auto is_close = [this, &point](const SlabPiece& piece)
+    {
+        return std::abs(x(piece, point.y) - point.x) <= piece.window;
+    };
+    for (auto it_piece = pieces_close_begin; it_piece != pieces_close_end; ++it_piece) {
+        const SlabPiece& piece = *it_piece;
+        if (!is_close(piece)) {
+            if (x(piece, point.y) > point.x)
+                intersection_count++;
+            continue;
+        }
+        const SlabPiece* sibling = (piece.sibling_pos != -1)?
+            &slab_pieces_[piece.sibling_pos]:
+            nullptr;
+        // If both pieces of the element are close, it is checked once.
+        if (sibling != nullptr
+                && sibling < &piece
+                && is_close(*sibling)) {
+            continue;
+        }
+        const ShapeElement& element = shape_.elements[piece.element_pos];
+        if (element.contains(point))
+            return (strict)? false: true;
+        intersection_count += element.count_ray_intersections(point);
+        // The element has been checked exactly, so its other piece must not
+        // be counted a second time.
+        if (sibling != nullptr
+                && !is_close(*sibling)
+                && x(*sibling, point.y) > point.x) {
+            intersection_count--;
+        }
+    }
+
+    return (intersection_count % 2 == 1);
+}
+
+namespace
+{
+
+/**
+ * Edges of a polygon, stored in separate arrays of coordinates.
+ *
+ * The ends of the horizontal edges are set to infinity since the ray casting
+ * of Shape::contains ignores them.
+ */
+struct PolygonEdges
+{
+    /** Bounding boxes of the edges, expanded by bounding_box_margin. */
+    std::vector<LengthDbl> x_min;
+    std::vector<LengthDbl> x_max;
+    std::vector<LengthDbl> y_min;
+    std::vector<LengthDbl> y_max;
+
+    /** Starts and directions of the edges. */
+    std::vector<LengthDbl> x_start;
+    std::vector<LengthDbl> y_start;
+    std::vector<LengthDbl> x_direction;
+    std::vector<LengthDbl> y_direction;
+
+    /**
+     * Largest cross product between the direction of an edge and a vector
+     * from its start to a point close to it.
+     */
+    std::vector<LengthDbl> cross_product_max;
+
+    /** Lowest and highest ends of the non-horizontal edges. */
+    std::vector<LengthDbl> y_low;
+    std::vector<LengthDbl> y_high;
+
+    /** Inverse slopes of the edges. */
+    std::vector<LengthDbl> x_slope;
+};
+
+PolygonEdges build_polygon_edges(const Shape& shape)
+{
+    PolygonEdges edges;
+    for (const ShapeElement& element: shape.elements) {
+        edges.x_min.push_back((std::min)(element.start.x, element.end.x) - bounding_box_margin);
+        edges.x_max.push_back((std::max)(element.start.x, element.end.x) + bounding_box_margin);
+        edges.y_min.push_back((std::min)(element.start.y, element.end.y) - bounding_box_margin);
+        edges.y_max.push_back((std::max)(element.start.y, element.end.y) + bounding_box_margin);
+        edges.x_start.push_back(element.start.x);
+        edges.y_start.push_back(element.start.y);
+        edges.x_direction.push_back(element.end.x - element.start.x);
+        edges.y_direction.push_back(element.end.y - element.start.y);
+        edges.cross_product_max.push_back(bounding_box_margin * distance(element.start, element.end));
+        if (equal(element.start.y, element.end.y)) {
+            edges.y_low.push_back(std::numeric_limits<LengthDbl>::infinity());
+            edges.y_high.push_back(std::numeric_limits<LengthDbl>::infinity());
+            edges.x_slope.push_back(0.0);
+        } else {
+            edges.y_low.push_back((std::min)(element.start.y, element.end.y));
+            edges.y_high.push_back((std::max)(element.start.y, element.end.y));
+            edges.x_slope.push_back(
+                    (element.end.x - element.start.x)
+                    / (element.end.y - element.start.y));
+        }
+    }
+    return edges;
+}
+
+/**
+ * Apply the ray casting to a point.
+ *
+ * Set 'close' if the point is close to an edge or at the height of the end
+ * of a non-horizontal edge; the output of the ray casting is not reliable
+ * then. Otherwise, return true if the number of edges crossed by the ray is
+ * odd.
+ */
+bool contains_scalar(
+        const PolygonEdges& edges,
+        const Point& point,
+        bool& close)
+{
+    bool inside = false;
+    close = false;
+    for (ElementPos edge_pos = 0;
+            edge_pos < (ElementPos)edges.x_start.size();
+            ++edge_pos) {
+        LengthDbl x = point.x - edges.x_start[edge_pos];
+        LengthDbl y = point.y - edges.y_start[edge_pos];
+        if (edges.x_min[edge_pos] <= point.x
+                && point.x <= edges.x_max[edge_pos]
+                && edges.y_min[edge_pos] <= point.y
+                && point.y <= edges.y_max[edge_pos]
+                && std::abs(edges.x_direction[edge_pos] * y - edges.y_direction[edge_pos] * x)
+                <= edges.cross_product_max[edge_pos]) {
+            close = true;
+        }
+        if (std::abs(point.y - edges.y_low[edge_pos]) <= bounding_box_margin
+                || std::abs(point.y - edges.y_high[edge_pos]) <= bounding_box_margin) {
+            close = true;
+        }
+        if (edges.y_low[edge_pos] < point.y
+                && point.y < edges.y_high[edge_pos]
+                && edges.x_start[edge_pos] + y * edges.x_slope[edge_pos] > point.x) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+#ifdef SHAPE_CONTAINS_BATCH_AVX2
+
+bool avx2_supported()
+{
+#if defined(__GNUC__)
+    return __builtin_cpu_supports("avx2");
+#else
+    return true;
+#endif
+}
+
+/**
+ * Same as contains_scalar for the points by groups of four.
+ *
+ * Return the position of the first point which hasn't been processed.
+ */
+SHAPE_TARGET_AVX2 ElementPos contains_avx2(
+        const PolygonEdges& edges,
+        const std::vector<Point>& points,
+        std::vector<uint8_t>& inside,
+        std::vector<uint8_t>& close)
+{
+    const __m256d sign_mask = _mm256_set1_pd(-0.0);
+    const __m256d margins = _mm256_set1_pd(bounding_box_margin);
+    ElementPos point_pos = 0;
+    for (; point_pos + 4 <= (ElementPos)points.size(); point_pos += 4) {
+        __m256d point_x = _mm256_set_pd(
+                points[point_pos + 3].x,
+                points[point_pos + 2].x,
+                points[point_pos + 1].x,
+                points[point_pos].x);
+        __m256d point_y = _mm256_set_pd(
+                points[point_pos + 3].y,
+                points[point_pos + 2].y,
+                points[point_pos + 1].y,
+                points[point_pos].y);
+        __m256d points_inside = _mm256_setzero_pd();
+        __m256d points_close = _mm256_setzero_pd();
+        for (ElementPos edge_pos = 0;
+                edge_pos < (ElementPos)edges.x_start.size();
+                ++edge_pos) {
+            __m256d x = _mm256_sub_pd(point_x, _mm256_set1_pd(edges.x_start[edge_pos]));
+            __m256d y = _mm256_sub_pd(point_y, _mm256_set1_pd(edges.y_start[edge_pos]));
+
+            // Close to the edge.
+            __m256d in_aabb = _mm256_and_pd(
+                    _mm256_and_pd(
+                        _mm256_cmp_pd(_mm256_set1_pd(edges.x_min[edge_pos]), point_x, _CMP_LE_OQ),
+                        _mm256_cmp_pd(point_x, _mm256_set1_pd(edges.x_max[edge_pos]), _CMP_LE_OQ)),
+                    _mm256_and_pd(
+                        _mm256_cmp_pd(_mm256_set1_pd(edges.y_min[edge_pos]), point_y, _CMP_LE_OQ),
+                        _mm256_cmp_pd(point_y, _mm256_set1_pd(edges.y_max[edge_pos]), _CMP_LE_OQ)));
+            __m256d cross_product = _mm256_sub_pd(
+                    _mm256_mul_pd(_mm256_set1_pd(edges.x_direction[edge_pos]), y),
+                    _mm256_mul_pd(_mm256_set1_pd(edges.y_direction[edge_pos]), x));
+            __m256d on_line = _mm256_cmp_pd(
+                    _mm256_andnot_pd(sign_mask, cross_product),
+                    _mm256_set1_pd(edges.cross_product_max[edge_pos]),
+                    _CMP_LE_OQ);
+            points_close = _mm256_or_pd(points_close, _mm256_and_pd(in_aabb, on_line));
+
+            // At the height of an end of the edge.
+            __m256d y_low = _mm256_set1_pd(edges.y_low[edge_pos]);
+            __m256d y_high = _mm256_set1_pd(edges.y_high[edge_pos]);
+            points_close = _mm256_or_pd(points_close, _mm256_or_pd(
+                        _mm256_cmp_pd(_mm256_andnot_pd(sign_mask, _mm256_sub_pd(point_y, y_low)), margins, _CMP_LE_OQ),
+                        _mm256_cmp_pd(_mm256_andnot_pd(sign_mask, _mm256_sub_pd(point_y, y_high)), margins, _CMP_LE_OQ)));
+
+            // Crossed by the ray.
+            __m256d x_intersection = _mm256_add_pd(
+                    _mm256_set1_pd(edges.x_start[edge_pos]),
+                    _mm256_mul_pd(y, _mm256_set1_pd(edges.x_slope[edge_pos])));
+            __m256d crossed = _mm256_and_pd(
+                    _mm256_and_pd(
+                        _mm256_cmp_pd(y_low, point_y, _CMP_LT_OQ),
+                        _mm256_cmp_pd(point_y, y_high, _CMP_LT_OQ)),
+                    _mm256_cmp_pd(x_intersection, point_x, _CMP_GT_OQ));
+            points_inside = _mm256_xor_pd(points_inside, crossed);
+        }
+        int inside_mask = _mm256_movemask_pd(points_inside);
+        int close_mask = _mm256_movemask_pd(points_close);
+        for (int lane = 0; lane < 4; ++lane) {
+            inside[point_pos + lane] = (inside_mask >> lane) & 1;
+            close[point_pos + lane] = (close_mask >> lane) & 1;
+        }
+    }
+    return point_pos;
+}
+
+#endif
+
+}
+
+void shape::contains_batch(
+        const Shape& shape,
+        const std::vector<Point>& points,
+        std::vector<uint8_t>& output,
+        bool strict,
+        bool use_avx2)
+{
+    output.resize(points.size());
+    if (!shape.is_polygon() || shape.elements.empty()) {
+        for (ElementPos point_pos = 0;
+                point_pos < (ElementPos)points.size();
+                ++point_pos) {
+            output[point_pos] = shape.contains(points[point_pos], strict);
+        }
+        return;
+    }
+
+    PolygonEdges edges = build_polygon_edges(shape);
+    std::vector<uint8_t> close(points.size());
+    ElementPos point_pos = 0;
+#ifdef SHAPE_CONTAINS_BATCH_AVX2
+    if (use_avx2 && avx2_supported())
+        point_pos = contains_avx2(edges, points, output, close);
+#endif
+    for (; point_pos < (ElementPos)points.size(); ++point_pos) {
+        bool point_close = false;
+        output[point_pos] = contains_scalar(edges, points[point_pos], point_close);
+        close[point_pos] = point_close;
+    }
+
+    // The points close to the boundary are checked exactly.
+    for (point_pos = 0; point_pos < (ElementPos)points.size(); ++point_pos)
+        if (close[point_pos])
+            output[point_pos] = shape.contains(points[point_pos], strict);
+}
@@ -395,6 +395,7 @@ void shape::rasterization_export_inputs(
 {
     std::ofstream file{file_path};
     nlohmann::json json;
+    json["operation"] = "rasterization";
     json["shape"] = shape.to_json();
     json["cell_width"] = cell_width;
     json["cell_height"] = cell_height;
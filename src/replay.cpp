@@ -0,0 +1,318 @@
+#include "shape/replay.hpp"
+
+#include "shape/boolean_operations.hpp"
+#include "shape/offset.hpp"
+#include "shape/rasterization.hpp"
+#include "shape/simplification.hpp"
+#include "shape/shapes_intersections.hpp"
+#include "shape/approximation.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+using namespace shape;
+
+std::string shape::replay_operation2str(ReplayOperation operation)
+{
+    switch (operation) {
+    case ReplayOperation::ComputeUnion: {
+        return "compute_union";
+    } case ReplayOperation::ComputeIntersection: {
+        return "compute_intersection";
+    } case ReplayOperation::InflateShapeWithHoles: {
+        return "inflate_shape_with_holes";
+    } case ReplayOperation::InflateShape: {
+        return "inflate_shape";
+    } case ReplayOperation::Rasterization: {
+        return "rasterization";
+    } case ReplayOperation::Simplify: {
+        return "simplify";
+    } case ReplayOperation::IntersectShapeShape: {
+        return "intersect_shape_shape";
+    } case ReplayOperation::IntersectShapeWithHolesElement: {
+        return "intersect_shape_with_holes_element";
+    } case ReplayOperation::IntersectShapeWithHolesShape: {
+        return "intersect_shape_with_holes_shape";
+    } case ReplayOperation::IntersectShapeWithHolesShapeWithHoles: {
+        return "intersect_shape_with_holes_shape_with_holes";
+    } case ReplayOperation::ComputeIntersections: {
+        return "compute_intersections";
+    } case ReplayOperation::ComputeStrictIntersections: {
+        return "compute_strict_intersections";
+    } case ReplayOperation::ShapeContains: {
+        return "shape_contains";
+    } case ReplayOperation::ApproximateShapeByLineSegments: {
+        return "approximate_shape_by_line_segments";
+    } case ReplayOperation::ApproximateByLineSegments: {
+        return "approximate_by_line_segments";
+    }
+    }
+    return "";
+}
+
+ReplayOperation shape::str2replay_operation(const std::string& str)
+{
+    for (ReplayOperation operation: {
+            ReplayOperation::ComputeUnion,
+            ReplayOperation::ComputeIntersection,
+            ReplayOperation::InflateShapeWithHoles,
+            ReplayOperation::InflateShape,
+            ReplayOperation::Rasterization,
+            ReplayOperation::Simplify,
+            ReplayOperation::IntersectShapeShape,
+            ReplayOperation::IntersectShapeWithHolesElement,
+            ReplayOperation::IntersectShapeWithHolesShape,
+            ReplayOperation::IntersectShapeWithHolesShapeWithHoles,
+            ReplayOperation::ComputeIntersections,
+            ReplayOperation::ComputeStrictIntersections,
+            ReplayOperation::ShapeContains,
+            ReplayOperation::ApproximateShapeByLineSegments,
+            ReplayOperation::ApproximateByLineSegments}) {
+        if (str == replay_operation2str(operation))
+            return operation;
+    }
+    throw std::invalid_argument(
+            FUNC_SIGNATURE + ": unknown operation; "
+            "str: " + str + ".");
+}
+
+ReplayOperation shape::detect_replay_operation(const nlohmann::json& json)
+{
+    if (json.contains("operation"))
+        return str2replay_operation(json["operation"]);
+
+    if (json.contains("shapes")) {
+        if (json.contains("maximum_approximation_area"))
+            return ReplayOperation::Simplify;
+        return ReplayOperation::ComputeUnion;
+    }
+    if (json.contains("shape_1") && json.contains("shape_2"))
+        return ReplayOperation::IntersectShapeShape;
+    if (json.contains("shape_with_holes_1") && json.contains("shape_with_holes_2"))
+        return ReplayOperation::IntersectShapeWithHolesShapeWithHoles;
+    if (json.contains("shape_with_holes")) {
+        if (json.contains("element"))
+            return ReplayOperation::IntersectShapeWithHolesElement;
+        if (json.contains("shape"))
+            return ReplayOperation::IntersectShapeWithHolesShape;
+        if (json.contains("segment_length"))
+            return ReplayOperation::ApproximateByLineSegments;
+    }
+    if (json.contains("path") && json.contains("shape")) {
+        if (json.contains("only_min_max"))
+            return ReplayOperation::ComputeIntersections;
+        if (json.contains("only_first"))
+            return ReplayOperation::ComputeStrictIntersections;
+    }
+    if (json.contains("shape")) {
+        if (json.contains("offset")) {
+            if (json["shape"].contains("holes"))
+                return ReplayOperation::InflateShapeWithHoles;
+            return ReplayOperation::InflateShape;
+        }
+        if (json.contains("cell_width") && json.contains("cell_height"))
+            return ReplayOperation::Rasterization;
+        if (json.contains("point"))
+            return ReplayOperation::ShapeContains;
+        if (json.contains("segment_length") && json.contains("outer"))
+            return ReplayOperation::ApproximateShapeByLineSegments;
+    }
+
+    throw std::invalid_argument(
+            FUNC_SIGNATURE + ": unable to detect the operation of the inputs.");
+}
+
+namespace
+{
+
+/** Sink preventing the compiler from removing the replayed calls. */
+volatile std::size_t replay_sink = 0;
+
+/**
+ * Parse the inputs of an operation and return a function running it.
+ */
+std::function<void()> build_replay_function(
+        ReplayOperation operation,
+        nlohmann::json& json)
+{
+    switch (operation) {
+    case ReplayOperation::ComputeUnion:
+    case ReplayOperation::ComputeIntersection: {
+        std::vector<ShapeWithHoles> shapes;
+        for (auto& json_shape: json["shapes"])
+            shapes.push_back(ShapeWithHoles::from_json(json_shape));
+        if (operation == ReplayOperation::ComputeUnion) {
+            return [shapes]() {
+                replay_sink += compute_union(shapes).shapes_with_holes.size();
+            };
+        }
+        return [shapes]() {
+            replay_sink += compute_intersection(shapes).shapes_with_holes.size();
+        };
+    } case ReplayOperation::InflateShapeWithHoles: {
+        ShapeWithHoles shape = ShapeWithHoles::from_json(json["shape"]);
+        LengthDbl offset = json["offset"];
+        return [shape, offset]() {
+            replay_sink += inflate(shape, offset).shape.elements.size();
+        };
+    } case ReplayOperation::InflateShape: {
+        Shape shape = Shape::from_json(json["shape"]);
+        LengthDbl offset = json["offset"];
+        return [shape, offset]() {
+            replay_sink += inflate(shape, offset).shape.elements.size();
+        };
+    } case ReplayOperation::Rasterization: {
+        ShapeWithHoles shape = ShapeWithHoles::from_json(json["shape"]);
+        LengthDbl cell_width = json["cell_width"];
+        LengthDbl cell_height = json["cell_height"];
+        return [shape, cell_width, cell_height]() {
+            replay_sink += rasterization(shape, cell_width, cell_height).cells.size();
+        };
+    } case ReplayOperation::Simplify: {
+        std::vector<SimplifyInputShape> shapes;
+        for (auto& json_shape: json["shapes"]) {
+            SimplifyInputShape shape;
+            shape.shape = ShapeWithHoles::from_json(json_shape["shape"]);
+            shape.copies = json_shape["copies"];
+            shapes.push_back(shape);
+        }
+        AreaDbl maximum_approximation_area = json["maximum_approximation_area"];
+        return [shapes, maximum_approximation_area]() {
+            replay_sink += simplify(shapes, maximum_approximation_area).size();
+        };
+    } case ReplayOperation::IntersectShapeShape: {
+        Shape shape_1 = Shape::from_json(json["shape_1"]);
+        Shape shape_2 = Shape::from_json(json["shape_2"]);
+        bool strict = json["strict"];
+        return [shape_1, shape_2, strict]() {
+            replay_sink += intersect(shape_1, shape_2, strict);
+        };
+    } case ReplayOperation::IntersectShapeWithHolesElement: {
+        ShapeWithHoles shape_with_holes = ShapeWithHoles::from_json(json["shape_with_holes"]);
+        ShapeElement element = ShapeElement::from_json(json["element"]);
+        bool strict = json["strict"];
+        return [shape_with_holes, element, strict]() {
+            replay_sink += intersect(shape_with_holes, element, strict);
+        };
+    } case ReplayOperation::IntersectShapeWithHolesShape: {
+        ShapeWithHoles shape_with_holes = ShapeWithHoles::from_json(json["shape_with_holes"]);
+        Shape shape = Shape::from_json(json["shape"]);
+        bool strict = json["strict"];
+        return [shape_with_holes, shape, strict]() {
+            replay_sink += intersect(shape_with_holes, shape, strict);
+        };
+    } case ReplayOperation::IntersectShapeWithHolesShapeWithHoles: {
+        ShapeWithHoles shape_with_holes_1 = ShapeWithHoles::from_json(json["shape_with_holes_1"]);
+        ShapeWithHoles shape_with_holes_2 = ShapeWithHoles::from_json(json["shape_with_holes_2"]);
+        bool strict = json["strict"];
+        return [shape_with_holes_1, shape_with_holes_2, strict]() {
+            replay_sink += intersect(shape_with_holes_1, shape_with_holes_2, strict);
+        };
+    } case ReplayOperation::ComputeIntersections: {
+        Shape path = Shape::from_json(json["path"]);
+        Shape shape = Shape::from_json(json["shape"]);
+        bool only_min_max = json["only_min_max"];
+        return [path, shape, only_min_max]() {
+            replay_sink += compute_intersections(path, shape, only_min_max).size();
+        };
+    } case ReplayOperation::ComputeStrictIntersections: {
+        Shape path = Shape::from_json(json["path"]);
+        Shape shape = Shape::from_json(json["shape"]);
+        bool only_first = json["only_first"];
+        return [path, shape, only_first]() {
+            replay_sink += compute_strict_intersections(path, shape, only_first).size();
+        };
+    } case ReplayOperation::ShapeContains: {
+        Shape shape = Shape::from_json(json["shape"]);
+        Point point = Point::from_json(json["point"]);
+        bool strict = json["strict"];
+        return [shape, point, strict]() {
+            replay_sink += shape.contains(point, strict);
+        };
+    } case ReplayOperation::ApproximateShapeByLineSegments: {
+        Shape shape = Shape::from_json(json["shape"]);
+        LengthDbl segment_length = json["segment_length"];
+        bool outer = json["outer"];
+        return [shape, segment_length, outer]() {
+            replay_sink += approximate_shape_by_line_segments(shape, segment_length, outer).shape.elements.size();
+        };
+    } case ReplayOperation::ApproximateByLineSegments: {
+        ShapeWithHoles shape_with_holes = ShapeWithHoles::from_json(json["shape_with_holes"]);
+        LengthDbl segment_length = json["segment_length"];
+        return [shape_with_holes, segment_length]() {
+            replay_sink += approximate_by_line_segments(shape_with_holes, segment_length).shape.elements.size();
+        };
+    }
+    }
+    throw std::invalid_argument(FUNC_SIGNATURE);
+}
+
+}
+
+ReplayOutput shape::replay(
+        const nlohmann::json& json_orig,
+        const ReplayParameters& parameters)
+{
+    if (parameters.number_of_runs < 1) {
+        throw std::invalid_argument(
+                FUNC_SIGNATURE + ": number_of_runs must be >= 1; "
+                "number_of_runs: " + std::to_string(parameters.number_of_runs) + ".");
+    }
+
+    ReplayOutput output;
+    output.operation = detect_replay_operation(json_orig);
+    nlohmann::json json = json_orig;
+    std::function<void()> function = build_replay_function(output.operation, json);
+
+    for (Counter run = 0; run < parameters.number_of_warmup_runs; ++run)
+        function();
+
+    for (Counter run = 0; run < parameters.number_of_runs; ++run) {
+        Counter number_of_allocations_start = (parameters.number_of_allocations)?
+            parameters.number_of_allocations(): 0;
+        auto start = std::chrono::steady_clock::now();
+        function();
+        auto end = std::chrono::steady_clock::now();
+        if (parameters.number_of_allocations) {
+            Counter number_of_allocations = parameters.number_of_allocations()
+                - number_of_allocations_start;
+            if (output.minimum_number_of_allocations == -1
+                    || output.minimum_number_of_allocations > number_of_allocations) {
+                output.minimum_number_of_allocations = number_of_allocations;
+            }
+            output.maximum_number_of_allocations = (std::max)(
+                    output.maximum_number_of_allocations,
+                    number_of_allocations);
+        }
+        output.times.push_back(std::chrono::duration<double>(end - start).count());
+    }
+
+    std::vector<double> times_sorted = output.times;
+    std::sort(times_sorted.begin(), times_sorted.end());
+    Counter number_of_runs = times_sorted.size();
+    output.minimum_time = times_sorted.front();
+    output.median_time = (number_of_runs % 2 == 1)?
+        times_sorted[number_of_runs / 2]:
+        (times_sorted[number_of_runs / 2 - 1] + times_sorted[number_of_runs / 2]) / 2;
+    // Nearest-rank percentile.
+    Counter p99_pos = (Counter)std::ceil(0.99 * number_of_runs) - 1;
+    output.p99_time = times_sorted[p99_pos];
+    return output;
+}
+
+ReplayOutput shape::replay(
+        const std::string& file_path,
+        const ReplayParameters& parameters)
+{
+    std::ifstream file(file_path);
+    if (!file.good()) {
+        throw std::runtime_error(
+                FUNC_SIGNATURE + ": "
+                "unable to open file \"" + file_path + "\".");
+    }
+
+    nlohmann::json json;
+    file >> json;
+    return replay(json, parameters);
+}
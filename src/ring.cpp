@@ -0,0 +1,214 @@
+#include "shape/ring.hpp"
+
+#include <algorithm>
+
+using namespace shape;
+
+Ring::Ring(const Shape& shape):
+    is_path_(shape.is_path)
+{
+    for (ElementPos element_pos = 0;
+            element_pos < (ElementPos)shape.elements.size();
+            ++element_pos) {
+        const ShapeElement& element = shape.elements[element_pos];
+        if (element_pos + 1 < (ElementPos)shape.elements.size()
+                || !shape.is_path) {
+            const ShapeElement& element_next = shape.elements[
+                (element_pos + 1) % shape.elements.size()];
+            if (!equal(element.end, element_next.start)) {
+                throw std::invalid_argument(
+                        FUNC_SIGNATURE + ": "
+                        "the end of an element must be the start of the next one; "
+                        "element_pos: " + std::to_string(element_pos) + "; "
+                        "element.end: " + element.end.to_string() + "; "
+                        "element_next.start: " + element_next.start.to_string() + ".");
+            }
+        }
+        vertices_.push_back(element.start);
+        if (element.type == ShapeElementType::CircularArc)
+            arcs_.push_back({element_pos, element.center, element.orientation});
+    }
+    if (shape.is_path && !shape.elements.empty())
+        vertices_.push_back(shape.elements.back().end);
+}
+
+ShapeElement Ring::element(
+        ElementPos element_pos,
+        const Arc* arc) const
+{
+    ShapeElement element;
+    element.start = vertices_[element_pos];
+    element.end = vertices_[(element_pos + 1) % vertices_.size()];
+    if (arc == nullptr) {
+        element.type = ShapeElementType::LineSegment;
+    } else {
+        element.type = ShapeElementType::CircularArc;
+        element.center = arc->center;
+        element.orientation = arc->orientation;
+    }
+    return element;
+}
+
+ShapeElement Ring::element(ElementPos element_pos) const
+{
+    if (element_pos < 0 || element_pos >= number_of_elements()) {
+        throw std::invalid_argument(
+                FUNC_SIGNATURE + ": "
+                "element_pos out of range; "
+                "element_pos: " + std::to_string(element_pos) + "; "
+                "number_of_elements(): " + std::to_string(number_of_elements()) + ".");
+    }
+    auto it = std::lower_bound(
+            arcs_.begin(),
+            arcs_.end(),
+            element_pos,
+            [](const Arc& arc, ElementPos element_pos)
+            {
+                return arc.element_pos < element_pos;
+            });
+    return element(
+            element_pos,
+            (it != arcs_.end() && it->element_pos == element_pos)? &(*it): nullptr);
+}
+
+Shape Ring::to_shape() const
+{
+    Shape shape;
+    shape.is_path = is_path_;
+    ElementPos arc_pos = 0;
+    for (ElementPos element_pos = 0;
+            element_pos < number_of_elements();
+            ++element_pos) {
+        const Arc* arc = nullptr;
+        if (arc_pos < (ElementPos)arcs_.size()
+                && arcs_[arc_pos].element_pos == element_pos) {
+            arc = &arcs_[arc_pos];
+            arc_pos++;
+        }
+        shape.elements.push_back(element(element_pos, arc));
+    }
+    return shape;
+}
+
+AreaDbl Ring::compute_area() const
+{
+    if (is_path_) {
+        throw std::invalid_argument(
+                FUNC_SIGNATURE + ": "
+                "cannot compute the area of a path.");
+    }
+
+    AreaDbl area = 0.0;
+    ElementPos arc_pos = 0;
+    ElementPos next_arc_element_pos = (arcs_.empty())? -1: arcs_.front().element_pos;
+    for (ElementPos element_pos = 0;
+            element_pos < number_of_elements();
+            ++element_pos) {
+        const Point& start = vertices_[element_pos];
+        const Point& end = (element_pos + 1 < (ElementPos)vertices_.size())?
+            vertices_[element_pos + 1]:
+            vertices_.front();
+        if (element_pos != next_arc_element_pos) {
+            area += cross_product(start, end);
+            continue;
+        }
+
+        // Handle circular arcs as in Shape::compute_area.
+        const Arc& arc = arcs_[arc_pos];
+        arc_pos++;
+        next_arc_element_pos = (arc_pos < (ElementPos)arcs_.size())?
+            arcs_[arc_pos].element_pos:
+            -1;
+        LengthDbl radius = distance(arc.center, start);
+        if (arc.orientation == ShapeElementOrientation::Full)
+            return radius * radius * M_PI;
+        area += cross_product(start, end);
+        if (arc.orientation == ShapeElementOrientation::Anticlockwise) {
+            Angle theta = angle_radian(arc.center - start, arc.center - end);
+            area += radius * radius * (theta - std::sin(theta));
+        } else {
+            Angle theta = angle_radian(arc.center - end, arc.center - start);
+            area -= radius * radius * (theta - std::sin(theta));
+        }
+    }
+
+    return area / 2;
+}
+
+AxisAlignedBoundingBox Ring::compute_min_max() const
+{
+    AxisAlignedBoundingBox output;
+    for (const Point& vertex: vertices_) {
+        output.x_min = (std::min)(output.x_min, vertex.x);
+        output.x_max = (std::max)(output.x_max, vertex.x);
+        output.y_min = (std::min)(output.y_min, vertex.y);
+        output.y_max = (std::max)(output.y_max, vertex.y);
+    }
+    for (const Arc& arc: arcs_)
+        output = merge(output, element(arc.element_pos, &arc).min_max());
+    return output;
+}
+
+bool Ring::contains(
+        const Point& point,
+        bool strict) const
+{
+    if (vertices_.empty())
+        return false;
+
+    // Same as Shape::contains, the boundary being checked in the same pass
+    // as the ray casting.
+    ElementPos intersection_count = 0;
+    ElementPos arc_pos = 0;
+    for (ElementPos element_pos = 0;
+            element_pos < number_of_elements();
+            ++element_pos) {
+        const Arc* arc = nullptr;
+        if (arc_pos < (ElementPos)arcs_.size()
+                && arcs_[arc_pos].element_pos == element_pos) {
+            arc = &arcs_[arc_pos];
+            arc_pos++;
+        }
+        ShapeElement element = this->element(element_pos, arc);
+        if (element.contains(point))
+            return (strict)? false: true;
+        intersection_count += element.count_ray_intersections(point);
+    }
+    return (intersection_count % 2 == 1);
+}
+
+RingWithHoles::RingWithHoles(const ShapeWithHoles& shape):
+    ring(shape.shape)
+{
+    for (const Shape& hole: shape.holes)
+        holes.push_back(Ring(hole));
+}
+
+ShapeWithHoles RingWithHoles::to_shape_with_holes() const
+{
+    ShapeWithHoles shape;
+    shape.shape = ring.to_shape();
+    for (const Ring& hole: holes)
+        shape.holes.push_back(hole.to_shape());
+    return shape;
+}
+
+AreaDbl RingWithHoles::compute_area() const
+{
+    AreaDbl area = this->ring.compute_area();
+    for (const Ring& hole: this->holes)
+        area -= hole.compute_area();
+    return area;
+}
+
+bool RingWithHoles::contains(
+        const Point& point,
+        bool strict) const
+{
+    if (!this->ring.contains(point, strict))
+        return false;
+    for (const Ring& hole: this->holes)
+        if (hole.contains(point, !strict))
+            return false;
+    return true;
+}
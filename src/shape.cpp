@@ -568,6 +568,31 @@ bool ShapeElement::contains(const Point& point) const
     return equal(point, this->point(l));
 }
 
+Point ShapeElement::closest_point(const Point& point) const
+{
+    switch (type) {
+    case ShapeElementType::LineSegment: {
+        if (this->start == this->end)
+            return this->start;
+        LengthDbl t = project_point_on_line_ratio(this->start, this->end, point);
+        t = (std::max)(0.0, (std::min)(1.0, t));
+        return this->start + t * (this->end - this->start);
+    } case ShapeElementType::CircularArc: {
+        if (equal(point, this->center))
+            return this->start;
+        if (this->orientation == ShapeElementOrientation::Full
+                || this->in_circular_arc_cone(point)) {
+            return this->center + (this->radius() / distance(this->center, point)) * (point - this->center);
+        }
+        return (squared_distance(point, this->start) <= squared_distance(point, this->end))?
+            this->start:
+            this->end;
+    }
+    }
+    throw std::invalid_argument(FUNC_SIGNATURE);
+    return {0, 0};
+}
+
 LengthDbl ShapeElement::length() const
 {
     switch (this->type) {
@@ -1218,6 +1243,130 @@ std::pair<Shape::FurthestPoint, Shape::FurthestPoint> Shape::compute_furthest_po
         {mm.second.point.rotate(angle), mm.second.element_pos}};
 }
 
+ElementPos ShapeElement::count_ray_intersections(const Point& point) const
+{
+    ElementPos intersection_count = 0;
+    if (this->type == ShapeElementType::LineSegment) {
+        // Horizontal edges are excluded.
+        if (equal(this->start.y, this->end.y))
+            return 0;
+
+        // Check y.
+        if (strictly_greater(point.y, this->start.y)
+                && strictly_greater(point.y, this->end.y)) {
+            return 0;
+        }
+        if (strictly_lesser(point.y, this->start.y)
+                && strictly_lesser(point.y, this->end.y)) {
+            return 0;
+        }
+
+        bool upward = (this->end.y > this->start.y);
+
+        if (upward) {
+            // An upward edge includes its starting endpoint, and excludes its
+            // final endpoint;
+            if (equal(point.y, this->start.y)) {
+                if (this->start.x > point.x)
+                    return 1;
+            } else if (equal(point.y, this->end.y)) {
+                return 0;
+            }
+        } else {
+            // A downward edge excludes its starting endpoint, and includes its final endpoint;
+            if (equal(point.y, this->start.y)) {
+                return 0;
+            } else if (equal(point.y, this->end.y)) {
+                if (this->end.x > point.x)
+                    return 1;
+            }
+        }
+
+        LengthDbl x_inters = this->start.x
+            + (point.y - this->start.y)
+            * (this->end.x - this->start.x)
+            / (this->end.y - this->start.y);
+        //std::cout << "x_inters " << x_inters << std::endl;
+        if (x_inters > point.x) {
+            intersection_count++;
+        }
+    } else if (this->type == ShapeElementType::CircularArc) {
+        ShapeElement ray;
+        ray.type = ShapeElementType::LineSegment;
+        ray.start.x = point.x;
+        ray.start.y = point.y;
+        ray.end.x = (std::max)(point.x, this->center.x) + 2 * this->radius();
+        ray.end.y = point.y;
+
+        ShapeElementIntersectionsOutput intersections = compute_intersections(ray, *this);
+        //std::cout << intersections.to_string(0) << std::endl;
+        for (const Point& intersection: intersections.proper_intersections) {
+            if (intersection.x < point.x)
+                continue;
+            intersection_count++;
+        }
+        for (const Point& intersection: intersections.improper_intersections) {
+            if (intersection.x < point.x)
+                continue;
+            //std::cout << "intersection " << intersection.to_string() << std::endl;
+            if (intersection == this->start) {
+                Angle start_angle = angle_radian(this->start - this->center);
+                bool start_upward;
+                if (equal(start_angle, M_PI / 2)) {
+                    // this->start is exactly the circle's own topmost
+                    // point: y has a strict local maximum there, so
+                    // moving away along the arc -- whichever direction,
+                    // regardless of orientation or how far the arc
+                    // continues -- always decreases y. The angle-based
+                    // formula below is undefined here (it only makes
+                    // sense when the tangent has a definite non-zero
+                    // vertical component), so this case is handled
+                    // directly instead of through it.
+                    start_upward = false;
+                } else if (equal(start_angle, 3 * M_PI / 2)) {
+                    // Symmetric case at the circle's bottommost point (a
+                    // strict local minimum): moving away always
+                    // increases y.
+                    start_upward = true;
+                } else {
+                    start_upward = (this->orientation == ShapeElementOrientation::Anticlockwise)?
+                        (strictly_lesser(start_angle, M_PI / 2) || !strictly_lesser(start_angle, 3 * M_PI / 2)):
+                        (strictly_greater(start_angle, M_PI / 2) && !strictly_greater(start_angle, 3 * M_PI / 2));
+                }
+                if (start_upward)
+                    intersection_count++;
+            }
+            if (intersection == this->end) {
+                Angle end_angle = angle_radian(this->end - this->center);
+                bool end_upward;
+                if (equal(end_angle, M_PI / 2)) {
+                    // this->end is exactly the circle's own topmost
+                    // point (a strict local maximum): approaching it
+                    // along the arc, from whichever side, is always
+                    // ascending right up to it.
+                    end_upward = true;
+                } else if (equal(end_angle, 3 * M_PI / 2)) {
+                    // Symmetric case at the bottommost point: always
+                    // descending right up to it.
+                    end_upward = false;
+                } else {
+                    end_upward = (this->orientation == ShapeElementOrientation::Anticlockwise)?
+                        (strictly_lesser(end_angle, M_PI / 2) || !strictly_lesser(end_angle, 3 * M_PI / 2)):
+                        (!strictly_lesser(end_angle, M_PI / 2) && strictly_lesser(end_angle, 3 * M_PI / 2));
+                }
+                if (!end_upward)
+                    intersection_count++;
+            }
+            //if (!(intersection == this->start)
+            //        && !(intersection == this->end)) {
+            //    std::cout << "intersection_count++" << std::endl;
+            //    intersection_count++;
+            //}
+        }
+    }
+    return intersection_count;
+}
+
 bool Shape::contains(
         const Point& point,
         bool strict) const
@@ -1234,131 +1383,8 @@ bool Shape::contains(
 
     // Then use the ray-casting algorithm to check if the point is inside
     ElementPos intersection_count = 0;
-    for (const ShapeElement& element: this->elements) {
-        //std::cout << "element " << element.to_string() << std::endl;
-        if (element.type == ShapeElementType::LineSegment) {
-            // Horizontal edges are excluded.
-            if (equal(element.start.y, element.end.y))
-                continue;
-
-            // Check y.
-            if (strictly_greater(point.y, element.start.y)
-                    && strictly_greater(point.y, element.end.y)) {
-                continue;
-            }
-            if (strictly_lesser(point.y, element.start.y)
-                    && strictly_lesser(point.y, element.end.y)) {
-                continue;
-            }
-
-            bool upward = (element.end.y > element.start.y);
-
-            if (upward) {
-                // An upward edge includes its starting endpoint, and excludes its
-                // final endpoint;
-                if (equal(point.y, element.start.y)) {
-                    if (element.start.x > point.x) {
-                        intersection_count++;
-                        continue;
-                    }
-                } else if (equal(point.y, element.end.y)) {
-                    continue;
-                }
-            } else {
-                // A downward edge excludes its starting endpoint, and includes its final endpoint;
-                if (equal(point.y, element.start.y)) {
-                    continue;
-                } else if (equal(point.y, element.end.y)) {
-                    if (element.end.x > point.x) {
-                        intersection_count++;
-                        continue;
-                    }
-                }
-            }
-
-            LengthDbl x_inters = element.start.x
-                + (point.y - element.start.y)
-                * (element.end.x - element.start.x)
-                / (element.end.y - element.start.y);
-            //std::cout << "x_inters " << x_inters << std::endl;
-            if (x_inters > point.x) {
-                intersection_count++;
-            }
-        } else if (element.type == ShapeElementType::CircularArc) {
-            ShapeElement ray;
-            ray.type = ShapeElementType::LineSegment;
-            ray.start.x = point.x;
-            ray.start.y = point.y;
-            ray.end.x = (std::max)(point.x, element.center.x) + 2 * element.radius();
-            ray.end.y = point.y;
-
-            ShapeElementIntersectionsOutput intersections = compute_intersections(ray, element);
-            //std::cout << intersections.to_string(0) << std::endl;
-            for (const Point& intersection: intersections.proper_intersections) {
-                if (intersection.x < point.x)
-                    continue;
-                intersection_count++;
-            }
-            for (const Point& intersection: intersections.improper_intersections) {
-                if (intersection.x < point.x)
-                    continue;
-                //std::cout << "intersection " << intersection.to_string() << std::endl;
-                if (intersection == element.start) {
-                    Angle start_angle = angle_radian(element.start - element.center);
-                    bool start_upward;
-                    if (equal(start_angle, M_PI / 2)) {
-                        // element.start is exactly the circle's own topmost
-                        // point: y has a strict local maximum there, so
-                        // moving away along the arc -- whichever direction,
-                        // regardless of orientation or how far the arc
-                        // continues -- always decreases y. The angle-based
-                        // formula below is undefined here (it only makes
-                        // sense when the tangent has a definite non-zero
-                        // vertical component), so this case is handled
-                        // directly instead of through it.
-                        start_upward = false;
-                    } else if (equal(start_angle, 3 * M_PI / 2)) {
-                        // Symmetric case at the circle's bottommost point (a
-                        // strict local minimum): moving away always
-                        // increases y.
-                        start_upward = true;
-                    } else {
-                        start_upward = (element.orientation == ShapeElementOrientation::Anticlockwise)?
-                            (strictly_lesser(start_angle, M_PI / 2) || !strictly_lesser(start_angle, 3 * M_PI / 2)):
-                            (strictly_greater(start_angle, M_PI / 2) && !strictly_greater(start_angle, 3 * M_PI / 2));
-                    }
-                    if (start_upward)
-                        intersection_count++;
-                }
-                if (intersection == element.end) {
-                    Angle end_angle = angle_radian(element.end - element.center);
-                    bool end_upward;
-                    if (equal(end_angle, M_PI / 2)) {
-                        // element.end is exactly the circle's own topmost
-                        // point (a strict local maximum): approaching it
-                        // along the arc, from whichever side, is always
-                        // ascending right up to it.
-                        end_upward = true;
-                    } else if (equal(end_angle, 3 * M_PI / 2)) {
-                        // Symmetric case at the bottommost point: always
-                        // descending right up to it.
-                        end_upward = false;
-                    } else {
-                        end_upward = (element.orientation == ShapeElementOrientation::Anticlockwise)?
-                            (strictly_lesser(end_angle, M_PI / 2) || !strictly_lesser(end_angle, 3 * M_PI / 2)):
-                            (!strictly_lesser(end_angle, M_PI / 2) && strictly_lesser(end_angle, 3 * M_PI / 2));
-                    }
-                    if (!end_upward)
-                        intersection_count++;
-                }
-                //if (!(intersection == element.start)
-                //        && !(intersection == element.end)) {
-                //    std::cout << "intersection_count++" << std::endl;
-                //    intersection_count++;
-                //}
-            }
-        }
-    }
+    for (const ShapeElement& element: this->elements)
+        intersection_count += element.count_ray_intersections(point);
 
     // If the number of intersections is odd, the point is inside the shape
     //std::cout << "intersection_count " << intersection_count << std::endl;
@@ -1372,6 +1398,7 @@ void Shape::contains_export_inputs(
 {
     std::ofstream file{file_path};
     nlohmann::json json;
+    json["operation"] = "shape_contains";
     json["shape"] = this->to_json();
     json["point"] = point.to_json();
     json["strict"] = strict;
@@ -2393,6 +2420,67 @@ ShapeWithHoles shape::operator*(
     return shape_new;
 }
 
+CachedShape::CachedShape(const Shape& shape):
+    shape_(shape),
+    aabb_(shape.compute_min_max()),
+    is_polygon_(shape.is_polygon())
+{
+    if (shape_.is_path)
+        return;
+    area_ = shape_.compute_area();
+    is_convex_ = shape_.is_convex();
+    if (!shape_.elements.empty())
+        point_strictly_inside_ = shape_.find_point_strictly_inside();
+}
+
+CachedShape& CachedShape::shift(
+        LengthDbl x,
+        LengthDbl y)
+{
+    shape_.shift(x, y);
+    aabb_.shift(x, y);
+    point_strictly_inside_.shift(x, y);
+    return *this;
+}
+
+CachedShape CachedShape::rotate(Angle angle) const
+{
+    CachedShape cached_shape = *this;
+    cached_shape.shape_ = shape_.rotate(angle);
+    cached_shape.aabb_ = cached_shape.shape_.compute_min_max();
+    cached_shape.point_strictly_inside_ = point_strictly_inside_.rotate(angle);
+    return cached_shape;
+}
+
+CachedShapeWithHoles::CachedShapeWithHoles(const ShapeWithHoles& shape):
+    shape_(shape),
+    aabb_(shape.compute_min_max()),
+    area_(shape.compute_area()),
+    is_polygon_(shape.is_polygon())
+{
+    if (!shape_.shape.elements.empty())
+        point_strictly_inside_ = shape_.find_point_strictly_inside();
+}
+
+CachedShapeWithHoles& CachedShapeWithHoles::shift(
+        LengthDbl x,
+        LengthDbl y)
+{
+    shape_.shift(x, y);
+    aabb_.shift(x, y);
+    point_strictly_inside_.shift(x, y);
+    return *this;
+}
+
+CachedShapeWithHoles CachedShapeWithHoles::rotate(Angle angle) const
+{
+    CachedShapeWithHoles cached_shape = *this;
+    cached_shape.shape_ = shape_.rotate(angle);
+    cached_shape.aabb_ = cached_shape.shape_.compute_min_max();
+    cached_shape.point_strictly_inside_ = point_strictly_inside_.rotate(angle);
+    return cached_shape;
+}
+
 MultiShapeWithHoles& MultiShapeWithHoles::shift(
         LengthDbl x,
         LengthDbl y)
@@ -9,35 +9,213 @@
 #include "shape/writer.hpp"
 #endif
 
+#include "bounding_boxes_sweep.hpp"
+
 #ifdef SHAPES_INTERSECTIONS_DEBUG
 #include <iostream>
 #endif
+
 #include <fstream>
 
 using namespace shape;
 
-bool shape::intersect(
-        const ShapeElement& element_1,
-        const ShapeElement& element_2)
+namespace
 {
-    ShapeElementIntersectionsOutput intersections = compute_intersections(
-            element_1,
-            element_2);
-    if (!intersections.proper_intersections.empty())
-        return true;
-    if (!intersections.improper_intersections.empty())
-        return true;
-    if (!intersections.overlapping_parts.empty())
-        return true;
+
+/**
+ * Number of pairs of elements above which the pairs of elements of two
+ * shapes are filtered with their bounding boxes before being evaluated.
+ */
+const Counter element_pairs_pruning_threshold = 4096;
+
+/**
+ * Return false if two bounding boxes are too far from each other for the
+ * shapes they contain to intersect.
+ */
+bool intersect_min_max(
+        const AxisAlignedBoundingBox& aabb_1,
+        const AxisAlignedBoundingBox& aabb_2)
+{
+    return aabb_1.x_min - bounding_box_margin <= aabb_2.x_max
+        && aabb_2.x_min - bounding_box_margin <= aabb_1.x_max
+        && aabb_1.y_min - bounding_box_margin <= aabb_2.y_max
+        && aabb_2.y_min - bounding_box_margin <= aabb_1.y_max;
+}
+
+/** Empty list of holes, for the shapes without holes. */
+const std::vector<Shape> no_holes;
+
+/**
+ * Call a function on the pairs of elements of two shapes with holes, until
+ * it returns true.
+ *
+ * The pairs are visited by element of the first shape, then by element of
+ * the second shape, the outline before the holes. The function receives the
+ * position of the first element in its outline or hole, and both elements.
+ *
+ * If there are more than element_pairs_pruning_threshold pairs, the pairs
+ * whose bounding boxes don't intersect are skipped. They are found with
+ * find_overlapping_bounding_boxes, the same sweep as the Sweep algorithm
+ * of compute_intersecting_elements.
+ *
+ * Return true if the function returned true.
+ */
+template <typename F>
+bool find_element_pair(
+        const Shape& shape_1,
+        const std::vector<Shape>& holes_1,
+        const Shape& shape_2,
+        const std::vector<Shape>& holes_2,
+        F function)
+{
+    Counter number_of_elements_1 = shape_1.elements.size();
+    for (const Shape& hole: holes_1)
+        number_of_elements_1 += hole.elements.size();
+    Counter number_of_elements_2 = shape_2.elements.size();
+    for (const Shape& hole: holes_2)
+        number_of_elements_2 += hole.elements.size();
+
+    if (number_of_elements_1 * number_of_elements_2 <= element_pairs_pruning_threshold) {
+        for (ShapePos shape_1_pos = -1;
+                shape_1_pos < (ShapePos)holes_1.size();
+                ++shape_1_pos) {
+            const Shape& shape_1_cur = (shape_1_pos == -1)? shape_1: holes_1[shape_1_pos];
+            for (ElementPos element_1_pos = 0;
+                    element_1_pos < (ElementPos)shape_1_cur.elements.size();
+                    ++element_1_pos) {
+                const ShapeElement& element_1 = shape_1_cur.elements[element_1_pos];
+                for (ShapePos shape_2_pos = -1;
+                        shape_2_pos < (ShapePos)holes_2.size();
+                        ++shape_2_pos) {
+                    const Shape& shape_2_cur = (shape_2_pos == -1)? shape_2: holes_2[shape_2_pos];
+                    for (const ShapeElement& element_2: shape_2_cur.elements)
+                        if (function(element_1_pos, element_1, element_2))
+                            return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    struct CandidateElement
+    {
+        const ShapeElement* element;
+
+        /** Position of the element in its outline or hole. */
+        ElementPos element_pos;
+    };
+
+    // Elements of both shapes, in the order in which they are visited.
+    std::vector<CandidateElement> elements;
+    std::vector<int> sides;
+    AxisAlignedBoundingBoxes aabbs;
+    elements.reserve(number_of_elements_1 + number_of_elements_2);
+    sides.reserve(number_of_elements_1 + number_of_elements_2);
+    aabbs.reserve(number_of_elements_1 + number_of_elements_2);
+    for (int side = 0; side < 2; ++side) {
+        const Shape& shape = (side == 0)? shape_1: shape_2;
+        const std::vector<Shape>& holes = (side == 0)? holes_1: holes_2;
+        for (ShapePos shape_pos = -1;
+                shape_pos < (ShapePos)holes.size();
+                ++shape_pos) {
+            const Shape& shape_cur = (shape_pos == -1)? shape: holes[shape_pos];
+            for (ElementPos element_pos = 0;
+                    element_pos < (ElementPos)shape_cur.elements.size();
+                    ++element_pos) {
+                const ShapeElement& element = shape_cur.elements[element_pos];
+                elements.push_back({&element, element_pos});
+                sides.push_back(side);
+                aabbs.push_back(element.min_max());
+            }
+        }
+    }
+
+    // The elements of the first shape come first, so sorting the pairs
+    // gives the order of the loops above.
+    std::vector<std::pair<ElementPos, ElementPos>> candidate_pairs;
+    find_overlapping_bounding_boxes(
+            aabbs,
+            sides,
+            [&candidate_pairs](ElementPos pos_1, ElementPos pos_2)
+            {
+                candidate_pairs.push_back({pos_1, pos_2});
+                return false;
+            });
+
+    std::sort(candidate_pairs.begin(), candidate_pairs.end());
+    for (const std::pair<ElementPos, ElementPos>& candidate_pair: candidate_pairs) {
+        const CandidateElement& element_1 = elements[candidate_pair.first];
+        const CandidateElement& element_2 = elements[candidate_pair.second];
+        if (function(element_1.element_pos, *element_1.element, *element_2.element))
+            return true;
+    }
     return false;
 }
 
+}
+
+std::vector<ElementElementIntersection> shape::compute_intersecting_elements(
+        const std::vector<ShapeElement>& elements,
+        bool strict,
+        const ComputeIntersectingElementsParameters& parameters)
+{
+    if (parameters.algorithm == IntersectingElementsAlgorithm::IntersectionTree) {
+        IntersectionTreeParameters intersection_tree_parameters;
+        intersection_tree_parameters.number_of_threads = parameters.number_of_threads;
+        intersection_tree_parameters.executor = parameters.executor;
+        IntersectionTree intersection_tree({}, elements, {}, intersection_tree_parameters);
+        return intersection_tree.compute_intersecting_elements(
+                strict,
+                parameters.number_of_threads,
+                parameters.executor);
+    }
+
+    std::vector<ElementElementIntersection> intersecting_elements;
+    FixedShapeElementIntersectionsOutput intersections;
+    find_overlapping_bounding_boxes(
+            AxisAlignedBoundingBoxes(elements),
+            {},
+            [&elements, strict, &intersecting_elements, &intersections](
+                ElementPos element_id_1,
+                ElementPos element_id_2)
+            {
+                ElementElementIntersection intersection;
+                intersection.element_id_1 = (std::min)(element_id_1, element_id_2);
+                intersection.element_id_2 = (std::max)(element_id_1, element_id_2);
+                compute_intersections(
+                        elements[intersection.element_id_1],
+                        elements[intersection.element_id_2],
+                        intersections);
+                if (strict) {
+                    if (intersections.number_of_proper_intersections == 0)
+                        return false;
+                } else {
+                    if (intersections.empty())
+                        return false;
+                }
+                intersection.intersections = intersections.to_output();
+                intersecting_elements.push_back(intersection);
+                return false;
+            });
+
+    std::sort(
+            intersecting_elements.begin(),
+            intersecting_elements.end(),
+            [](const ElementElementIntersection& intersection_1, const ElementElementIntersection& intersection_2)
+            {
+                if (intersection_1.element_id_1 != intersection_2.element_id_1)
+                    return intersection_1.element_id_1 < intersection_2.element_id_1;
+                return intersection_1.element_id_2 < intersection_2.element_id_2;
+            });
+    return intersecting_elements;
+}
+
 bool shape::intersect(
-        const Shape& shape)
+        const Shape& shape,
+        const ComputeIntersectingElementsParameters& parameters)
 {
-    IntersectionTree intersection_tree({}, {shape.elements}, {});
     std::vector<ElementElementIntersection> intersecting_elements
-        = intersection_tree.compute_intersecting_elements(false);
+        = compute_intersecting_elements(shape.elements, false, parameters);
     if (shape.is_path) {
         for (const ElementElementIntersection& intersection: intersecting_elements) {
 #ifdef SHAPES_INTERSECTIONS_DEBUG
@@ -93,12 +271,12 @@ bool shape::intersect(
 }
 
 std::vector<ElementElementIntersection> shape::compute_intersecting_elements(
-        const Shape& shape)
+        const Shape& shape,
+        const ComputeIntersectingElementsParameters& parameters)
 {
     std::vector<ElementElementIntersection> output;
-    IntersectionTree intersection_tree({}, {shape.elements}, {});
     std::vector<ElementElementIntersection> intersecting_elements
-        = intersection_tree.compute_intersecting_elements(false);
+        = compute_intersecting_elements(shape.elements, false, parameters);
     if (shape.is_path) {
         for (const ElementElementIntersection& intersection: intersecting_elements) {
             if (!intersection.intersections.proper_intersections.empty()) {
@@ -185,24 +363,26 @@ bool shape::intersect(
     std::vector<Point> intersection_points;
     std::vector<ShapeElement> overlapping_parts;
     std::vector<std::pair<int, ElementPos>> intersections;
+    FixedShapeElementIntersectionsOutput intersections_cur;
     for (ElementPos shape_element_pos = 0;
             shape_element_pos < (ElementPos)shape.elements.size();
             ++shape_element_pos) {
         const ShapeElement& shape_element = shape.elements[shape_element_pos];
-        ShapeElementIntersectionsOutput intersections_cur = compute_intersections(
+        compute_intersections(
                 element,
-                shape_element);
-        for (const ShapeElement& overlapping_part: intersections_cur.overlapping_parts) {
+                shape_element,
+                intersections_cur);
+        for (ElementPos pos = 0; pos < intersections_cur.number_of_overlapping_parts; ++pos) {
             intersections.push_back({0, (ElementPos)overlapping_parts.size()});
-            overlapping_parts.push_back(overlapping_part);
+            overlapping_parts.push_back(intersections_cur.overlapping_parts[pos]);
         }
-        for (const Point& intersection: intersections_cur.improper_intersections) {
+        for (ElementPos pos = 0; pos < intersections_cur.number_of_improper_intersections; ++pos) {
             intersections.push_back({1, (ElementPos)intersection_points.size()});
-            intersection_points.push_back(intersection);
+            intersection_points.push_back(intersections_cur.improper_intersections[pos]);
         }
-        for (const Point& intersection: intersections_cur.proper_intersections) {
+        for (ElementPos pos = 0; pos < intersections_cur.number_of_proper_intersections; ++pos) {
             intersections.push_back({1, (ElementPos)intersection_points.size()});
-            intersection_points.push_back(intersection);
+            intersection_points.push_back(intersections_cur.proper_intersections[pos]);
         }
     }
     intersections.push_back({1, (ElementPos)intersection_points.size()});
@@ -418,10 +598,19 @@ std::vector<ShapePoint> shape::compute_strict_intersections(
     return output;
 }
 
-bool shape::intersect(
+namespace
+{
+
+/**
+ * Same as intersect(shape_1, shape_2, strict), with the points strictly
+ * inside the shapes if they are already known.
+ */
+bool intersect_shapes(
         const Shape& shape_1,
         const Shape& shape_2,
-        bool strict)
+        bool strict,
+        const Point* point_strictly_inside_1,
+        const Point* point_strictly_inside_2)
 {
     if (shape_1.is_path && shape_2.is_path && strict) {
         throw std::invalid_argument(
@@ -430,10 +619,20 @@ bool shape::intersect(
     }
 
     if (!strict) {
-        for (const ShapeElement& element_1: shape_1.elements)
-            for (const ShapeElement& element_2: shape_2.elements)
-                if (shape::intersect(element_1, element_2))
-                    return true;
+        if (find_element_pair(
+                    shape_1,
+                    no_holes,
+                    shape_2,
+                    no_holes,
+                    [](
+                        ElementPos,
+                        const ShapeElement& element_1,
+                        const ShapeElement& element_2)
+                    {
+                        return shape::intersect(element_1, element_2);
+                    })) {
+            return true;
+        }
         if (!shape_1.is_path && shape_1.contains(shape_2.elements.front().start))
             return true;
         if (!shape_2.is_path && shape_2.contains(shape_1.elements.front().start))
@@ -441,37 +640,47 @@ bool shape::intersect(
         return false;
     }
 
-    if (shape_2.is_path)
-        return intersect(shape_2, shape_1, strict);
+    if (shape_2.is_path) {
+        return intersect_shapes(
+                shape_2,
+                shape_1,
+                strict,
+                point_strictly_inside_2,
+                point_strictly_inside_1);
+    }
 
     std::vector<ShapePoint> intersection_points;
     std::vector<std::pair<ElementPos, ShapeElement>> overlapping_parts;
     std::vector<std::pair<int, ElementPos>> intersections;
-    for (ElementPos element_1_pos = 0;
-            element_1_pos < (ElementPos)shape_1.elements.size();
-            ++element_1_pos) {
-        const ShapeElement& element_1 = shape_1.elements[element_1_pos];
-        for (ElementPos element_2_pos = 0;
-                element_2_pos < (ElementPos)shape_2.elements.size();
-                ++element_2_pos) {
-            const ShapeElement& element_2 = shape_2.elements[element_2_pos];
-            ShapeElementIntersectionsOutput intersections_cur = compute_intersections(
-                    element_1,
-                    element_2);
-            for (const ShapeElement& overlapping_part: intersections_cur.overlapping_parts) {
-                intersections.push_back({0, (ElementPos)overlapping_parts.size()});
-                overlapping_parts.push_back({element_1_pos, overlapping_part});
-            }
-            for (const Point& intersection: intersections_cur.improper_intersections) {
-                intersections.push_back({1, (ElementPos)intersection_points.size()});
-                intersection_points.push_back({element_1_pos, intersection});
-            }
-            for (const Point& intersection: intersections_cur.proper_intersections) {
-                intersections.push_back({1, (ElementPos)intersection_points.size()});
-                intersection_points.push_back({element_1_pos, intersection});
-            }
-        }
-    }
+    FixedShapeElementIntersectionsOutput intersections_cur;
+    find_element_pair(
+            shape_1,
+            no_holes,
+            shape_2,
+            no_holes,
+            [&intersection_points, &overlapping_parts, &intersections, &intersections_cur](
+                ElementPos element_1_pos,
+                const ShapeElement& element_1,
+                const ShapeElement& element_2)
+            {
+                compute_intersections(
+                        element_1,
+                        element_2,
+                        intersections_cur);
+                for (ElementPos pos = 0; pos < intersections_cur.number_of_overlapping_parts; ++pos) {
+                    intersections.push_back({0, (ElementPos)overlapping_parts.size()});
+                    overlapping_parts.push_back({element_1_pos, intersections_cur.overlapping_parts[pos]});
+                }
+                for (ElementPos pos = 0; pos < intersections_cur.number_of_improper_intersections; ++pos) {
+                    intersections.push_back({1, (ElementPos)intersection_points.size()});
+                    intersection_points.push_back({element_1_pos, intersections_cur.improper_intersections[pos]});
+                }
+                for (ElementPos pos = 0; pos < intersections_cur.number_of_proper_intersections; ++pos) {
+                    intersections.push_back({1, (ElementPos)intersection_points.size()});
+                    intersection_points.push_back({element_1_pos, intersections_cur.proper_intersections[pos]});
+                }
+                return false;
+            });
     if (shape_1.is_path) {
         intersections.push_back({1, (ElementPos)intersection_points.size()});
         intersection_points.push_back({(ElementPos)shape_1.elements.size() - 1, shape_1.elements.back().end});
@@ -524,15 +733,46 @@ bool shape::intersect(
     }
 
     if (!shape_1.is_path) {
-        if (shape_2.contains(shape_1.find_point_strictly_inside()))
+        if (shape_2.contains((point_strictly_inside_1 != nullptr)?
+                    *point_strictly_inside_1:
+                    shape_1.find_point_strictly_inside())) {
             return true;
-        if (shape_1.contains(shape_2.find_point_strictly_inside()))
+        }
+        if (shape_1.contains((point_strictly_inside_2 != nullptr)?
+                    *point_strictly_inside_2:
+                    shape_2.find_point_strictly_inside())) {
             return true;
+        }
     }
 
     return false;
 }
 
+}
+
+bool shape::intersect(
+        const Shape& shape_1,
+        const Shape& shape_2,
+        bool strict)
+{
+    return intersect_shapes(shape_1, shape_2, strict, nullptr, nullptr);
+}
+
+bool shape::intersect(
+        const CachedShape& shape_1,
+        const CachedShape& shape_2,
+        bool strict)
+{
+    if (!intersect_min_max(shape_1.min_max(), shape_2.min_max()))
+        return false;
+    return intersect_shapes(
+            shape_1.shape(),
+            shape_2.shape(),
+            strict,
+            (shape_1.shape().is_path)? nullptr: &shape_1.point_strictly_inside(),
+            (shape_2.shape().is_path)? nullptr: &shape_2.point_strictly_inside());
+}
+
 struct PathShapeOverlappingPart
 {
     ElementPos path_element_pos;
@@ -874,21 +1114,35 @@ bool shape::intersect(
     return false;
 }
 
-bool shape::intersect(
+namespace
+{
+
+/**
+ * Same as intersect(shape_with_holes, shape, strict), with the points
+ * strictly inside the shapes if they are already known.
+ */
+bool intersect_shape_with_holes_shape(
         const ShapeWithHoles& shape_with_holes,
         const Shape& shape,
-        bool strict)
+        bool strict,
+        const Point* shape_with_holes_point_strictly_inside,
+        const Point* shape_point_strictly_inside)
 {
     if (!strict) {
-        for (const ShapeElement& element_1: shape_with_holes.shape.elements)
-            for (const ShapeElement& element_2: shape.elements)
-                if (shape::intersect(element_1, element_2))
-                    return true;
-        for (const Shape& hole: shape_with_holes.holes)
-            for (const ShapeElement& element_1: hole.elements)
-                for (const ShapeElement& element_2: shape.elements)
-                    if (shape::intersect(element_1, element_2))
-                        return true;
+        if (find_element_pair(
+                    shape_with_holes.shape,
+                    shape_with_holes.holes,
+                    shape,
+                    no_holes,
+                    [](
+                        ElementPos,
+                        const ShapeElement& element_1,
+                        const ShapeElement& element_2)
+                    {
+                        return shape::intersect(element_1, element_2);
+                    })) {
+            return true;
+        }
         if (shape_with_holes.contains(shape.elements.front().start))
             return true;
         if (!shape.is_path && shape.contains(shape_with_holes.shape.elements.front().start))
@@ -899,18 +1153,16 @@ bool shape::intersect(
     std::vector<ShapePoint> intersection_points;
     std::vector<std::pair<ElementPos, ShapeElement>> overlapping_parts;
     std::vector<std::pair<int, ElementPos>> intersections;
-    for (ElementPos element_1_pos = 0;
-            element_1_pos < (ElementPos)shape.elements.size();
-            ++element_1_pos) {
-        const ShapeElement& element_1 = shape.elements[element_1_pos];
-        for (ShapePos shape_pos = -1;
-                shape_pos < (ShapePos)shape_with_holes.holes.size();
-                ++shape_pos) {
-            const Shape& shape_2 = (shape_pos == -1)? shape_with_holes.shape: shape_with_holes.holes[shape_pos];
-            for (ElementPos element_2_pos = 0;
-                    element_2_pos < (ElementPos)shape_2.elements.size();
-                    ++element_2_pos) {
-                const ShapeElement& element_2 = shape_2.elements[element_2_pos];
+    find_element_pair(
+            shape,
+            no_holes,
+            shape_with_holes.shape,
+            shape_with_holes.holes,
+            [&intersection_points, &overlapping_parts, &intersections](
+                ElementPos element_1_pos,
+                const ShapeElement& element_1,
+                const ShapeElement& element_2)
+            {
                 ShapeElementIntersectionsOutput intersections_cur = compute_intersections(
                         element_1,
                         element_2);
@@ -935,9 +1187,8 @@ bool shape::intersect(
                     intersections.push_back({1, (ElementPos)intersection_points.size()});
                     intersection_points.push_back({element_1_pos, intersection});
                 }
-            }
-        }
-    }
+                return false;
+            });
     if (shape.is_path) {
         intersections.push_back({1, (ElementPos)intersection_points.size()});
         intersection_points.push_back({(ElementPos)shape.elements.size() - 1, shape.elements.back().end});
@@ -1015,40 +1266,70 @@ bool shape::intersect(
     }
 
     if (!shape.is_path) {
-        if (shape_with_holes.contains(shape.find_point_strictly_inside()))
+        if (shape_with_holes.contains((shape_point_strictly_inside != nullptr)?
+                    *shape_point_strictly_inside:
+                    shape.find_point_strictly_inside())) {
             return true;
-        if (shape.contains(shape_with_holes.find_point_strictly_inside()))
+        }
+        if (shape.contains((shape_with_holes_point_strictly_inside != nullptr)?
+                    *shape_with_holes_point_strictly_inside:
+                    shape_with_holes.find_point_strictly_inside())) {
             return true;
+        }
     }
 
     return false;
 }
 
+}
+
+bool shape::intersect(
+        const ShapeWithHoles& shape_with_holes,
+        const Shape& shape,
+        bool strict)
+{
+    return intersect_shape_with_holes_shape(
+            shape_with_holes,
+            shape,
+            strict,
+            nullptr,
+            nullptr);
+}
+
+bool shape::intersect(
+        const CachedShapeWithHoles& shape_with_holes,
+        const CachedShape& shape,
+        bool strict)
+{
+    if (!intersect_min_max(shape_with_holes.min_max(), shape.min_max()))
+        return false;
+    return intersect_shape_with_holes_shape(
+            shape_with_holes.shape(),
+            shape.shape(),
+            strict,
+            &shape_with_holes.point_strictly_inside(),
+            (shape.shape().is_path)? nullptr: &shape.point_strictly_inside());
+}
+
 bool shape::intersect(
         const ShapeWithHoles& shape_with_holes_1,
         const ShapeWithHoles& shape_with_holes_2,
         bool strict)
 {
     if (!strict) {
-        for (const ShapeElement& element_1: shape_with_holes_1.shape.elements) {
-            for (const ShapeElement& element_2: shape_with_holes_2.shape.elements)
-                if (shape::intersect(element_1, element_2))
-                    return true;
-            for (const Shape& hole_2: shape_with_holes_2.holes)
-                for (const ShapeElement& element_2: hole_2.elements)
-                    if (shape::intersect(element_1, element_2))
-                        return true;
-        }
-        for (const Shape& hole_1: shape_with_holes_1.holes) {
-            for (const ShapeElement& element_1: hole_1.elements) {
-                for (const ShapeElement& element_2: shape_with_holes_2.shape.elements)
-                    if (shape::intersect(element_1, element_2))
-                        return true;
-                for (const Shape& hole_2: shape_with_holes_2.holes)
-                    for (const ShapeElement& element_2: hole_2.elements)
-                        if (shape::intersect(element_1, element_2))
-                            return true;
-            }
+        if (find_element_pair(
+                    shape_with_holes_1.shape,
+                    shape_with_holes_1.holes,
+                    shape_with_holes_2.shape,
+                    shape_with_holes_2.holes,
+                    [](
+                        ElementPos,
+                        const ShapeElement& element_1,
+                        const ShapeElement& element_2)
+                    {
+                        return shape::intersect(element_1, element_2);
+                    })) {
+            return true;
         }
         if (shape_with_holes_1.contains(shape_with_holes_2.shape.elements.front().start))
             return true;
@@ -1060,6 +1341,16 @@ bool shape::intersect(
     return !compute_intersection({shape_with_holes_1, shape_with_holes_2}).shapes_with_holes.empty();
 }
 
+bool shape::intersect(
+        const CachedShapeWithHoles& shape_with_holes_1,
+        const CachedShapeWithHoles& shape_with_holes_2,
+        bool strict)
+{
+    if (!intersect_min_max(shape_with_holes_1.min_max(), shape_with_holes_2.min_max()))
+        return false;
+    return intersect(shape_with_holes_1.shape(), shape_with_holes_2.shape(), strict);
+}
+
 void shape::intersect_export_inputs(
         const std::string& file_path,
         const Shape& shape_1,
@@ -1068,6 +1359,7 @@ void shape::intersect_export_inputs(
 {
     std::ofstream file{file_path};
     nlohmann::json json;
+    json["operation"] = "intersect_shape_shape";
     json["shape_1"] = shape_1.to_json();
     json["shape_2"] = shape_2.to_json();
     json["strict"] = strict;
@@ -1082,6 +1374,7 @@ void shape::compute_intersections_export_inputs(
 {
     std::ofstream file{file_path};
     nlohmann::json json;
+    json["operation"] = "compute_intersections";
     json["path"] = path.to_json();
     json["shape"] = shape.to_json();
     json["only_min_max"] = only_min_max;
@@ -1096,6 +1389,7 @@ void shape::compute_strict_intersections_export_inputs(
 {
     std::ofstream file{file_path};
     nlohmann::json json;
+    json["operation"] = "compute_strict_intersections";
     json["path"] = path.to_json();
     json["shape"] = shape.to_json();
     json["only_first"] = only_first;
@@ -1110,6 +1404,7 @@ void shape::intersect_export_inputs(
 {
     std::ofstream file{file_path};
     nlohmann::json json;
+    json["operation"] = "intersect_shape_with_holes_element";
     json["shape_with_holes"] = shape_with_holes.to_json();
     json["element"] = element.to_json();
     json["strict"] = strict;
@@ -1124,6 +1419,7 @@ void shape::intersect_export_inputs(
 {
     std::ofstream file{file_path};
     nlohmann::json json;
+    json["operation"] = "intersect_shape_with_holes_shape";
     json["shape_with_holes"] = shape_with_holes_1.to_json();
     json["shape"] = shape_2.to_json();
     json["strict"] = strict;
@@ -1138,6 +1434,7 @@ void shape::intersect_export_inputs(
 {
     std::ofstream file{file_path};
     nlohmann::json json;
+    json["operation"] = "intersect_shape_with_holes_shape_with_holes";
     json["shape_with_holes_1"] = shape_with_holes_1.to_json();
     json["shape_with_holes_2"] = shape_with_holes_2.to_json();
     json["strict"] = strict;
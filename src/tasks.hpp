@@ -0,0 +1,59 @@
+#pragma once
+
+#include "shape/shapes_intersections.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace shape
+{
+
+/**
+ * Run the tasks 0, ..., number_of_tasks - 1 either with an executor, with a
+ * pool of threads, or sequentially.
+ *
+ * The tasks must not call run_tasks with the same executor themselves, since
+ * the executor might be waiting for them.
+ */
+template <typename Task>
+void run_tasks(
+        Counter number_of_tasks,
+        const Task& task,
+        Counter number_of_threads,
+        const Executor& executor)
+{
+    if (executor) {
+        std::vector<std::function<void()>> tasks;
+        for (Counter task_id = 0; task_id < number_of_tasks; ++task_id)
+            tasks.push_back([&task, task_id]() { task(task_id); });
+        executor(tasks);
+        return;
+    }
+
+    number_of_threads = (std::min)(number_of_threads, number_of_tasks);
+    if (number_of_threads <= 1) {
+        for (Counter task_id = 0; task_id < number_of_tasks; ++task_id)
+            task(task_id);
+        return;
+    }
+
+    std::atomic<Counter> next_task_id(0);
+    auto worker = [&task, &next_task_id, number_of_tasks]()
+    {
+        for (;;) {
+            Counter task_id = next_task_id.fetch_add(1);
+            if (task_id >= number_of_tasks)
+                break;
+            task(task_id);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (Counter thread_id = 1; thread_id < number_of_threads; ++thread_id)
+        threads.push_back(std::thread(worker));
+    worker();
+    for (std::thread& thread: threads)
+        thread.join();
+}
+
+}
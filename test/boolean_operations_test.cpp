@@ -8,6 +8,7 @@
 
 #include <boost/filesystem.hpp>
 #include <fstream>
+#include <random>
 
 namespace fs = boost::filesystem;
 
@@ -224,6 +225,96 @@ TEST_P(ComputeBooleanUnionTest, ComputeBooleanUnion)
     }
 }
 
+TEST_P(ComputeBooleanUnionTest, ComputeBooleanUnionParallel)
+{
+    ComputeBooleanUnionTestParams test_params = GetParam();
+
+    auto expected_output = compute_union(
+            test_params.shapes).shapes_with_holes;
+    BooleanOperationParameters parameters;
+    parameters.number_of_threads = 4;
+    auto output = compute_union(
+            test_params.shapes,
+            parameters).shapes_with_holes;
+
+    // The output must not depend on the number of threads, including its
+    // order.
+    ASSERT_EQ(output.size(), expected_output.size());
+    for (ShapePos shape_pos = 0;
+            shape_pos < (ShapePos)output.size();
+            ++shape_pos) {
+        EXPECT_TRUE(equal(output[shape_pos], expected_output[shape_pos]));
+    }
+}
+
+TEST_P(ComputeBooleanUnionTest, ComputeBooleanUnionSweep)
+{
+    ComputeBooleanUnionTestParams test_params = GetParam();
+
+    auto expected_output = compute_union(
+            test_params.shapes).shapes_with_holes;
+    BooleanOperationParameters parameters;
+    parameters.intersecting_elements_algorithm = IntersectingElementsAlgorithm::Sweep;
+    auto output = compute_union(
+            test_params.shapes,
+            parameters).shapes_with_holes;
+
+    // Both algorithms find the same intersections.
+    ASSERT_EQ(output.size(), expected_output.size());
+    for (ShapePos shape_pos = 0;
+            shape_pos < (ShapePos)output.size();
+            ++shape_pos) {
+        EXPECT_TRUE(equal(output[shape_pos], expected_output[shape_pos]));
+    }
+}
+
+TEST_P(ComputeBooleanUnionTest, ComputeBooleanUnionCascaded)
+{
+    ComputeBooleanUnionTestParams test_params = GetParam();
+
+    BooleanOperationParameters parameters;
+    parameters.cascaded_union_group_size = 64;
+    auto output = compute_union(
+            test_params.shapes,
+            parameters).shapes_with_holes;
+    std::cout << "output" << std::endl;
+    for (const ShapeWithHoles& shape: output)
+        std::cout << "- " << shape.to_string(2) << std::endl;
+
+    ASSERT_EQ(output.size(), test_params.expected_output.size());
+    for (const ShapeWithHoles& expected_shape: test_params.expected_output) {
+        EXPECT_NE(std::find_if(
+                      output.begin(),
+                      output.end(),
+                      [&expected_shape](const ShapeWithHoles& shape) { return equal(shape, expected_shape); }),
+                  output.end());
+    }
+}
+
+TEST_P(ComputeBooleanUnionTest, UnionAccumulator)
+{
+    ComputeBooleanUnionTestParams test_params = GetParam();
+
+    UnionAccumulator union_accumulator;
+    for (const ShapeWithHoles& shape: test_params.shapes)
+        union_accumulator.add(shape);
+    auto output = union_accumulator.result().shapes_with_holes;
+    std::cout << "output" << std::endl;
+    for (const ShapeWithHoles& shape: output)
+        std::cout << "- " << shape.to_string(2) << std::endl;
+
+    // The shapes are split again at each addition, so the intersection
+    // vertices might be slightly moved; only the covered region is compared.
+    ASSERT_EQ(output.size(), test_params.expected_output.size());
+    AreaDbl area = 0.0;
+    for (const ShapeWithHoles& shape: output)
+        area += shape.compute_area();
+    AreaDbl expected_area = 0.0;
+    for (const ShapeWithHoles& shape: test_params.expected_output)
+        expected_area += shape.compute_area();
+    EXPECT_NEAR(area, expected_area, 1e-6 * (std::max)(1.0, expected_area));
+}
+
 INSTANTIATE_TEST_SUITE_P(
         Shape,
         ComputeBooleanUnionTest,
@@ -289,6 +380,53 @@ INSTANTIATE_TEST_SUITE_P(
             return fs::path(info.param.name).stem().string();
         });
 
+TEST(UnionAccumulatorTest, Row)
+{
+    // Each square only touches the end of the row, so the number of split
+    // elements must not grow with the length of the row.
+    ElementPos number_of_squares = 1000;
+    UnionAccumulator union_accumulator;
+    ElementPos number_of_splitted_elements_max = 0;
+    for (ElementPos pos = 0; pos < number_of_squares; ++pos) {
+        union_accumulator.add({build_rectangle(pos, pos + 1.5, 0, 1)});
+        number_of_splitted_elements_max = (std::max)(
+                number_of_splitted_elements_max,
+                union_accumulator.number_of_splitted_elements());
+    }
+    EXPECT_LE(number_of_splitted_elements_max, 4);
+
+    auto output = union_accumulator.result().shapes_with_holes;
+    ASSERT_EQ(output.size(), 1);
+    EXPECT_TRUE(output.front().holes.empty());
+    EXPECT_NEAR(output.front().compute_area(), number_of_squares + 0.5, 1e-6);
+}
+
+TEST(UnionAccumulatorTest, Ring)
+{
+    // The last square closes the ring, which creates a hole.
+    std::vector<Point> positions;
+    for (LengthDbl x = 0; x < 9; ++x)
+        positions.push_back({x, 0});
+    for (LengthDbl y = 0; y < 9; ++y)
+        positions.push_back({9, y});
+    for (LengthDbl x = 9; x > 0; --x)
+        positions.push_back({x, 9});
+    for (LengthDbl y = 9; y > 0; --y)
+        positions.push_back({0, y});
+    UnionAccumulator union_accumulator;
+    for (const Point& position: positions) {
+        union_accumulator.add({build_rectangle(
+                    position.x, position.x + 1.5,
+                    position.y, position.y + 1.5)});
+    }
+
+    auto output = union_accumulator.result().shapes_with_holes;
+    ASSERT_EQ(output.size(), 1);
+    ASSERT_EQ(output.front().holes.size(), 1);
+    EXPECT_NEAR(output.front().shape.compute_area(), 10.5 * 10.5, 1e-6);
+    EXPECT_NEAR(output.front().holes.front().compute_area(), 7.5 * 7.5, 1e-6);
+}
+
 
 struct ComputeBooleanIntersectionTestParams
 {
@@ -362,6 +500,27 @@ TEST_P(ComputeBooleanIntersectionTest, ComputeBooleanIntersection)
     }
 }
 
+TEST_P(ComputeBooleanIntersectionTest, ComputeIntersectionArea)
+{
+    ComputeBooleanIntersectionTestParams test_params = GetParam();
+    if (test_params.shapes.size() != 2)
+        return;
+
+    AreaDbl area = compute_intersection_area(
+            test_params.shapes[0],
+            test_params.shapes[1]);
+    AreaDbl expected_area = 0.0;
+    for (const ShapeWithHoles& shape: test_params.expected_output)
+        expected_area += shape.compute_area();
+    EXPECT_NEAR(area, expected_area, 1e-6 * (std::max)(1.0, expected_area));
+
+    // The area doesn't depend on the order of the shapes.
+    AreaDbl area_2 = compute_intersection_area(
+            test_params.shapes[1],
+            test_params.shapes[0]);
+    EXPECT_NEAR(area_2, expected_area, 1e-6 * (std::max)(1.0, expected_area));
+}
+
 INSTANTIATE_TEST_SUITE_P(
         Shape,
         ComputeBooleanIntersectionTest,
@@ -404,6 +563,68 @@ INSTANTIATE_TEST_SUITE_P(
         });
 
 
+/** Build a comb whose teeth, of width 1, go from y = 1 to y = 5. */
+Shape build_comb(ElementPos number_of_teeth)
+{
+    std::vector<BuildShapeElement> points = {{0, 0}, {2.0 * number_of_teeth, 0}};
+    for (ElementPos tooth_pos = number_of_teeth - 1; tooth_pos >= 0; --tooth_pos) {
+        points.push_back({2.0 * tooth_pos + 2, 1});
+        points.push_back({2.0 * tooth_pos + 2, 5});
+        points.push_back({2.0 * tooth_pos + 1, 5});
+        points.push_back({2.0 * tooth_pos + 1, 1});
+    }
+    points.push_back({0, 1});
+    return build_shape(points);
+}
+
+TEST(ComputeIntersectionAreaTest, ManyTouchingPoints)
+{
+    // The ends of the teeth are on the boundary of the rectangle, so the
+    // position of the parts after them is computed again.
+    ShapeWithHoles shape_1 = {build_comb(50)};
+    ShapeWithHoles shape_2 = {build_rectangle(-1, 101, 1, 3)};
+    EXPECT_NEAR(compute_intersection_area(shape_1, shape_2), 100.0, 1e-6);
+    EXPECT_NEAR(compute_intersection_area(shape_2, shape_1), 100.0, 1e-6);
+}
+
+TEST(ComputeIntersectionAreaTest, Batch)
+{
+    std::vector<ShapeWithHoles> shapes;
+    for (ShapePos x = 0; x < 4; ++x) {
+        for (ShapePos y = 0; y < 4; ++y) {
+            shapes.push_back({build_rectangle(3.0 * x, 3.0 * x + 4, 3.0 * y, 3.0 * y + 4)});
+            Shape circle = build_circle(2);
+            circle.shift(3.0 * x + 1, 3.0 * y + 2);
+            shapes.push_back({circle});
+        }
+    }
+    ShapeWithHoles comb = {build_comb(5)};
+    comb.holes.push_back(build_rectangle(1, 9, 0.25, 0.75));
+    shapes.push_back(comb);
+
+    std::vector<std::pair<ShapePos, ShapePos>> pairs;
+    for (ShapePos shape_pos_1 = 0; shape_pos_1 < (ShapePos)shapes.size(); ++shape_pos_1)
+        for (ShapePos shape_pos_2 = 0; shape_pos_2 < (ShapePos)shapes.size(); ++shape_pos_2)
+            pairs.push_back({shape_pos_1, shape_pos_2});
+
+    for (Counter number_of_threads: {1, 4}) {
+        BooleanOperationParameters parameters;
+        parameters.number_of_threads = number_of_threads;
+        std::vector<AreaDbl> areas = compute_intersection_area(shapes, pairs, parameters);
+        ASSERT_EQ(areas.size(), pairs.size());
+        for (ElementPos pair_pos = 0; pair_pos < (ElementPos)pairs.size(); ++pair_pos) {
+            EXPECT_EQ(
+                    areas[pair_pos],
+                    compute_intersection_area(
+                        shapes[pairs[pair_pos].first],
+                        shapes[pairs[pair_pos].second]))
+                << "pair " << pairs[pair_pos].first << " " << pairs[pair_pos].second
+                << " number_of_threads " << number_of_threads;
+        }
+    }
+}
+
+
 struct ComputeBooleanIntersectionMultiShapeTestParams
 {
     std::string name;
@@ -688,6 +909,90 @@ INSTANTIATE_TEST_SUITE_P(
         });
 
 
+TEST(ComputeBooleanPreparedShapeTest, ComputeBooleanPreparedShape)
+{
+    // Bin with a grid of holes.
+    ShapeWithHoles bin = {build_rectangle(0, 100, 0, 60)};
+    for (LengthDbl x = 5; x < 100; x += 10)
+        for (LengthDbl y = 5; y < 60; y += 10)
+            bin.holes.push_back(build_rectangle(x, x + 4, y, y + 4));
+    PreparedShape prepared_bin(bin);
+
+    std::vector<ShapeWithHoles> items = {
+        {build_rectangle(1, 3, 1, 3)},  // inside, no hole
+        {build_rectangle(2, 7, 2, 7)},  // overlaps a hole
+        {build_rectangle(14, 21, 14, 21)},  // contains a hole
+        {build_rectangle(4, 31, 4.5, 5.5)},  // overlaps several holes
+        {build_rectangle(3, 40, 3, 40)},  // contains several holes
+        {build_rectangle(3, 40, 3, 40), {build_rectangle(12, 31, 12, 31)}},  // isolates a part of the bin
+        {build_rectangle(-5, 3, 20, 23)},  // crosses the outline
+        {build_rectangle(-5, 105, 20, 23)},  // cuts the bin
+        {build_rectangle(200, 210, 0, 10)},  // outside
+        {build_rectangle(0, 100, 0, 60)},  // equal to the outline
+    };
+    for (const ShapeWithHoles& item: items) {
+        std::cout << "item " << item.to_string(0) << std::endl;
+        auto expected_difference = compute_difference(bin, item).shapes_with_holes;
+        auto difference = compute_difference(prepared_bin, item).shapes_with_holes;
+        auto expected_intersection = compute_intersection(bin, item).shapes_with_holes;
+        auto intersection = compute_intersection(prepared_bin, item).shapes_with_holes;
+
+        auto area = [](const std::vector<ShapeWithHoles>& shapes)
+        {
+            AreaDbl area = 0.0;
+            for (const ShapeWithHoles& shape: shapes)
+                area += shape.compute_area();
+            return area;
+        };
+        EXPECT_EQ(difference.size(), expected_difference.size());
+        EXPECT_NEAR(area(difference), area(expected_difference), 1e-6);
+        for (const ShapeWithHoles& shape: difference) {
+            // Each shape must have the holes of the matching expected shape.
+            EXPECT_NE(std::find_if(
+                          expected_difference.begin(),
+                          expected_difference.end(),
+                          [&shape](const ShapeWithHoles& expected_shape)
+                          {
+                              return equal(shape.shape, expected_shape.shape)
+                                  && shape.holes.size() == expected_shape.holes.size();
+                          }),
+                      expected_difference.end());
+        }
+        EXPECT_EQ(intersection.size(), expected_intersection.size());
+        EXPECT_NEAR(area(intersection), area(expected_intersection), 1e-6);
+    }
+}
+
+TEST(ComputeBooleanPreparedShapeTest, PreparedShapeContains)
+{
+    // Bin with a grid of holes, some of them with rounded corners.
+    ShapeWithHoles bin = {build_rectangle(0, 100, 0, 60)};
+    for (LengthDbl x = 5; x < 100; x += 10)
+        for (LengthDbl y = 5; y < 60; y += 10)
+            bin.holes.push_back(build_rectangle(x, x + 4, y, y + 4));
+    bin.holes.push_back(build_shape({
+                {1, 0}, {3, 0}, {3, 1, 1}, {4, 1}, {4, 3}, {3, 3, 1},
+                {3, 4}, {1, 4}, {1, 3, 1}, {0, 3}, {0, 1}, {1, 1, 1}}).shift(50, 1));
+    PreparedShape prepared_bin(bin);
+
+    std::mt19937_64 generator(0);
+    std::uniform_real_distribution<LengthDbl> distribution_x(-1, 101);
+    std::uniform_real_distribution<LengthDbl> distribution_y(-1, 61);
+    std::vector<Point> points;
+    for (Counter k = 0; k < 2000; ++k)
+        points.push_back({distribution_x(generator), distribution_y(generator)});
+    for (LengthDbl x = 0; x <= 100; x += 0.5)
+        for (LengthDbl y: {0.0, 1.0, 5.0, 7.0, 9.0, 9.0 + 1e-7, 60.0})
+            points.push_back({x, y});
+    for (const Point& point: points) {
+        for (bool strict: {false, true}) {
+            EXPECT_EQ(prepared_bin.contains(point, strict), bin.contains(point, strict))
+                << "point " << point.to_string() << " strict " << strict;
+        }
+    }
+}
+
+
 struct ExtractOutlineTestParams
 {
     std::string name;
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "shape/shape.hpp"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+namespace shape
+{
+
+/**
+ * Test case of the structures answering point-in-shape queries, which must
+ * return the same values as Shape::contains.
+ */
+struct ContainsTestParams
+{
+    std::string name;
+    Shape shape;
+};
+
+inline void PrintTo(const ContainsTestParams& params, std::ostream* os)
+{
+    *os << "shape " << params.shape.to_string(0) << "\n";
+}
+
+/** Get the shapes of the test cases. */
+inline std::vector<ContainsTestParams> contains_test_cases()
+{
+    return {
+        {
+            "Square",
+            build_square(1),
+        }, {
+            "Triangle",
+            build_triangle({0, 0}, {3, 0}, {1, 2}),
+        }, {
+            "UShape",
+            build_shape({{0, 0}, {3, 0}, {3, 3}, {2, 3}, {2, 1}, {1, 1}, {1, 3}, {0, 3}}),
+        }, {
+            "Bowtie",
+            build_shape({{0, 0}, {2, 2}, {2, 0}, {0, 2}}),
+        }, {
+            "Circle",
+            build_circle(2),
+        }, {
+            "HalfDisk",
+            build_shape({{0, 0}, {4, 0}, {2, 0, 1}}),
+        }, {
+            "DrilledTriangle",
+            build_shape({{0, 0}, {1, 0}, {0, 0, -1}, {1, 1}}),
+        }, {
+            "RoundedRectangle",
+            build_shape({
+                    {1, 0}, {9, 0}, {9, 1, 1}, {10, 1}, {10, 9}, {9, 9, 1},
+                    {9, 10}, {1, 10}, {1, 9, 1}, {0, 9}, {0, 1}, {1, 1, 1}}),
+        }, {
+            "ArcsOverHalfCircles",
+            build_shape({{2, 0}, {0, 0, 1}, {-1, 1.7320508075688772}, {0, 0, 1}, {-1, -1.7320508075688772}, {0, 0, 1}}),
+        }, {
+            "ArcShapeTangentToPath",
+            build_shape({
+                    {5.93700787, 5.93700787},
+                    {17.68503937, 5.93700787},
+                    {17.68503937, 15.7480315},
+                    {19.68503937, 15.7480315, -1},
+                    {5.93700787, 17.68503937}}),
+        }, {
+            "Comb",
+            build_shape({
+                    {0, 0}, {10, 0}, {10, 5}, {9, 5}, {9, 1}, {8, 1}, {8, 5}, {7, 5}, {7, 1},
+                    {6, 1}, {6, 5}, {5, 5}, {5, 1}, {4, 1}, {4, 5}, {3, 5}, {3, 1}, {2, 1},
+                    {2, 5}, {1, 5}, {1, 1}, {0, 1}}),
+        }, {
+            "AlmostHorizontalEdge",
+            build_shape({{0, 0}, {1000, 1e-3}, {1000, 1}, {0, 1}}),
+        },
+    };
+}
+
+/** Get the name of a test case. */
+inline std::string contains_test_case_name(
+        const testing::TestParamInfo<ContainsTestParams>& info)
+{
+    return info.param.name;
+}
+
+/**
+ * Get the points to check on a shape: points of its boundary, points close
+ * to it and random points around the shape.
+ */
+inline std::vector<Point> contains_test_points(const Shape& shape)
+{
+    std::mt19937_64 generator(0);
+    AxisAlignedBoundingBox aabb = shape.compute_min_max();
+    std::uniform_real_distribution<LengthDbl> distribution_x(aabb.x_min - 1, aabb.x_max + 1);
+    std::uniform_real_distribution<LengthDbl> distribution_y(aabb.y_min - 1, aabb.y_max + 1);
+    std::vector<Point> points;
+    for (const ShapeElement& element: shape.elements) {
+        for (Counter k = 0; k <= 8; ++k)
+            points.push_back(element.point(element.length() * k / 8));
+        if (element.type == ShapeElementType::CircularArc) {
+            points.push_back({element.center.x, element.center.y + element.radius()});
+            points.push_back({element.center.x, element.center.y - element.radius()});
+        }
+        points.push_back({distribution_x(generator), element.start.y});
+    }
+    for (ElementPos pos = (ElementPos)points.size() - 1; pos >= 0; --pos) {
+        for (LengthDbl offset: {1e-7, 1e-6, 2e-6, 1e-5, 2e-5, 1e-3}) {
+            points.push_back({points[pos].x + offset, points[pos].y});
+            points.push_back({points[pos].x - offset, points[pos].y});
+            points.push_back({points[pos].x, points[pos].y + offset});
+            points.push_back({points[pos].x, points[pos].y - offset});
+        }
+    }
+    for (Counter k = 0; k < 1000; ++k)
+        points.push_back({distribution_x(generator), distribution_y(generator)});
+    return points;
+}
+
+}
@@ -0,0 +1,152 @@
+#include "shape/dynamic_intersection_tree.hpp"
+
+#include "shape/shapes_intersections.hpp"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+using namespace shape;
+
+struct DynamicIntersectionTreeTestParams
+{
+    bool lazy_rebalancing = false;
+};
+
+void PrintTo(const DynamicIntersectionTreeTestParams& params, std::ostream* os)
+{
+    *os << "lazy_rebalancing " << params.lazy_rebalancing << "\n";
+}
+
+class DynamicIntersectionTreeTest: public testing::TestWithParam<DynamicIntersectionTreeTestParams> { };
+
+TEST_P(DynamicIntersectionTreeTest, DynamicIntersectionTree)
+{
+    DynamicIntersectionTreeTestParams test_params = GetParam();
+    PrintTo(test_params, &std::cout);
+
+    DynamicIntersectionTreeParameters parameters;
+    parameters.lazy_rebalancing = test_params.lazy_rebalancing;
+    DynamicIntersectionTree intersection_tree(parameters);
+
+    std::mt19937_64 generator(0);
+    std::uniform_real_distribution<LengthDbl> distribution_position(0, 100);
+    std::uniform_real_distribution<LengthDbl> distribution_size(1, 5);
+    auto random_shape = [&]()
+    {
+        LengthDbl x = distribution_position(generator);
+        LengthDbl y = distribution_position(generator);
+        return ShapeWithHoles{build_rectangle(
+                x,
+                x + distribution_size(generator),
+                y,
+                y + distribution_size(generator))};
+    };
+    auto random_element = [&]()
+    {
+        Point start = {distribution_position(generator), distribution_position(generator)};
+        Point end = {start.x + distribution_size(generator), start.y + distribution_size(generator)};
+        return build_line_segment(start, end);
+    };
+
+    // Insert shapes and elements, and remove some of them.
+    std::vector<ShapePos> shape_ids;
+    std::vector<ElementPos> element_ids;
+    for (Counter step = 0; step < 2000; ++step) {
+        if (step % 5 == 4 && !shape_ids.empty()) {
+            ShapePos pos = generator() % shape_ids.size();
+            intersection_tree.remove_shape(shape_ids[pos]);
+            shape_ids.erase(shape_ids.begin() + pos);
+        } else if (step % 7 == 6 && !element_ids.empty()) {
+            ElementPos pos = generator() % element_ids.size();
+            intersection_tree.remove_element(element_ids[pos]);
+            element_ids.erase(element_ids.begin() + pos);
+        } else if (step % 2 == 0) {
+            shape_ids.push_back(intersection_tree.insert(random_shape()));
+        } else {
+            element_ids.push_back(intersection_tree.insert(random_element()));
+        }
+    }
+    std::sort(shape_ids.begin(), shape_ids.end());
+    std::sort(element_ids.begin(), element_ids.end());
+    EXPECT_EQ(intersection_tree.number_of_shapes(), (ShapePos)shape_ids.size());
+    EXPECT_EQ(intersection_tree.number_of_elements(), (ElementPos)element_ids.size());
+    if (!test_params.lazy_rebalancing) {
+        EXPECT_LE(intersection_tree.height(), 30);
+    }
+
+    // Compare the queries with a brute force.
+    for (Counter query_pos = 0; query_pos < 100; ++query_pos) {
+        ShapeWithHoles shape = random_shape();
+        ShapeElement element = random_element();
+        Point point = {distribution_position(generator), distribution_position(generator)};
+        for (bool strict: {false, true}) {
+            DynamicIntersectionTree::IntersectOutput expected_shape_output;
+            DynamicIntersectionTree::IntersectOutput expected_element_output;
+            DynamicIntersectionTree::IntersectOutput expected_point_output;
+            for (ShapePos shape_id: shape_ids) {
+                const ShapeWithHoles& tree_shape = intersection_tree.shape(shape_id);
+                if (intersect(shape, tree_shape, strict))
+                    expected_shape_output.shape_ids.push_back(shape_id);
+                if (intersect(tree_shape, element, strict))
+                    expected_element_output.shape_ids.push_back(shape_id);
+                if (tree_shape.contains(point, strict))
+                    expected_point_output.shape_ids.push_back(shape_id);
+            }
+            for (ElementPos element_id: element_ids) {
+                const ShapeElement& tree_element = intersection_tree.element(element_id);
+                if (intersect(shape, tree_element, strict))
+                    expected_shape_output.element_ids.push_back(element_id);
+                if (!strict && intersect(tree_element, element))
+                    expected_element_output.element_ids.push_back(element_id);
+                if (strict && !compute_intersections(tree_element, element).improper_intersections.empty())
+                    expected_element_output.element_ids.push_back(element_id);
+                if (!strict && tree_element.contains(point))
+                    expected_point_output.element_ids.push_back(element_id);
+            }
+
+            DynamicIntersectionTree::IntersectOutput shape_output = intersection_tree.intersect(shape, strict);
+            EXPECT_EQ(shape_output.shape_ids, expected_shape_output.shape_ids);
+            EXPECT_EQ(shape_output.element_ids, expected_shape_output.element_ids);
+            DynamicIntersectionTree::IntersectOutput element_output = intersection_tree.intersect(element, strict);
+            EXPECT_EQ(element_output.shape_ids, expected_element_output.shape_ids);
+            EXPECT_EQ(element_output.element_ids, expected_element_output.element_ids);
+            DynamicIntersectionTree::IntersectOutput point_output = intersection_tree.intersect(point, strict);
+            EXPECT_EQ(point_output.shape_ids, expected_point_output.shape_ids);
+            EXPECT_EQ(point_output.element_ids, expected_point_output.element_ids);
+        }
+    }
+
+    std::vector<std::pair<ShapePos, ShapePos>> expected_intersecting_shapes;
+    for (ShapePos pos_1 = 0; pos_1 < (ShapePos)shape_ids.size(); ++pos_1) {
+        for (ShapePos pos_2 = pos_1 + 1; pos_2 < (ShapePos)shape_ids.size(); ++pos_2) {
+            if (intersect(
+                        intersection_tree.shape(shape_ids[pos_1]),
+                        intersection_tree.shape(shape_ids[pos_2]),
+                        false)) {
+                expected_intersecting_shapes.push_back({shape_ids[pos_1], shape_ids[pos_2]});
+            }
+        }
+    }
+    EXPECT_EQ(intersection_tree.compute_intersecting_shapes(false), expected_intersecting_shapes);
+
+    // Remove everything.
+    for (ShapePos shape_id: shape_ids)
+        intersection_tree.remove_shape(shape_id);
+    for (ElementPos element_id: element_ids)
+        intersection_tree.remove_element(element_id);
+    EXPECT_EQ(intersection_tree.height(), 0);
+    for (ShapePos shape_id: shape_ids)
+        EXPECT_TRUE(intersection_tree.shape(shape_id).shape.elements.empty());
+    for (ElementPos element_id: element_ids)
+        EXPECT_TRUE(intersection_tree.element(element_id) == ShapeElement());
+    EXPECT_TRUE(intersection_tree.intersect(Point{50, 50}, false).shape_ids.empty());
+    EXPECT_THROW(intersection_tree.remove_shape(0), std::invalid_argument);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+        Shape,
+        DynamicIntersectionTreeTest,
+        testing::ValuesIn(std::vector<DynamicIntersectionTreeTestParams>{
+            {false},
+            {true}}));
@@ -9,6 +9,7 @@
 #include <gtest/gtest.h>
 
 #include <fstream>
+#include <random>
 
 using namespace shape;
 
@@ -52,41 +53,32 @@ void PrintTo(const ComputeIntersectionsTestParams& params, std::ostream* os)
     *os << "  " << params.expected_output.to_string(2) << "\n";
 }
 
-class ComputeIntersectionsTest: public testing::TestWithParam<ComputeIntersectionsTestParams> { };
-
-TEST_P(ComputeIntersectionsTest, ComputeIntersections)
+/**
+ * Check that the intersections of two elements are the expected ones, in any
+ * order.
+ */
+void check_intersections(
+        const ShapeElementIntersectionsOutput& intersections,
+        const ShapeElementIntersectionsOutput& expected_output)
 {
-    ComputeIntersectionsTestParams test_params = GetParam();
-    PrintTo(test_params, &std::cout);
-
-#ifdef ELEMENTS_INTERSECTIONS_TEST_ENABLE_DEBUG
-    Writer().add_element(test_params.element_1).add_element(test_params.element_2).write_json("elements_intersections_input.json");
-#endif
-
-    ShapeElementIntersectionsOutput intersections = compute_intersections(
-            test_params.element_1,
-            test_params.element_2);
-    std::cout << "output" << std::endl;
-    std::cout << "  " << intersections.to_string(2) << std::endl;
-
-    ASSERT_EQ(intersections.overlapping_parts.size(), test_params.expected_output.overlapping_parts.size());
-    for (const auto& expected_intersection: test_params.expected_output.overlapping_parts) {
+    ASSERT_EQ(intersections.overlapping_parts.size(), expected_output.overlapping_parts.size());
+    for (const auto& expected_intersection: expected_output.overlapping_parts) {
         EXPECT_NE(std::find_if(
                     intersections.overlapping_parts.begin(),
                     intersections.overlapping_parts.end(),
                     [&expected_intersection](const ShapeElement& overlapping_part) { return equal(overlapping_part, expected_intersection) || equal(overlapping_part.reverse(), expected_intersection); }),
                 intersections.overlapping_parts.end());
     }
-    ASSERT_EQ(intersections.improper_intersections.size(), test_params.expected_output.improper_intersections.size());
-    for (const Point& expected_intersection: test_params.expected_output.improper_intersections) {
+    ASSERT_EQ(intersections.improper_intersections.size(), expected_output.improper_intersections.size());
+    for (const Point& expected_intersection: expected_output.improper_intersections) {
         EXPECT_NE(std::find_if(
                     intersections.improper_intersections.begin(),
                     intersections.improper_intersections.end(),
                     [&expected_intersection](const Point& point) { return equal(point, expected_intersection); }),
                 intersections.improper_intersections.end());
     }
-    ASSERT_EQ(intersections.proper_intersections.size(), test_params.expected_output.proper_intersections.size());
-    for (const Point& expected_intersection: test_params.expected_output.proper_intersections) {
+    ASSERT_EQ(intersections.proper_intersections.size(), expected_output.proper_intersections.size());
+    for (const Point& expected_intersection: expected_output.proper_intersections) {
         EXPECT_NE(std::find_if(
                     intersections.proper_intersections.begin(),
                     intersections.proper_intersections.end(),
@@ -95,6 +87,69 @@ TEST_P(ComputeIntersectionsTest, ComputeIntersections)
     }
 }
 
+class ComputeIntersectionsTest: public testing::TestWithParam<ComputeIntersectionsTestParams> { };
+
+TEST_P(ComputeIntersectionsTest, ComputeIntersections)
+{
+    ComputeIntersectionsTestParams test_params = GetParam();
+    PrintTo(test_params, &std::cout);
+
+#ifdef ELEMENTS_INTERSECTIONS_TEST_ENABLE_DEBUG
+    Writer().add_element(test_params.element_1).add_element(test_params.element_2).write_json("elements_intersections_input.json");
+#endif
+
+    ShapeElementIntersectionsOutput intersections = compute_intersections(
+            test_params.element_1,
+            test_params.element_2);
+    std::cout << "output" << std::endl;
+    std::cout << "  " << intersections.to_string(2) << std::endl;
+
+    check_intersections(intersections, test_params.expected_output);
+}
+
+TEST_P(ComputeIntersectionsTest, ComputeIntersectionsFixed)
+{
+    ComputeIntersectionsTestParams test_params = GetParam();
+
+    // The output is reused, so it must be reset by compute_intersections.
+    FixedShapeElementIntersectionsOutput intersections;
+    compute_intersections(test_params.element_1, test_params.element_1, intersections);
+    compute_intersections(test_params.element_1, test_params.element_2, intersections);
+    check_intersections(intersections.to_output(), test_params.expected_output);
+}
+
+TEST(ComputeIntersectionsTest, FixedOutputCapacity)
+{
+    FixedShapeElementIntersectionsOutput intersections;
+    ShapeElement element = build_line_segment({0, 0}, {1, 0});
+    for (ElementPos pos = 0; pos < 2; ++pos)
+        intersections.add_overlapping_part(element);
+    EXPECT_THROW(intersections.add_overlapping_part(element), std::logic_error);
+    for (ElementPos pos = 0; pos < 4; ++pos)
+        intersections.add_improper_intersection({0, 0});
+    EXPECT_THROW(intersections.add_improper_intersection({0, 0}), std::logic_error);
+    for (ElementPos pos = 0; pos < 2; ++pos)
+        intersections.add_proper_intersection({0, 0});
+    EXPECT_THROW(intersections.add_proper_intersection({0, 0}), std::logic_error);
+    EXPECT_EQ(intersections.number_of_overlapping_parts, 2);
+    EXPECT_EQ(intersections.number_of_improper_intersections, 4);
+    EXPECT_EQ(intersections.number_of_proper_intersections, 2);
+}
+
+TEST_P(ComputeIntersectionsTest, Intersect)
+{
+    ComputeIntersectionsTestParams test_params = GetParam();
+    const ShapeElementIntersectionsOutput& expected_output = test_params.expected_output;
+    bool expected_intersect = !expected_output.overlapping_parts.empty()
+        || !expected_output.improper_intersections.empty()
+        || !expected_output.proper_intersections.empty();
+    bool expected_strictly_intersect = !expected_output.proper_intersections.empty();
+    EXPECT_EQ(intersect(test_params.element_1, test_params.element_2), expected_intersect);
+    EXPECT_EQ(intersect(test_params.element_1, test_params.element_2, true), expected_strictly_intersect);
+    EXPECT_EQ(intersect(test_params.element_2, test_params.element_1), expected_intersect);
+    EXPECT_EQ(intersect(test_params.element_2, test_params.element_1, true), expected_strictly_intersect);
+}
+
 INSTANTIATE_TEST_SUITE_P(
         Shape,
         ComputeIntersectionsTest,
@@ -393,3 +448,95 @@ INSTANTIATE_TEST_SUITE_P(
         [](const testing::TestParamInfo<ComputeIntersectionsTest::ParamType>& info) {
             return std::to_string(info.index);
         });
+
+TEST(ElementsIntersections, Distance)
+{
+    std::mt19937_64 generator(0);
+    std::uniform_real_distribution<LengthDbl> distribution_position(0, 10);
+    std::uniform_real_distribution<Angle> distribution_angle(0, 2 * M_PI);
+    auto random_element = [&](bool arc)
+    {
+        Point point = {distribution_position(generator), distribution_position(generator)};
+        Angle angle = distribution_angle(generator);
+        if (!arc) {
+            return build_line_segment(
+                    point,
+                    {point.x + 4 * std::cos(angle), point.y + 4 * std::sin(angle)});
+        }
+        Angle angle_end = angle + distribution_angle(generator) / 2;
+        return build_circular_arc(
+                {point.x + 2 * std::cos(angle), point.y + 2 * std::sin(angle)},
+                {point.x + 2 * std::cos(angle_end), point.y + 2 * std::sin(angle_end)},
+                point,
+                ShapeElementOrientation::Anticlockwise);
+    };
+
+    // Compare with the distance between the second element and points
+    // sampled on the first one.
+    Counter number_of_samples = 2000;
+    for (Counter test_pos = 0; test_pos < 200; ++test_pos) {
+        ShapeElement element_1 = random_element(test_pos % 2 == 0);
+        ShapeElement element_2 = random_element(test_pos % 4 < 2);
+        LengthDbl sampled_distance = std::numeric_limits<LengthDbl>::infinity();
+        for (Counter sample_pos = 0; sample_pos <= number_of_samples; ++sample_pos) {
+            Point point = element_1.point(element_1.length() * sample_pos / number_of_samples);
+            sampled_distance = (std::min)(sampled_distance, distance(point, element_2));
+        }
+        LengthDbl d = distance(element_1, element_2);
+        EXPECT_LE(d, sampled_distance + 1e-6);
+        EXPECT_GE(d, sampled_distance - element_1.length() / number_of_samples);
+        EXPECT_NEAR(d, distance(element_2, element_1), 1e-6);
+    }
+}
+
+TEST(ElementsIntersections, IntersectRandom)
+{
+    // Coordinates on a coarse grid, so that many pairs touch, overlap or are
+    // tangent.
+    std::mt19937_64 generator(0);
+    std::uniform_int_distribution<int> distribution_coordinate(0, 4);
+    auto random_point = [&generator, &distribution_coordinate]()
+    {
+        return Point{
+            (LengthDbl)distribution_coordinate(generator),
+            (LengthDbl)distribution_coordinate(generator)};
+    };
+    auto random_element = [&generator, &random_point]()
+    {
+        for (;;) {
+            Point start = random_point();
+            Point end = random_point();
+            if (start == end)
+                continue;
+            if (generator() % 2 == 0)
+                return build_line_segment(start, end);
+            // Center on the perpendicular bisector of the chord.
+            Point middle = 0.5 * (start + end);
+            Point normal = {start.y - end.y, end.x - start.x};
+            LengthDbl offset = (LengthDbl)((int)(generator() % 5) - 2) / 2;
+            return build_circular_arc(
+                    start,
+                    end,
+                    middle + offset * normal,
+                    (generator() % 2 == 0)?
+                        ShapeElementOrientation::Anticlockwise:
+                        ShapeElementOrientation::Clockwise);
+        }
+    };
+
+    for (Counter pair_pos = 0; pair_pos < 20000; ++pair_pos) {
+        ShapeElement element_1 = random_element();
+        ShapeElement element_2 = random_element();
+        ShapeElementIntersectionsOutput intersections = compute_intersections(
+                element_1,
+                element_2);
+        bool expected_intersect = !intersections.overlapping_parts.empty()
+            || !intersections.improper_intersections.empty()
+            || !intersections.proper_intersections.empty();
+        bool expected_strictly_intersect = !intersections.proper_intersections.empty();
+        EXPECT_EQ(intersect(element_1, element_2), expected_intersect)
+            << element_1.to_string() << " " << element_2.to_string();
+        EXPECT_EQ(intersect(element_1, element_2, true), expected_strictly_intersect)
+            << element_1.to_string() << " " << element_2.to_string();
+    }
+}
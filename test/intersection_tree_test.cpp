@@ -2,6 +2,8 @@
 
 #include <gtest/gtest.h>
 
+#include <thread>
+
 using namespace shape;
 
 struct IntersectionTreeTestParams
@@ -139,3 +141,412 @@ INSTANTIATE_TEST_SUITE_P(
         [](const testing::TestParamInfo<IntersectionTreeTest::ParamType>& info) {
             return info.param.name;
         });
+
+namespace
+{
+
+struct GridInstance
+{
+    std::vector<ShapeWithHoles> shapes;
+    std::vector<ShapeElement> elements;
+    std::vector<Point> points;
+};
+
+/**
+ * Build a grid of 'size' x 'size' overlapping squares, with the two diagonals
+ * of a box slightly wider than each square and a point inside it.
+ */
+GridInstance build_grid_instance(ShapePos size)
+{
+    GridInstance instance;
+    for (ShapePos x = 0; x < size; ++x) {
+        for (ShapePos y = 0; y < size; ++y) {
+            instance.shapes.push_back({build_rectangle(3 * x, 3 * x + 4, 3 * y, 3 * y + 4)});
+            instance.elements.push_back(build_line_segment({3.0 * x, 3.0 * y}, {3.0 * x + 5, 3.0 * y + 2}));
+            instance.elements.push_back(build_line_segment({3.0 * x, 3.0 * y + 2}, {3.0 * x + 5, 3.0 * y}));
+            instance.points.push_back({3.0 * x + 1, 3.0 * y + 1});
+        }
+    }
+    return instance;
+}
+
+void expect_same_intersecting_elements(
+        const std::vector<ElementElementIntersection>& intersections_1,
+        const std::vector<ElementElementIntersection>& intersections_2)
+{
+    ASSERT_EQ(intersections_1.size(), intersections_2.size());
+    for (ElementPos pos = 0; pos < (ElementPos)intersections_1.size(); ++pos) {
+        EXPECT_EQ(intersections_1[pos].element_id_1, intersections_2[pos].element_id_1);
+        EXPECT_EQ(intersections_1[pos].element_id_2, intersections_2[pos].element_id_2);
+        EXPECT_EQ(
+                intersections_1[pos].intersections.proper_intersections.size(),
+                intersections_2[pos].intersections.proper_intersections.size());
+    }
+}
+
+}
+
+TEST(IntersectionTree, ConcurrentQueries)
+{
+    IntersectionTree intersection_tree(build_grid_instance(20).shapes, {}, {});
+
+    std::vector<Point> query_points;
+    for (ShapePos x = 0; x < 60; ++x)
+        for (ShapePos y = 0; y < 60; ++y)
+            query_points.push_back({x + 0.5, y + 0.5});
+    std::vector<std::vector<ShapePos>> expected_shape_ids;
+    for (const Point& point: query_points)
+        expected_shape_ids.push_back(intersection_tree.intersect(point, true).shape_ids);
+
+    // Each thread queries the shared tree with its own scratch.
+    Counter number_of_threads = 4;
+    std::vector<std::vector<ShapePos>> shape_ids(query_points.size());
+    std::vector<std::thread> threads;
+    for (Counter thread_id = 0; thread_id < number_of_threads; ++thread_id) {
+        threads.emplace_back([&, thread_id]()
+        {
+            IntersectionTree::QueryScratch scratch(intersection_tree);
+            for (ElementPos point_pos = thread_id;
+                    point_pos < (ElementPos)query_points.size();
+                    point_pos += number_of_threads) {
+                shape_ids[point_pos] = intersection_tree.intersect(
+                        query_points[point_pos],
+                        true,
+                        scratch).shape_ids;
+            }
+        });
+    }
+    for (std::thread& thread: threads)
+        thread.join();
+
+    for (ElementPos point_pos = 0;
+            point_pos < (ElementPos)query_points.size();
+            ++point_pos) {
+        std::sort(shape_ids[point_pos].begin(), shape_ids[point_pos].end());
+        std::sort(expected_shape_ids[point_pos].begin(), expected_shape_ids[point_pos].end());
+        EXPECT_EQ(shape_ids[point_pos], expected_shape_ids[point_pos]);
+    }
+}
+
+TEST(IntersectionTree, ParallelConstruction)
+{
+    GridInstance instance = build_grid_instance(40);
+    IntersectionTree intersection_tree(instance.shapes, instance.elements, instance.points);
+    IntersectionTreeParameters parameters;
+    parameters.number_of_threads = 4;
+    parameters.parallel_threshold = 64;
+    IntersectionTree intersection_tree_parallel(instance.shapes, instance.elements, instance.points, parameters);
+
+    // The trees must be identical, so the outputs must be in the same order.
+    for (const ShapeWithHoles& shape: instance.shapes) {
+        IntersectionTree::IntersectOutput output = intersection_tree.intersect(shape, false);
+        IntersectionTree::IntersectOutput output_parallel = intersection_tree_parallel.intersect(shape, false);
+        EXPECT_EQ(output.shape_ids, output_parallel.shape_ids);
+        EXPECT_EQ(output.element_ids, output_parallel.element_ids);
+        EXPECT_EQ(output.point_ids, output_parallel.point_ids);
+    }
+    EXPECT_EQ(
+            intersection_tree.compute_intersecting_shapes(false),
+            intersection_tree_parallel.compute_intersecting_shapes(false));
+    expect_same_intersecting_elements(
+            intersection_tree.compute_intersecting_elements(false),
+            intersection_tree_parallel.compute_intersecting_elements(false));
+    EXPECT_EQ(
+            intersection_tree.compute_equal_points(),
+            intersection_tree_parallel.compute_equal_points());
+}
+
+TEST(IntersectionTree, ParallelIntersectingPairs)
+{
+    GridInstance instance = build_grid_instance(40);
+    IntersectionTree intersection_tree(instance.shapes, instance.elements, {});
+
+    // The outputs must be in the same order whatever the number of threads.
+    for (Counter number_of_threads: {2, 3, 8}) {
+        for (bool strict: {false, true}) {
+            EXPECT_EQ(
+                    intersection_tree.compute_intersecting_shapes(strict),
+                    intersection_tree.compute_intersecting_shapes(strict, number_of_threads));
+            expect_same_intersecting_elements(
+                    intersection_tree.compute_intersecting_elements(strict),
+                    intersection_tree.compute_intersecting_elements(strict, number_of_threads));
+        }
+    }
+}
+
+TEST(IntersectionTree, Executor)
+{
+    GridInstance instance = build_grid_instance(40);
+    IntersectionTree intersection_tree(instance.shapes, instance.elements, {});
+
+    // Executor running the tasks in reverse order.
+    Counter number_of_tasks = 0;
+    Executor executor = [&number_of_tasks](const std::vector<std::function<void()>>& tasks)
+    {
+        number_of_tasks += tasks.size();
+        for (auto it = tasks.rbegin(); it != tasks.rend(); ++it)
+            (*it)();
+    };
+    IntersectionTreeParameters parameters;
+    parameters.number_of_threads = 4;
+    parameters.parallel_threshold = 64;
+    parameters.executor = executor;
+    IntersectionTree intersection_tree_executor(instance.shapes, instance.elements, {}, parameters);
+    EXPECT_EQ(number_of_tasks, 4);
+
+    for (const ShapeWithHoles& shape: instance.shapes) {
+        IntersectionTree::IntersectOutput output = intersection_tree.intersect(shape, false);
+        IntersectionTree::IntersectOutput output_executor = intersection_tree_executor.intersect(shape, false);
+        EXPECT_EQ(output.shape_ids, output_executor.shape_ids);
+        EXPECT_EQ(output.element_ids, output_executor.element_ids);
+    }
+    number_of_tasks = 0;
+    EXPECT_EQ(
+            intersection_tree.compute_intersecting_shapes(false),
+            intersection_tree.compute_intersecting_shapes(false, 3, executor));
+    EXPECT_EQ(number_of_tasks, 3);
+    expect_same_intersecting_elements(
+            intersection_tree.compute_intersecting_elements(false),
+            intersection_tree.compute_intersecting_elements(false, 3, executor));
+}
+
+TEST(IntersectionTree, OwningGeometry)
+{
+    std::vector<ShapeWithHoles> shapes = build_grid_instance(10).shapes;
+    IntersectionTree intersection_tree(shapes, {}, {});
+
+    // Build the owning tree from temporaries and keep a copy of it once the
+    // original is destroyed.
+    std::vector<IntersectionTree> cache;
+    {
+        IntersectionTree intersection_tree_owning(build_grid_instance(10).shapes, {}, {});
+        cache.push_back(intersection_tree_owning);
+    }
+    for (ShapePos x = 0; x < 30; ++x) {
+        for (ShapePos y = 0; y < 30; ++y) {
+            Point point = {x + 0.5, y + 0.5};
+            EXPECT_EQ(
+                    cache.front().intersect(point, true).shape_ids,
+                    intersection_tree.intersect(point, true).shape_ids);
+        }
+    }
+    EXPECT_EQ(
+            cache.front().compute_intersecting_shapes(false),
+            intersection_tree.compute_intersecting_shapes(false));
+}
+
+TEST(IntersectionTree, IntersectBatch)
+{
+    GridInstance instance = build_grid_instance(10);
+    IntersectionTree intersection_tree(instance.shapes, instance.elements, instance.points);
+
+    std::vector<Point> query_points;
+    std::vector<ShapeElement> query_elements;
+    for (ShapePos x = 0; x < 30; ++x) {
+        for (ShapePos y = 0; y < 30; ++y) {
+            query_points.push_back({x + 0.5 * (y % 3), y + 0.5 * (x % 3)});
+            query_elements.push_back(build_line_segment({x + 0.5, y + 0.0}, {x + 2.0, y + 1.5}));
+        }
+    }
+
+    auto check = [](
+            const IntersectionTree::IntersectOutput& expected_output,
+            const IntersectionTree::IntersectBatchOutput& output,
+            ElementPos query_pos)
+    {
+        std::vector<ShapePos> shape_ids = expected_output.shape_ids;
+        std::vector<ElementPos> element_ids = expected_output.element_ids;
+        std::vector<ElementPos> point_ids = expected_output.point_ids;
+        std::sort(shape_ids.begin(), shape_ids.end());
+        std::sort(element_ids.begin(), element_ids.end());
+        std::sort(point_ids.begin(), point_ids.end());
+        EXPECT_EQ(shape_ids, std::vector<ShapePos>(
+                    output.shape_ids.begin() + output.shape_offsets[query_pos],
+                    output.shape_ids.begin() + output.shape_offsets[query_pos + 1]));
+        EXPECT_EQ(element_ids, std::vector<ElementPos>(
+                    output.element_ids.begin() + output.element_offsets[query_pos],
+                    output.element_ids.begin() + output.element_offsets[query_pos + 1]));
+        EXPECT_EQ(point_ids, std::vector<ElementPos>(
+                    output.point_ids.begin() + output.point_offsets[query_pos],
+                    output.point_ids.begin() + output.point_offsets[query_pos + 1]));
+    };
+
+    for (bool strict: {false, true}) {
+        IntersectionTree::IntersectBatchOutput points_output
+            = intersection_tree.intersect_batch(query_points, strict);
+        ASSERT_EQ(points_output.shape_offsets.size(), query_points.size() + 1);
+        for (ElementPos query_pos = 0;
+                query_pos < (ElementPos)query_points.size();
+                ++query_pos) {
+            check(intersection_tree.intersect(query_points[query_pos], strict),
+                    points_output,
+                    query_pos);
+        }
+
+        IntersectionTree::IntersectBatchOutput elements_output
+            = intersection_tree.intersect_batch(query_elements, strict);
+        ASSERT_EQ(elements_output.shape_offsets.size(), query_elements.size() + 1);
+        for (ElementPos query_pos = 0;
+                query_pos < (ElementPos)query_elements.size();
+                ++query_pos) {
+            check(intersection_tree.intersect(query_elements[query_pos], strict),
+                    elements_output,
+                    query_pos);
+        }
+    }
+}
+
+TEST(IntersectionTree, ElementProperIntersection)
+{
+    // The query crosses the first element in its middle, touches the end of
+    // the second one and misses the third one.
+    std::vector<ShapeElement> elements = {
+        build_line_segment({0, 0}, {2, 2}),
+        build_line_segment({1, 3}, {2, 0}),
+        build_line_segment({3, 0}, {3, 2}),
+    };
+    IntersectionTree intersection_tree({}, elements, {});
+    ShapeElement element = build_line_segment({0, 2}, {2, 0});
+
+    std::vector<ElementPos> element_ids = intersection_tree.intersect(element, false).element_ids;
+    std::sort(element_ids.begin(), element_ids.end());
+    EXPECT_EQ(element_ids, std::vector<ElementPos>({0, 1}));
+
+    IntersectionTree::IntersectBatchOutput batch_output = intersection_tree.intersect_batch(
+            std::vector<ShapeElement>{element},
+            false);
+    EXPECT_EQ(batch_output.element_ids, std::vector<ElementPos>({0, 1}));
+}
+
+TEST(IntersectionTree, DistanceQueries)
+{
+    std::vector<ShapeElement> elements;
+    for (ShapePos x = 0; x < 15; ++x) {
+        for (ShapePos y = 0; y < 15; ++y) {
+            Point point = {5.0 * x + (y % 3), 5.0 * y + (x % 4)};
+            if ((x + y) % 2 == 0) {
+                elements.push_back(build_line_segment(point, {point.x + 3, point.y + 1}));
+            } else {
+                elements.push_back(build_circular_arc(
+                            {point.x + 2, point.y},
+                            {point.x, point.y + 2},
+                            point,
+                            ShapeElementOrientation::Anticlockwise));
+            }
+        }
+    }
+    IntersectionTree intersection_tree({}, elements, {});
+
+    for (ShapePos x = 0; x < 20; ++x) {
+        for (ShapePos y = 0; y < 20; ++y) {
+            Point point = {3.7 * x - 2, 3.9 * y - 2};
+            std::vector<LengthDbl> distances;
+            for (const ShapeElement& element: elements)
+                distances.push_back(distance(point, element));
+            std::vector<LengthDbl> sorted_distances = distances;
+            std::sort(sorted_distances.begin(), sorted_distances.end());
+
+            IntersectionTree::ElementDistance nearest = intersection_tree.nearest_element(point);
+            EXPECT_EQ(nearest.distance, sorted_distances[0]);
+            EXPECT_EQ(nearest.distance, distances[nearest.element_id]);
+
+            std::vector<IntersectionTree::ElementDistance> k_nearest = intersection_tree.k_nearest(point, 5);
+            ASSERT_EQ(k_nearest.size(), 5);
+            for (ElementPos pos = 0; pos < 5; ++pos) {
+                EXPECT_EQ(k_nearest[pos].distance, sorted_distances[pos]);
+                EXPECT_EQ(k_nearest[pos].distance, distances[k_nearest[pos].element_id]);
+            }
+        }
+    }
+
+    for (ShapePos x = 0; x < 5; ++x) {
+        ShapeWithHoles shape = {build_rectangle(15.0 * x, 15.0 * x + 10, 20, 28)};
+        shape.holes.push_back(build_rectangle(15.0 * x + 2, 15.0 * x + 8, 22, 26));
+        for (LengthDbl d: {0.0, 1.0, 3.5}) {
+            std::vector<ElementPos> expected_element_ids;
+            for (ElementPos element_id = 0;
+                    element_id < (ElementPos)elements.size();
+                    ++element_id) {
+                const ShapeElement& element = elements[element_id];
+                LengthDbl element_distance = 0.0;
+                if (!intersect(shape, element, false)) {
+                    element_distance = std::numeric_limits<LengthDbl>::infinity();
+                    for (const Shape& loop: {shape.shape, shape.holes.front()})
+                        for (const ShapeElement& shape_element: loop.elements)
+                            element_distance = (std::min)(element_distance, distance(element, shape_element));
+                }
+                if (!strictly_greater(element_distance, d))
+                    expected_element_ids.push_back(element_id);
+            }
+            std::vector<ElementPos> element_ids;
+            for (const IntersectionTree::ElementDistance& element_distance:
+                    intersection_tree.elements_within_distance(shape, d)) {
+                element_ids.push_back(element_distance.element_id);
+            }
+            EXPECT_EQ(element_ids, expected_element_ids);
+        }
+    }
+}
+
+TEST(IntersectionTree, Rings)
+{
+    std::vector<Ring> rings;
+    std::vector<ShapeElement> elements;
+    for (ShapePos x = 0; x < 6; ++x) {
+        for (ShapePos y = 0; y < 6; ++y) {
+            Shape shape = ((x + y) % 2 == 0)?
+                build_rectangle(4.0 * x, 4.0 * x + 5, 4.0 * y, 4.0 * y + 3):
+                build_shape({
+                        {4.0 * x, 4.0 * y},
+                        {4.0 * x + 3, 4.0 * y},
+                        {4.0 * x + 3, 4.0 * y + 2, 1},
+                        {4.0 * x + 3, 4.0 * y + 4},
+                        {4.0 * x, 4.0 * y + 4}});
+            rings.push_back(Ring(shape));
+            elements.insert(elements.end(), shape.elements.begin(), shape.elements.end());
+        }
+    }
+    IntersectionTree intersection_tree({}, elements, {});
+    IntersectionTree intersection_tree_rings(rings);
+
+    ElementPos element_id = 0;
+    for (ShapePos ring_pos = 0; ring_pos < (ShapePos)rings.size(); ++ring_pos) {
+        for (ElementPos element_pos = 0;
+                element_pos < rings[ring_pos].number_of_elements();
+                ++element_pos) {
+            EXPECT_EQ(
+                    intersection_tree_rings.ring_element(element_id),
+                    std::make_pair(ring_pos, element_pos));
+            element_id++;
+        }
+    }
+
+    for (ShapePos x = 0; x < 25; ++x) {
+        for (ShapePos y = 0; y < 25; ++y) {
+            ShapeElement element = build_line_segment({x + 0.5, y + 0.0}, {x + 2.0, y + 1.5});
+            for (bool strict: {false, true}) {
+                std::vector<ElementPos> element_ids = intersection_tree.intersect(element, strict).element_ids;
+                std::vector<ElementPos> element_ids_rings = intersection_tree_rings.intersect(element, strict).element_ids;
+                std::sort(element_ids.begin(), element_ids.end());
+                std::sort(element_ids_rings.begin(), element_ids_rings.end());
+                EXPECT_EQ(element_ids_rings, element_ids);
+            }
+            Point point = {x - 0.3, y + 0.7};
+            EXPECT_EQ(
+                    intersection_tree_rings.nearest_element(point).distance,
+                    intersection_tree.nearest_element(point).distance);
+        }
+    }
+
+    auto pairs = [](const std::vector<ElementElementIntersection>& intersections)
+    {
+        std::vector<std::pair<ElementPos, ElementPos>> pairs;
+        for (const ElementElementIntersection& intersection: intersections)
+            pairs.push_back({intersection.element_id_1, intersection.element_id_2});
+        std::sort(pairs.begin(), pairs.end());
+        return pairs;
+    };
+    EXPECT_EQ(
+            pairs(intersection_tree_rings.compute_intersecting_elements(false)),
+            pairs(intersection_tree.compute_intersecting_elements(false)));
+}
@@ -0,0 +1,47 @@
+#include "shape/point_locator.hpp"
+
+#include "contains_test_cases.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace shape;
+
+class PointLocatorTest: public testing::TestWithParam<ContainsTestParams> { };
+
+TEST_P(PointLocatorTest, PointLocator)
+{
+    ContainsTestParams test_params = GetParam();
+    PrintTo(test_params, &std::cout);
+    const Shape& shape = test_params.shape;
+    PointLocator point_locator(shape);
+    std::vector<Point> points = contains_test_points(shape);
+
+    for (const Point& point: points) {
+        for (bool strict: {false, true}) {
+            EXPECT_EQ(point_locator.contains(point, strict), shape.contains(point, strict))
+                << "point " << point.to_string() << " strict " << strict;
+        }
+    }
+
+    for (bool use_avx2: {false, true}) {
+        for (bool strict: {false, true}) {
+            std::vector<uint8_t> output;
+            contains_batch(shape, points, output, strict, use_avx2);
+            ASSERT_EQ(output.size(), points.size());
+            for (ElementPos point_pos = 0;
+                    point_pos < (ElementPos)points.size();
+                    ++point_pos) {
+                EXPECT_EQ((bool)output[point_pos], shape.contains(points[point_pos], strict))
+                    << "point " << points[point_pos].to_string()
+                    << " strict " << strict
+                    << " use_avx2 " << use_avx2;
+            }
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+        Shape,
+        PointLocatorTest,
+        testing::ValuesIn(contains_test_cases()),
+        contains_test_case_name);
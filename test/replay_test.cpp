@@ -0,0 +1,79 @@
+#include "shape/replay.hpp"
+
+#include "shape/boolean_operations.hpp"
+
+#include <gtest/gtest.h>
+
+#include <boost/filesystem.hpp>
+
+namespace fs = boost::filesystem;
+
+using namespace shape;
+
+
+struct ReplayTestParams
+{
+    std::string file_path;
+    ReplayOperation expected_operation;
+};
+
+void PrintTo(const ReplayTestParams& params, std::ostream* os)
+{
+    *os << "file_path " << params.file_path << "\n";
+    *os << "expected_operation " << replay_operation2str(params.expected_operation) << "\n";
+}
+
+class ReplayTest: public testing::TestWithParam<ReplayTestParams> { };
+
+TEST_P(ReplayTest, Replay)
+{
+    ReplayTestParams test_params = GetParam();
+    PrintTo(test_params, &std::cout);
+
+    Counter number_of_calls = 0;
+    ReplayParameters parameters;
+    parameters.number_of_runs = 5;
+    parameters.number_of_allocations = [&number_of_calls]() { return number_of_calls++; };
+    ReplayOutput output = replay(test_params.file_path, parameters);
+
+    EXPECT_EQ(output.operation, test_params.expected_operation);
+    ASSERT_EQ(output.times.size(), 5);
+    EXPECT_LE(output.minimum_time, output.median_time);
+    EXPECT_LE(output.median_time, output.p99_time);
+    EXPECT_EQ(output.minimum_number_of_allocations, 1);
+    EXPECT_EQ(output.maximum_number_of_allocations, 1);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+        Shape,
+        ReplayTest,
+        testing::ValuesIn(std::vector<ReplayTestParams>{
+            {
+                (fs::path("data") / "tests" / "rasterization" / "0.json").string(),
+                ReplayOperation::Rasterization,
+            }, {
+                (fs::path("data") / "tests" / "offset" / "inflate_shape" / "0.json").string(),
+                ReplayOperation::InflateShape,
+            }, {
+                (fs::path("data") / "tests" / "shapes_intersections" / "intersect_shape_shape" / "0.json").string(),
+                ReplayOperation::IntersectShapeShape,
+            }, {
+                (fs::path("data") / "tests" / "shape" / "shape_contains" / "0.json").string(),
+                ReplayOperation::ShapeContains,
+            }}));
+
+TEST(ReplayTest, ExportedOperationIsDetected)
+{
+    std::vector<ShapeWithHoles> shapes = {
+        {build_rectangle(0, 2, 0, 2)},
+        {build_rectangle(1, 3, 1, 3)}};
+    fs::path file_path = fs::temp_directory_path() / fs::unique_path("%%%%-%%%%.json");
+
+    compute_intersection_export_inputs(file_path.string(), shapes);
+    EXPECT_EQ(replay(file_path.string()).operation, ReplayOperation::ComputeIntersection);
+
+    compute_union_export_inputs(file_path.string(), shapes);
+    EXPECT_EQ(replay(file_path.string()).operation, ReplayOperation::ComputeUnion);
+
+    fs::remove(file_path);
+}
@@ -0,0 +1,100 @@
+#include "shape/ring.hpp"
+
+#include "contains_test_cases.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace shape;
+
+class RingTest: public testing::TestWithParam<ContainsTestParams> { };
+
+/** Check a ring against the shape it has been built from. */
+void check_ring(const Shape& shape)
+{
+    Ring ring(shape);
+
+    // Conversion.
+    Shape shape_new = ring.to_shape();
+    EXPECT_EQ(shape_new.is_path, shape.is_path);
+    ASSERT_EQ(shape_new.elements.size(), shape.elements.size());
+    ASSERT_EQ(ring.number_of_elements(), (ElementPos)shape.elements.size());
+    for (ElementPos element_pos = 0;
+            element_pos < (ElementPos)shape.elements.size();
+            ++element_pos) {
+        EXPECT_TRUE(shape_new.elements[element_pos] == shape.elements[element_pos]);
+        EXPECT_TRUE(ring.element(element_pos) == shape.elements[element_pos]);
+    }
+    EXPECT_EQ(ring.is_polygon(), shape.is_polygon());
+
+    // Attributes.
+    AxisAlignedBoundingBox aabb = shape.compute_min_max();
+    EXPECT_TRUE(equal(ring.compute_min_max(), aabb));
+    if (shape.is_path)
+        return;
+    EXPECT_EQ(ring.compute_area(), shape.compute_area());
+
+    for (const Point& point: contains_test_points(shape)) {
+        for (bool strict: {false, true}) {
+            EXPECT_EQ(ring.contains(point, strict), shape.contains(point, strict))
+                << "point " << point.to_string() << " strict " << strict;
+        }
+    }
+}
+
+TEST_P(RingTest, Ring)
+{
+    ContainsTestParams test_params = GetParam();
+    PrintTo(test_params, &std::cout);
+    check_ring(test_params.shape);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+        Shape,
+        RingTest,
+        testing::ValuesIn(contains_test_cases()),
+        contains_test_case_name);
+
+TEST(RingTest, Path)
+{
+    check_ring(build_shape({{0, 0}, {2, 0}, {2, 2}, {3, 2, -1}, {4, 2}}, true));
+}
+
+TEST(RingTest, EmptyShape)
+{
+    Ring ring(Shape{});
+    EXPECT_EQ(ring.number_of_elements(), 0);
+    EXPECT_TRUE(ring.to_shape().elements.empty());
+    EXPECT_FALSE(ring.contains({0, 0}));
+}
+
+TEST(RingTest, DisconnectedShape)
+{
+    Shape shape = build_square(1);
+    shape.elements[1].start = {2, 0};
+    EXPECT_THROW(Ring ring(shape), std::invalid_argument);
+}
+
+TEST(RingTest, SnappedEnds)
+{
+    Shape shape = build_square(1);
+    shape.elements[0].end = {1 + 1e-7, 0};
+    Ring ring(shape);
+    EXPECT_TRUE(ring.element(0).end == shape.elements[1].start);
+    EXPECT_TRUE(ring.to_shape().elements[0].end == shape.elements[1].start);
+}
+
+TEST(RingTest, RingWithHoles)
+{
+    ShapeWithHoles shape;
+    shape.shape = build_square(10);
+    shape.holes.push_back(build_shape({{2, 2}, {2, 8}, {5, 8, -1}, {8, 8}, {8, 2}}));
+    RingWithHoles ring(shape);
+    EXPECT_TRUE(ring.to_shape_with_holes() == shape);
+    EXPECT_EQ(ring.compute_area(), shape.compute_area());
+    for (const Point& point: std::vector<Point>{{1, 1}, {5, 5}, {2, 5}, {5, 11}, {0, 0}}) {
+        for (bool strict: {false, true}) {
+            EXPECT_EQ(ring.contains(point, strict), shape.contains(point, strict))
+                << "point " << point.to_string() << " strict " << strict;
+        }
+    }
+}
@@ -1208,3 +1208,44 @@ INSTANTIATE_TEST_SUITE_P(
         [](const testing::TestParamInfo<ShapeComputeMinMaxTest::ParamType>& info) {
             return std::to_string(info.index);
         });
+
+TEST(CachedShapeTest, CachedShape)
+{
+    Shape shape = build_shape({{0, 0}, {4, 0}, {4, 2}, {2, 2, 1}, {0, 2}});
+    CachedShape cached_shape(shape);
+    for (Counter k = 0; k < 3; ++k) {
+        const Shape& current_shape = cached_shape.shape();
+        AxisAlignedBoundingBox aabb = current_shape.compute_min_max();
+        EXPECT_TRUE(equal(cached_shape.min_max(), aabb));
+        EXPECT_TRUE(equal(cached_shape.area(), current_shape.compute_area()));
+        EXPECT_EQ(cached_shape.is_polygon(), current_shape.is_polygon());
+        EXPECT_EQ(cached_shape.is_convex(), current_shape.is_convex());
+        EXPECT_TRUE(current_shape.contains(cached_shape.point_strictly_inside(), true));
+        if (k == 0) {
+            cached_shape.shift(10, -5);
+        } else {
+            cached_shape = cached_shape.rotate(30);
+        }
+    }
+}
+
+TEST(CachedShapeTest, CachedShapeWithHoles)
+{
+    ShapeWithHoles shape;
+    shape.shape = build_square(10);
+    shape.holes.push_back(build_shape({{2, 2}, {2, 8}, {8, 8}, {8, 2}}));
+    CachedShapeWithHoles cached_shape(shape);
+    for (Counter k = 0; k < 3; ++k) {
+        const ShapeWithHoles& current_shape = cached_shape.shape();
+        AxisAlignedBoundingBox aabb = current_shape.compute_min_max();
+        EXPECT_TRUE(equal(cached_shape.min_max(), aabb));
+        EXPECT_TRUE(equal(cached_shape.area(), current_shape.compute_area()));
+        EXPECT_EQ(cached_shape.is_polygon(), current_shape.is_polygon());
+        EXPECT_TRUE(current_shape.contains(cached_shape.point_strictly_inside(), true));
+        if (k == 0) {
+            cached_shape.shift(10, -5);
+        } else {
+            cached_shape = cached_shape.rotate(30);
+        }
+    }
+}
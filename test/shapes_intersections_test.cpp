@@ -11,12 +11,59 @@
 #include <boost/filesystem.hpp>
 
 #include <fstream>
+#include <random>
 
 //#include "test_params.hpp"
 
 using namespace shape;
 namespace fs = boost::filesystem;
 
+namespace
+{
+
+/**
+ * Split each line segment of a shape into a given number of parts.
+ *
+ * The shape covers the same region, but has many more elements, so that the
+ * intersection checks filter the pairs of elements with their bounding
+ * boxes.
+ */
+Shape subdivide(
+        const Shape& shape,
+        ElementPos number_of_parts)
+{
+    Shape output = shape;
+    output.elements.clear();
+    for (const ShapeElement& element: shape.elements) {
+        if (element.type != ShapeElementType::LineSegment) {
+            output.elements.push_back(element);
+            continue;
+        }
+        Point start = element.start;
+        for (ElementPos part_pos = 1; part_pos <= number_of_parts; ++part_pos) {
+            Point end = (part_pos == number_of_parts)?
+                element.end:
+                element.start + ((double)part_pos / number_of_parts) * (element.end - element.start);
+            output.elements.push_back(build_line_segment(start, end));
+            start = end;
+        }
+    }
+    return output;
+}
+
+ShapeWithHoles subdivide(
+        const ShapeWithHoles& shape_with_holes,
+        ElementPos number_of_parts)
+{
+    ShapeWithHoles output;
+    output.shape = subdivide(shape_with_holes.shape, number_of_parts);
+    for (const Shape& hole: shape_with_holes.holes)
+        output.holes.push_back(subdivide(hole, number_of_parts));
+    return output;
+}
+
+}
+
 struct IntersectShapeTestParams
 {
     std::string name;
@@ -64,6 +111,14 @@ TEST_P(IntersectShapeTest, IntersectShape)
     EXPECT_EQ(output, test_params.expected_output);
 }
 
+TEST_P(IntersectShapeTest, IntersectShapeSweep)
+{
+    IntersectShapeTestParams test_params = GetParam();
+    ComputeIntersectingElementsParameters parameters;
+    parameters.algorithm = IntersectingElementsAlgorithm::Sweep;
+    EXPECT_EQ(intersect(test_params.shape, parameters), test_params.expected_output);
+}
+
 INSTANTIATE_TEST_SUITE_P(
         Shape,
         IntersectShapeTest,
@@ -212,6 +267,14 @@ INSTANTIATE_TEST_SUITE_P(
                 build_line_segment({1, 1}, {1, 3}),
                 false,
                 false,
+            }, {
+                // The segment crosses a zero-width spike without reaching the
+                // interior of the shape.
+                "SegmentCrossingSpikeStrict",
+                build_shape({{0, 0}, {4, 0}, {4, 1}, {2, 1}, {2, 3}, {2, 1}, {0, 1}}),
+                build_line_segment({1, 2}, {3, 2}),
+                true,
+                false,
             },
         }),
         [](const testing::TestParamInfo<IntersectShapeShapeElementTest::ParamType>& info) {
@@ -496,6 +559,24 @@ TEST_P(IntersectShapeShapeTest, IntersectShapeShape)
     EXPECT_EQ(output, test_params.expected_output);
 }
 
+TEST_P(IntersectShapeShapeTest, IntersectShapeShapeSubdivided)
+{
+    IntersectShapeShapeTestParams test_params = GetParam();
+    Shape shape_1 = subdivide(test_params.shape_1, 100);
+    Shape shape_2 = subdivide(test_params.shape_2, 100);
+    bool output = intersect(shape_1, shape_2, test_params.strict);
+    EXPECT_EQ(output, test_params.expected_output);
+}
+
+TEST_P(IntersectShapeShapeTest, IntersectCachedShapeCachedShape)
+{
+    IntersectShapeShapeTestParams test_params = GetParam();
+    CachedShape shape_1(test_params.shape_1);
+    CachedShape shape_2(test_params.shape_2);
+    bool output = intersect(shape_1, shape_2, test_params.strict);
+    EXPECT_EQ(output, test_params.expected_output);
+}
+
 INSTANTIATE_TEST_SUITE_P(
         Shape,
         IntersectShapeShapeTest,
@@ -540,6 +621,12 @@ INSTANTIATE_TEST_SUITE_P(
             IntersectShapeShapeTestParams::read_json(
                     (fs::path("data") / "tests" / "shapes_intersections" / "intersect_shape_shape" / "0.json").string()),
             {
+                "SquareCrossingSpikeStrict",
+                build_shape({{1.5, 1.5}, {3.5, 1.5}, {3.5, 2.5}, {1.5, 2.5}}),
+                build_shape({{0, 0}, {4, 0}, {4, 1}, {2, 1}, {2, 3}, {2, 1}, {0, 1}}),
+                true,
+                false,
+            }, {
                 "ArrowShapesMeetAtTip",
                 build_shape({{4, 0}, {0, 0}, {0, 2}, {1, 2}, {2, 3}, {3, 2}, {4, 2}}),
                 build_shape({{0, 2}, {0, 4}, {4, 4}, {4, 2}, {3, 2}, {2, 1}, {1, 2}}),
@@ -625,6 +712,27 @@ TEST_P(IntersectShapeWithHolesShapeTest, IntersectShapeWithHolesShape)
     EXPECT_EQ(output, test_params.expected_output);
 }
 
+TEST_P(IntersectShapeWithHolesShapeTest, IntersectShapeWithHolesShapeSubdivided)
+{
+    IntersectShapeWithHolesShapeTestParams test_params = GetParam();
+    ShapeWithHoles shape_with_holes = subdivide(test_params.shape_with_holes, 100);
+    Shape shape = subdivide(test_params.shape, 100);
+    bool output = intersect(shape_with_holes, shape, test_params.strict);
+    EXPECT_EQ(output, test_params.expected_output);
+    if (!test_params.strict) {
+        EXPECT_EQ(intersect(test_params.shape_with_holes, shape, false), test_params.expected_output);
+    }
+}
+
+TEST_P(IntersectShapeWithHolesShapeTest, IntersectCachedShapeWithHolesCachedShape)
+{
+    IntersectShapeWithHolesShapeTestParams test_params = GetParam();
+    CachedShapeWithHoles shape_with_holes(test_params.shape_with_holes);
+    CachedShape shape(test_params.shape);
+    bool output = intersect(shape_with_holes, shape, test_params.strict);
+    EXPECT_EQ(output, test_params.expected_output);
+}
+
 INSTANTIATE_TEST_SUITE_P(
         Shape,
         IntersectShapeWithHolesShapeTest,
@@ -759,6 +867,15 @@ TEST_P(IntersectShapeWithHolesShapeWithHolesTest, IntersectShapeWithHolesShapeWi
     EXPECT_EQ(output, test_params.expected_output);
 }
 
+TEST_P(IntersectShapeWithHolesShapeWithHolesTest, IntersectCachedShapeWithHolesCachedShapeWithHoles)
+{
+    IntersectShapeWithHolesShapeWithHolesTestParams test_params = GetParam();
+    CachedShapeWithHoles shape_with_holes_1(test_params.shape_with_holes_1);
+    CachedShapeWithHoles shape_with_holes_2(test_params.shape_with_holes_2);
+    bool output = intersect(shape_with_holes_1, shape_with_holes_2, test_params.strict);
+    EXPECT_EQ(output, test_params.expected_output);
+}
+
 INSTANTIATE_TEST_SUITE_P(
         Shape,
         IntersectShapeWithHolesShapeWithHolesTest,
@@ -777,3 +894,73 @@ INSTANTIATE_TEST_SUITE_P(
         [](const testing::TestParamInfo<IntersectShapeWithHolesShapeWithHolesTest::ParamType>& info) {
             return info.param.name;
         });
+
+TEST(ComputeIntersectingElementsTest, Sweep)
+{
+    // Random short elements and a few long ones spanning the whole area.
+    std::mt19937_64 generator(0);
+    std::uniform_real_distribution<LengthDbl> distribution_position(0, 100);
+    std::uniform_real_distribution<Angle> distribution_angle(0, 2 * M_PI);
+    std::vector<ShapeElement> elements;
+    for (ElementPos element_pos = 0; element_pos < 2000; ++element_pos) {
+        Point point = {distribution_position(generator), distribution_position(generator)};
+        Angle angle = distribution_angle(generator);
+        if (element_pos % 500 == 0) {
+            elements.push_back(build_line_segment({0, point.y}, {100, 100 - point.y}));
+        } else if (element_pos % 2 == 0) {
+            elements.push_back(build_line_segment(
+                        point,
+                        {point.x + 5 * std::cos(angle), point.y + 5 * std::sin(angle)}));
+        } else {
+            Angle angle_end = angle + distribution_angle(generator) / 2;
+            elements.push_back(build_circular_arc(
+                        {point.x + 2 * std::cos(angle), point.y + 2 * std::sin(angle)},
+                        {point.x + 2 * std::cos(angle_end), point.y + 2 * std::sin(angle_end)},
+                        point,
+                        ShapeElementOrientation::Anticlockwise));
+        }
+    }
+
+    ComputeIntersectingElementsParameters parameters;
+    parameters.algorithm = IntersectingElementsAlgorithm::Sweep;
+    for (bool strict: {false, true}) {
+        std::vector<ElementElementIntersection> expected_output
+            = compute_intersecting_elements(elements, strict);
+        std::vector<ElementElementIntersection> output
+            = compute_intersecting_elements(elements, strict, parameters);
+        ASSERT_EQ(output.size(), expected_output.size());
+        for (ElementPos pos = 0; pos < (ElementPos)output.size(); ++pos) {
+            EXPECT_EQ(output[pos].element_id_1, expected_output[pos].element_id_1);
+            EXPECT_EQ(output[pos].element_id_2, expected_output[pos].element_id_2);
+            EXPECT_EQ(
+                    output[pos].intersections.proper_intersections.size(),
+                    expected_output[pos].intersections.proper_intersections.size());
+        }
+    }
+}
+
+TEST(ComputeIntersectingElementsTest, SweepLongElements)
+{
+    // Outline of a bin, whose long edges cross the sweep line during the
+    // whole sweep, and small elements inside, some of them touching it.
+    std::vector<ShapeElement> elements = build_rectangle(0, 100, 0, 10).elements;
+    for (ElementPos pos = 0; pos < 1000; ++pos) {
+        LengthDbl x = 0.1 * pos;
+        elements.push_back(build_line_segment({x, 0}, {x + 0.05, 1}));
+        elements.push_back(build_line_segment({x, 5}, {x + 0.15, 6}));
+    }
+
+    ComputeIntersectingElementsParameters parameters;
+    parameters.algorithm = IntersectingElementsAlgorithm::Sweep;
+    for (bool strict: {false, true}) {
+        std::vector<ElementElementIntersection> expected_output
+            = compute_intersecting_elements(elements, strict);
+        std::vector<ElementElementIntersection> output
+            = compute_intersecting_elements(elements, strict, parameters);
+        ASSERT_EQ(output.size(), expected_output.size());
+        for (ElementPos pos = 0; pos < (ElementPos)output.size(); ++pos) {
+            EXPECT_EQ(output[pos].element_id_1, expected_output[pos].element_id_1);
+            EXPECT_EQ(output[pos].element_id_2, expected_output[pos].element_id_2);
+        }
+    }
+}